@@ -153,14 +153,14 @@ uint8_t onewire_reset(void)
         // generating any code for the write (!)
     DIRECT_WRITE_LOW(reg, mask);
     sei();
-    delayMicroseconds(500);
+    delayUs(500);
     cli();
     DIRECT_MODE_INPUT(reg, mask);   // allow it to float
     delayMicroseconds(80);
     r = !DIRECT_READ(reg, mask);
     LED_YELLOW_TOGGLE();
     sei();
-    delayMicroseconds(420);
+    delayUs(420);
     return r;
 }
 
@@ -0,0 +1,71 @@
+/** example_pwm_sequence app:
+
+This app shows how to use pwmSequenceStart() from pwm.h to make an LED fade
+in and out smoothly with no CPU load.
+
+Connect an LED (with a resistor) from P0_3 to GND.  The app starts Timer 1
+at 32 Hz and gives the DMA a table of 64 duty cycles, one per PWM period, so
+the LED fades in for one second and out for one second, over and over.  The
+main loop does not touch the PWM output at all after it starts the sequence.
+
+The duty cycles go up with the square of time, because the eye is more
+sensitive to changes in brightness when an LED is dim.
+
+The yellow LED is on while the sequence is running.
+*/
+
+#include <wixel.h>
+#include <usb.h>
+#include <usb_com.h>
+#include <pwm.h>
+
+#define PWM_PIN          3    // P0_3, Timer 1 channel 1.
+#define PWM_FREQUENCY    32   // Hz: each duty cycle in the sequence lasts 1/32 s.
+#define SEQUENCE_LENGTH  64   // Half of the sequence fades in, half fades out.
+
+// Timer 1 sequences are 16-bit duty cycles, and the DMA reads them from XDATA.
+uint16 XDATA sequence[SEQUENCE_LENGTH];
+
+void fillSequence(uint16 resolution)
+{
+    uint8 i;
+    uint16 step;
+
+    for (i = 0; i < SEQUENCE_LENGTH / 2; i++)
+    {
+        // duty = resolution * (i / 32)^2, computed in two steps so the
+        // intermediate values fit in 32 bits.
+        step = (uint32)resolution * i / (SEQUENCE_LENGTH / 2);
+        sequence[i] = (uint32)step * i / (SEQUENCE_LENGTH / 2);
+        sequence[SEQUENCE_LENGTH - 1 - i] = sequence[i];
+    }
+}
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+
+    LED_YELLOW(pwmSequenceRunning());
+
+    LED_RED(0);
+}
+
+void main()
+{
+    uint16 resolution;
+
+    systemInit();
+    usbInit();
+
+    resolution = pwmStart(1, PWM_FREQUENCY);
+    fillSequence(resolution);
+    pwmEnable(1, PWM_PIN);
+    pwmSequenceStart(PWM_PIN, sequence, SEQUENCE_LENGTH, 1);
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbComService();
+    }
+}
@@ -0,0 +1 @@
+APP_LIBS := wixel.lib dma.lib pwm.lib usb_cdc_acm.lib usb.lib
@@ -0,0 +1,64 @@
+/** example_usb_cdc_hid app:
+
+This example app shows how to use the usb_cdc_hid library, which makes the
+Wixel appear as a virtual COM port and a HID keyboard, mouse, and joystick
+at the same time.
+
+Every byte received on the virtual COM port is echoed back to the computer.
+In addition, the characters 'h', 'j', 'k', and 'l' move the mouse cursor
+left, down, up, and right by 10 pixels.
+
+The yellow LED shows whether Caps Lock is turned on.  This might not work if
+the USB host is a Linux or Mac OS machine.
+*/
+
+#include <wixel.h>
+#include <usb.h>
+#include <usb_cdc_hid.h>
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+    LED_YELLOW(usbHidKeyboardOutput.leds & (1 << LED_CAPS_LOCK));
+}
+
+void comService()
+{
+    uint8 byte;
+
+    // Wait until the last mouse movement has been sent before starting another.
+    if (usbHidMouseInputUpdated || !usbComRxAvailable() || !usbComTxAvailable())
+    {
+        return;
+    }
+
+    byte = usbComRxReceiveByte();
+    usbComTxSendByte(byte);
+
+    usbHidMouseInput.x = 0;
+    usbHidMouseInput.y = 0;
+    switch(byte)
+    {
+    case 'h': usbHidMouseInput.x = -10; break;
+    case 'j': usbHidMouseInput.y = 10; break;
+    case 'k': usbHidMouseInput.y = -10; break;
+    case 'l': usbHidMouseInput.x = 10; break;
+    default: return;
+    }
+    usbHidMouseInputUpdated = 1;
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbComService();
+        usbHidService();
+        comService();
+    }
+}
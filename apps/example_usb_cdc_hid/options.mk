@@ -0,0 +1 @@
+APP_LIBS := usb.lib usb_composite.lib usb_cdc_hid.lib wixel.lib
@@ -6,6 +6,26 @@ I/O lines using two or more Wixels.
 For complete documentation and a precompiled version of this app, see the
 "I/O Repeater App" section of the Pololu Wixel User's Guide:
 http://www.pololu.com/docs/0J46
+
+A Wixel with input pins sends a radio packet as soon as one of its inputs
+changes, and a keep-alive packet about every KEEPALIVE_INTERVAL_MS
+milliseconds so that receivers recover from lost packets.  Each packet holds
+the states of all of the Wixel's input pins as a bitmap, the link of each
+input pin, and a sequence number that lets receivers ignore packets older
+than ones they have already applied.  This packet format is not compatible
+with earlier versions of this app, so all of the Wixels must run the same
+version.
+
+A Wixel with output pins reports on its virtual COM port, once per second,
+how long the Wixels spent processing each input change that changed one of
+its output pins, for example:
+  delay: n=12 avg=1875 max=3210 us
+This is the time from the input change until the packet was queued on the
+sending Wixel, plus the time from when the packet was read from the radio
+queue until the output changed on the receiving Wixel.  It does not include
+the time the packet spent waiting in the radio queues and on the air, so it
+is a lower bound on the latency from the input to the output, not a
+measurement of it.
 */
 
 /** Dependencies **************************************************************/
@@ -17,7 +37,8 @@ http://www.pololu.com/docs/0J46
 #include <time.h>
 #include <gpio.h>
 #include <radio_queue.h>
-#include <adc.h>
+#include <pin_change.h>
+#include <stdio.h>
 
 #define PIN_COUNT 15
 static uint8 CODE pins[PIN_COUNT] = {0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 16, 17, 21};
@@ -26,24 +47,63 @@ static uint8 CODE pins[PIN_COUNT] = {0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 1
 #define IS_INPUT(pin)  (pinLink(pin) < 0)
 #define IS_OUTPUT(pin) (pinLink(pin) > 0)
 
-// list and count of input pins
-static uint8 XDATA inPins[PIN_COUNT];
+// pin number and link of each input pin, and the count of input pins
+static uint8 XDATA inPinNumber[PIN_COUNT];
+static uint8 XDATA inPinLink[PIN_COUNT];
 static uint8 inPinCount = 0;
 
-// list and count of output pins
-static uint8 XDATA outPins[PIN_COUNT];
+// port (0-2), bit mask, and link of each output pin, and the count of output pins
+static uint8 XDATA outPinPort[PIN_COUNT];
+static uint8 XDATA outPinMask[PIN_COUNT];
+static uint8 XDATA outPinLink[PIN_COUNT];
 static uint8 outPinCount = 0;
 
+// sequence number of the last packet applied to each output pin, and when
+static uint8 XDATA outPinSequence[PIN_COUNT];
+static uint32 XDATA outPinUpdateMs[PIN_COUNT];
+
 // only tx if we have at least one input; only rx if we have at least one output
 static BIT txEnabled = 0;
 static BIT rxEnabled = 0;
 
-// In each byte of a buffer:
-// bit 7 = pin value
-// bits 6:0 = pin link
-#define PIN_LINK_OFFSET 0
-#define PIN_LINK_MASK 0x7F
-#define PIN_VAL_OFFSET 7
+// Packet format (after the radio_queue length byte):
+//   byte 0:   sequence number
+//   byte 1:   time since the first input change in the packet, in units of 100 us,
+//             or AGE_UNKNOWN for a keep-alive packet
+//   byte 2-3: bitmap of input pin states; bit N is the state of input pin N
+//   byte 4+N: link of input pin N
+//
+// The links are sent in every packet, not just in keep-alives, because
+// several Wixels can send on the same channel and the packets do not say
+// which Wixel sent them, so a receiver could not tell which link list a
+// packet without links belongs to.  It also lets a receiver apply the first
+// change it hears instead of waiting for a keep-alive.  The cost is one byte
+// (about 23 us of air time at 350 kbps) per input pin.
+#define PACKET_SEQUENCE_OFFSET 0
+#define PACKET_AGE_OFFSET      1
+#define PACKET_STATES_OFFSET   2
+#define PACKET_LINKS_OFFSET    4
+#define AGE_UNKNOWN            0xFF
+
+STATIC_ASSERT(packetSize, PACKET_LINKS_OFFSET + PIN_COUNT <= RADIO_QUEUE_PAYLOAD_SIZE)
+
+// Time between keep-alive packets (plus up to 15 ms of random jitter, so that
+// transmitting Wixels don't get synchronized with each other).
+#define KEEPALIVE_INTERVAL_MS 100
+
+// If an output pin has not been updated for this long, accept any sequence
+// number for it (the sending Wixel might have been reset).
+#define RESYNC_TIMEOUT_MS (3 * KEEPALIVE_INTERVAL_MS)
+
+// state of the transmitter
+static BIT changePending = 0;  // an input changed since the last packet
+static uint32 changeUs;        // when the first unsent change happened
+static uint8 txSequence = 0;
+
+// processing delay statistics, reported once per second
+static uint16 delayCount = 0;
+static uint32 delaySumUs = 0;
+static uint16 delayMaxUs = 0;
 
 /** Parameters ****************************************************************/
 int32 CODE param_P0_0_link = -1;
@@ -103,6 +163,9 @@ void configurePins(void)
     setPort1PullType(HIGH);
     // Port 2 is pulled low and should remain pulled low; pulling it high would cause problems.
 
+    // Repeat input changes as fast as possible, without debouncing them.
+    pinChangeDebounceMs = 0;
+
     for(pin = 0; pin < PIN_COUNT; pin++)
     {
         tmp = pins[pin];
@@ -112,58 +175,225 @@ void configurePins(void)
             // This pin is configured as an output, so add it to the list of output pins.
             // The default state of the output pins, as documented in the user's guide, is LOW.
             setDigitalOutput(tmp, LOW);
-            outPins[outPinCount++] = tmp;
+            outPinPort[outPinCount] = tmp / 10;
+            outPinMask[outPinCount] = 1 << (tmp % 10);
+            outPinLink[outPinCount] = pinLink(tmp);
+            outPinUpdateMs[outPinCount] = getMs() - RESYNC_TIMEOUT_MS;
+            outPinCount++;
             rxEnabled = 1;
         }
         else if (IS_INPUT(tmp))
         {
             // This pin is configured as an input, so add it to the list of input pins.
             // The pin is already an input because all pins are inputs by default.
-            inPins[inPinCount++] = tmp;
+            // pin_change.lib watches pins on ports 0 and 1; P2_1 is polled.
+            inPinNumber[inPinCount] = tmp;
+            inPinLink[inPinCount] = -pinLink(tmp);
+            inPinCount++;
             txEnabled = 1;
+            pinChangeEnable(tmp, PIN_CHANGE_BOTH);
+        }
+    }
+}
+
+// record that an input changed at the specified time
+void noteChange(uint32 us)
+{
+    if (!changePending)
+    {
+        changePending = 1;
+        changeUs = us;
+    }
+}
+
+// called by pinChangeService() when an input pin on port 0 or 1 changes
+void inputChanged(PIN_CHANGE_EVENT XDATA * event)
+{
+    noteChange(event->timeUs);
+}
+
+// get the state of an input pin (the pin_change.lib state for ports 0 and 1,
+// so that the state we send matches the changes we have been told about)
+BIT inputState(uint8 pin)
+{
+    return pin < 20 ? pinChangeLevel(pin) : isPinHigh(pin);
+}
+
+// detect changes on input pins that pin_change.lib cannot watch
+void pollInputs(void)
+{
+    static uint16 XDATA polledStates = 0;
+    uint8 pin;
+
+    for (pin = 0; pin < inPinCount; pin++)
+    {
+        if (inPinNumber[pin] >= 20 && isPinHigh(inPinNumber[pin]) != ((polledStates >> pin) & 1))
+        {
+            polledStates ^= (uint16)1 << pin;
+            noteChange(getUs());
         }
     }
 }
 
-// read the states of input pins on this Wixel into a buffer
-void readPins(uint8 XDATA * buf)
+// put the states of our input pins in a packet and queue it for transmission
+// returns 0 if the TX queue is full
+BIT sendPins(void)
 {
+    uint8 XDATA * txBuf = radioQueueTxCurrentPacket();
+    uint16 states = 0;
+    uint32 age;
     uint8 pin;
 
+    if (txBuf == 0)
+    {
+        return 0;
+    }
+
     for (pin = 0; pin < inPinCount; pin++)
     {
-        // put pin link in lower 7 bits, read pin state and put in highest bit
-        buf[pin] = (-pinLink(inPins[pin]) << PIN_LINK_OFFSET) | (isPinHigh(inPins[pin]) << PIN_VAL_OFFSET);
+        if (inputState(inPinNumber[pin]))
+        {
+            states |= (uint16)1 << pin;
+        }
+        txBuf[1 + PACKET_LINKS_OFFSET + pin] = inPinLink[pin];
+    }
+
+    age = AGE_UNKNOWN;
+    if (changePending)
+    {
+        age = (getUs() - changeUs) / 100;
+        if (age >= AGE_UNKNOWN)
+        {
+            age = AGE_UNKNOWN - 1;
+        }
+        changePending = 0;
     }
+
+    txBuf[0] = PACKET_LINKS_OFFSET + inPinCount; // set packet length byte
+    txBuf[1 + PACKET_SEQUENCE_OFFSET] = txSequence++;
+    txBuf[1 + PACKET_AGE_OFFSET] = age;
+    txBuf[1 + PACKET_STATES_OFFSET] = states & 0xFF;
+    txBuf[1 + PACKET_STATES_OFFSET + 1] = states >> 8;
+    radioQueueTxSendPacket();
+    return 1;
 }
 
-// set the states of output pins on this Wixel based on values from a buffer
-void setPins(uint8 XDATA * buf, uint8 byteCount)
+// set the states of output pins on this Wixel based on a packet from another Wixel
+void receivePins(uint8 XDATA * rxBuf, uint32 rxUs)
 {
-    uint8 byte, pin;
+    uint8 XDATA * payload = rxBuf + 1;
+    uint8 portMask[3];
+    uint8 portValue[3];
+    uint8 changed;
+    uint8 linkCount, sequence, link, pin, port;
+    uint16 states;
+    uint32 now = getMs();
+    uint32 delay;
+
+    if (rxBuf[0] < PACKET_LINKS_OFFSET)
+    {
+        return;
+    }
+    linkCount = rxBuf[0] - PACKET_LINKS_OFFSET;
+    sequence = payload[PACKET_SEQUENCE_OFFSET];
+    states = payload[PACKET_STATES_OFFSET] | (payload[PACKET_STATES_OFFSET + 1] << 8);
 
-    // loop over all bytes in packet
-    for (byte = 0; byte < byteCount; byte++)
+    for (port = 0; port < 3; port++)
     {
-        for (pin = 0; pin < outPinCount; pin++)
+        portMask[port] = 0;
+        portValue[port] = 0;
+    }
+
+    for (pin = 0; pin < outPinCount; pin++)
+    {
+        // ignore this packet for this pin if we already applied a newer one
+        if ((int8)(sequence - outPinSequence[pin]) <= 0 &&
+            (uint32)(now - outPinUpdateMs[pin]) < RESYNC_TIMEOUT_MS)
         {
-            // check if this output pin's link matches the link in this packet
-            if ((uint8)pinLink(outPins[pin]) == ((buf[byte] >> PIN_LINK_OFFSET) & PIN_LINK_MASK))
+            continue;
+        }
+
+        for (link = 0; link < linkCount; link++)
+        {
+            // check if this output pin's link matches the link of this input
+            if (outPinLink[pin] == payload[PACKET_LINKS_OFFSET + link])
             {
-                // if so, set the pin state based on the val bit
-                setDigitalOutput(outPins[pin], (buf[byte] >> PIN_VAL_OFFSET) & 1);
+                // if so, record the pin state based on the state bit
+                port = outPinPort[pin];
+                portMask[port] |= outPinMask[pin];
+                if ((states >> link) & 1)
+                {
+                    portValue[port] |= outPinMask[pin];
+                }
+                else
+                {
+                    portValue[port] &= ~outPinMask[pin];
+                }
+                outPinSequence[pin] = sequence;
+                outPinUpdateMs[pin] = now;
             }
         }
     }
+
+    // update all the output pins on each port at once
+    changed = (GPIO_PORT_READ(0, portMask[0]) ^ portValue[0]) |
+        (GPIO_PORT_READ(1, portMask[1]) ^ portValue[1]) |
+        (GPIO_PORT_READ(2, portMask[2]) ^ portValue[2]);
+    GPIO_PORT_WRITE(0, portMask[0], portValue[0]);
+    GPIO_PORT_WRITE(1, portMask[1], portValue[1]);
+    GPIO_PORT_WRITE(2, portMask[2], portValue[2]);
+
+    // measure the processing delay on both Wixels (not the time on the air)
+    if (changed && payload[PACKET_AGE_OFFSET] != AGE_UNKNOWN)
+    {
+        delay = (uint32)payload[PACKET_AGE_OFFSET] * 100 + (getUs() - rxUs);
+        if (delay > 0xFFFF)
+        {
+            delay = 0xFFFF;
+        }
+        if (delayCount < 0xFFFF)
+        {
+            delayCount++;
+            delaySumUs += delay;
+        }
+        if (delay > delayMaxUs)
+        {
+            delayMaxUs = delay;
+        }
+    }
+}
+
+// report the processing delay statistics on the virtual COM port once per second
+void reportDelay(void)
+{
+    static uint32 lastReport = 0;
+    uint8 XDATA report[48];
+    uint8 reportLength;
+
+    if ((uint32)(getMs() - lastReport) < 1000)
+    {
+        return;
+    }
+    lastReport = getMs();
+
+    if (delayCount && usbComTxAvailable() >= sizeof(report))
+    {
+        reportLength = sprintf(report, "delay: n=%u avg=%u max=%u us\r\n",
+                delayCount, (uint16)(delaySumUs / delayCount), delayMaxUs);
+        usbComTxSend(report, reportLength);
+    }
+
+    delayCount = 0;
+    delaySumUs = 0;
+    delayMaxUs = 0;
 }
 
 void main(void)
 {
-    // pointers to link packets
-    uint8 XDATA * txBuf;
+    // pointer to received packet
     uint8 XDATA * rxBuf;
 
-    uint8 lastTx = 0;
+    uint16 lastTx = 0;
     uint8 txInterval = 0;
 
     systemInit();
@@ -171,6 +401,7 @@ void main(void)
 
     radioQueueInit();
 
+    pinChangeHandler = inputChanged;
     configurePins();
 
     while(1)
@@ -178,27 +409,31 @@ void main(void)
         updateLeds();
         boardService();
         usbComService();
+        pinChangeService();
 
         // receive pin states from another Wixel and set our output pins
-        if (rxEnabled && (rxBuf = radioQueueRxCurrentPacket()))
+        if (rxEnabled)
         {
-            setPins(rxBuf + 1, *rxBuf);
-            radioQueueRxDoneWithPacket();
+            while ((rxBuf = radioQueueRxCurrentPacket()) != 0)
+            {
+                receivePins(rxBuf, getUs());
+                radioQueueRxDoneWithPacket();
+            }
+            reportDelay();
         }
 
-        // read our input pins and transmit pin states to other Wixel(s) every MAX_TX_INTERVAL milliseconds
-        if (txEnabled && (uint8)(getMs() - lastTx) > txInterval && (txBuf = radioQueueTxCurrentPacket()))
+        // send our input pin states to other Wixel(s) when they change, and periodically
+        if (txEnabled)
         {
-            readPins(txBuf + 1);
-            *txBuf = inPinCount; // set packet length byte
-            radioQueueTxSendPacket();
-
-            lastTx = getMs();
-            
-            // Decide when to send the next packet.  We take a noisy reading of the temperature sensor
-            // to get two random bits, so that we can avoid accidentally getting synchronized with another
-            // transmitting Wixel.
-            txInterval = 7 + (adcRead(14 | ADC_BITS_7) & 3);
+            pollInputs();
+
+            if ((changePending || (uint16)(getMs() - lastTx) > txInterval) && sendPins())
+            {
+                lastTx = getMs();
+
+                // Decide when to send the next keep-alive packet.
+                txInterval = KEEPALIVE_INTERVAL_MS + (randomNumber() & 15);
+            }
         }
     }
 }
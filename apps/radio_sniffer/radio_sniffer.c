@@ -55,6 +55,11 @@ radio_channel: See description in radio_link.h.
 #include <string.h>
 #include <ctype.h>
 
+/** Variables *****************************************************************/
+
+// Lets us queue up a few packets' worth of text while the USB host is busy.
+static uint8 XDATA usbTxBuffer[512];
+
 /** Functions *****************************************************************/
 void updateLeds()
 {
@@ -162,6 +167,8 @@ void main()
 {
     systemInit();
     usbInit();
+    usbComTxBufferInit(usbTxBuffer, sizeof(usbTxBuffer));
+    usbComTxSetLatency(4);  // Combine the bytes from putchar into full packets when possible.
 
     radioQueueInit();
     radioQueueAllowCrcErrors = 1;
@@ -0,0 +1 @@
+APP_LIBS := dma.lib packet_pool.lib radio_mac.lib radio_queue_external_rx.lib radio_registers.lib random.lib uart.lib usb.lib usb_cdc_acm.lib wixel.lib
@@ -0,0 +1,223 @@
+/** radio_usb_bridge app:
+
+This app forwards the radio packets it receives to the USB virtual COM port
+and to UART1 at the same time, and sends the bytes it receives from the
+virtual COM port over the radio.
+
+
+== Description ==
+
+A Wixel running this app appears to the USB host as a Virtual COM Port,
+with USB product ID 0x2200.  It uses the radio_queue library, so it can talk
+to other Wixels running apps that use radio_queue on the same channel.
+
+The payload of every radio packet received is written to the virtual COM
+port (if a terminal program has it open) and to UART1 (TX on P1_6).  The
+packets are not copied on their way to the outputs: the radio receives
+directly into buffers from packet_pool.h, and the two outputs share each
+buffer by reference counting, so a slow output only holds on to the
+buffers it has not sent yet.  If both outputs fall behind and the pool runs
+out of buffers, the packets wait in the radio queue until a buffer is
+released.
+
+Bytes received from the virtual COM port are sent over the radio in
+packets of up to 19 bytes.
+
+The yellow LED is on while there are received packets waiting to be sent
+to an output.
+
+
+== Parameters ==
+
+baud_rate: The baud rate to use for UART1, in bits per second.
+radio_channel: See description in radio_link.h.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+
+#include <usb.h>
+#include <usb_com.h>
+
+#include <radio_queue.h>
+#include <packet_pool.h>
+#include <ring.h>
+
+#include <uart1.h>
+
+/** Parameters ****************************************************************/
+int32 CODE param_baud_rate = 9600;
+
+/** Global Variables **********************************************************/
+
+// The radio needs one buffer for each RX slot of radio_queue, and each packet
+// waiting in the output queues needs one more.
+#define POOL_BLOCKS  16
+static uint8 XDATA poolStorage[PACKET_POOL_STORAGE_SIZE(POOL_BLOCKS)];
+
+// Handles of the received packets waiting to be sent to each output.  Both
+// queues hold the same packets, so their sizes should be the same.
+#define OUTPUT_QUEUE_SIZE  8
+RING_SIZE_CHECK(outputQueue, OUTPUT_QUEUE_SIZE)
+
+static uint8 XDATA usbQueue[OUTPUT_QUEUE_SIZE];
+static uint8 DATA usbHead = 0, usbTail = 0;
+
+static uint8 XDATA uartQueue[OUTPUT_QUEUE_SIZE];
+static uint8 DATA uartHead = 0, uartTail = 0;
+
+/** Functions *****************************************************************/
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+
+    LED_YELLOW(!RING_IS_EMPTY(usbHead, usbTail) || !RING_IS_EMPTY(uartHead, uartTail));
+
+    LED_RED(0);
+}
+
+// Gives the radio pool buffers to receive into, so that every packet it
+// receives is already in the pool.
+void radioBuffersInit()
+{
+    uint8 i;
+    for (i = 0; i < radioQueueRxBufferCount(); i++)
+    {
+        radioQueueRxSetBuffer(i, packetPoolBuffer(packetPoolAlloc()));
+    }
+}
+
+// Takes a received packet from the radio queue and gives it to both outputs.
+void radioRxService()
+{
+    uint8 handle;
+    uint8 XDATA * packet;
+
+    if (radioQueueRxCurrentPacket() == 0 ||
+        RING_IS_FULL(usbHead, usbTail, OUTPUT_QUEUE_SIZE) ||
+        RING_IS_FULL(uartHead, uartTail, OUTPUT_QUEUE_SIZE))
+    {
+        return;
+    }
+
+    // The radio queue needs a new buffer in place of the one we take.
+    handle = packetPoolAlloc();
+    if (handle == PACKET_POOL_NONE)
+    {
+        return;
+    }
+
+    packet = radioQueueRxTakePacket(packetPoolBuffer(handle));
+    handle = packetPoolHandle(packet);
+
+    // One reference for each output.
+    packetPoolRetain(handle);
+
+    usbQueue[usbHead] = handle;
+    usbHead = RING_NEXT(usbHead, OUTPUT_QUEUE_SIZE);
+
+    uartQueue[uartHead] = handle;
+    uartHead = RING_NEXT(uartHead, OUTPUT_QUEUE_SIZE);
+}
+
+void usbTxService()
+{
+    uint8 handle;
+    uint8 XDATA * packet;
+
+    if (RING_IS_EMPTY(usbHead, usbTail))
+    {
+        return;
+    }
+
+    handle = usbQueue[usbTail];
+    packet = packetPoolBuffer(handle);
+
+    if (!(usbComRxControlSignals() & ACM_CONTROL_LINE_DTR))
+    {
+        // No terminal has the port open, so drop the packet instead of
+        // keeping its buffer from the radio.
+    }
+    else if (usbComTxAvailable() >= packet[0])
+    {
+        usbComTxSend(packet + 1, packet[0]);
+    }
+    else
+    {
+        return;
+    }
+
+    usbTail = RING_NEXT(usbTail, OUTPUT_QUEUE_SIZE);
+    packetPoolRelease(handle);
+}
+
+void uartTxService()
+{
+    uint8 handle;
+    uint8 XDATA * packet;
+
+    if (RING_IS_EMPTY(uartHead, uartTail))
+    {
+        return;
+    }
+
+    handle = uartQueue[uartTail];
+    packet = packetPoolBuffer(handle);
+
+    if (uart1TxAvailable() >= packet[0])
+    {
+        uart1TxSend(packet + 1, packet[0]);
+        uartTail = RING_NEXT(uartTail, OUTPUT_QUEUE_SIZE);
+        packetPoolRelease(handle);
+    }
+}
+
+void radioTxService()
+{
+    uint8 XDATA * packet;
+    uint8 length = usbComRxAvailable();
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    packet = radioQueueTxCurrentPacket();
+    if (packet == 0)
+    {
+        return;
+    }
+
+    if (length > RADIO_QUEUE_PAYLOAD_SIZE)
+    {
+        length = RADIO_QUEUE_PAYLOAD_SIZE;
+    }
+    usbComRxReceive(packet + 1, length);
+    packet[0] = length;
+    radioQueueTxSendPacket();
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+
+    uart1Init();
+    uart1SetBaudRate(param_baud_rate);
+
+    packetPoolInit(poolStorage, POOL_BLOCKS);
+    radioBuffersInit();
+    radioQueueInit();
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbComService();
+
+        radioRxService();
+        usbTxService();
+        uartTxService();
+        radioTxService();
+    }
+}
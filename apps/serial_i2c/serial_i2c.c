@@ -260,6 +260,11 @@ void main(void)
     systemInit();
     usbInit();
 
+    // The I2C functions can block for up to I2C_timeout_ms while a slave
+    // stretches the clock, so let the USB interrupt answer the computer's
+    // control requests in the meantime.
+    usbEnableInterrupt();
+
     i2cPinScl = param_I2C_SCL_pin;
     i2cPinSda = param_I2C_SDA_pin;
 
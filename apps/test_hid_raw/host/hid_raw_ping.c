@@ -0,0 +1,161 @@
+/* hid_raw_ping: A host-side program for the test_hid_raw app.
+ *
+ * This program runs on the computer, not on the Wixel.  It sends output
+ * reports to the Wixel's raw HID interface (see usb_hid_raw.h) through the
+ * Linux hidraw driver, waits for each report to be echoed back, and prints
+ * statistics about the round trip times.  No special driver is needed.
+ *
+ * To build it:
+ *
+ *   cc -O2 -o hid_raw_ping hid_raw_ping.c
+ *
+ * Usage:
+ *
+ *   ./hid_raw_ping [COUNT [DEVICE]]
+ *
+ * COUNT is the number of reports to send (default 1000).  DEVICE is the
+ * hidraw device file, for example /dev/hidraw3.  If it is not specified, the
+ * program finds the first Wixel with product ID 0x2204.  You might need to
+ * run the program as root or add a udev rule that gives you access to the
+ * device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/time.h>
+
+#define VENDOR_ID        0x1FFB
+#define PRODUCT_ID       0x2204
+#define REPORT_SIZE      64
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Finds the first hidraw device with our vendor and product ID by reading
+// the HID_ID line of its uevent file in sysfs.
+static int findDevice(char * path, size_t size)
+{
+    DIR * dir = opendir("/sys/class/hidraw");
+    struct dirent * entry;
+    char expected[64];
+    int found = 0;
+
+    if (dir == NULL) { return 0; }
+
+    snprintf(expected, sizeof(expected), "HID_ID=0003:%08X:%08X", VENDOR_ID, PRODUCT_ID);
+
+    while (!found && (entry = readdir(dir)) != NULL)
+    {
+        char ueventPath[512], line[256];
+        FILE * file;
+
+        if (entry->d_name[0] == '.') { continue; }
+
+        snprintf(ueventPath, sizeof(ueventPath), "/sys/class/hidraw/%s/device/uevent", entry->d_name);
+        file = fopen(ueventPath, "r");
+        if (file == NULL) { continue; }
+
+        while (fgets(line, sizeof(line), file))
+        {
+            if (strncmp(line, expected, strlen(expected)) == 0)
+            {
+                // Only accept the device if its whole path fits.
+                int length = snprintf(path, size, "/dev/%s", entry->d_name);
+                found = length > 0 && (size_t)length < size;
+                break;
+            }
+        }
+        fclose(file);
+    }
+
+    closedir(dir);
+    return found;
+}
+
+int main(int argc, char ** argv)
+{
+    char path[256];
+    unsigned count = 1000, i, errors = 0;
+    double min = 1e9, max = 0, total = 0;
+    int fd;
+
+    if (argc > 1) { count = strtoul(argv[1], NULL, 0); }
+
+    if (argc > 2)
+    {
+        snprintf(path, sizeof(path), "%s", argv[2]);
+    }
+    else if (!findDevice(path, sizeof(path)))
+    {
+        fprintf(stderr, "No Wixel with product ID %04x was found.\n", PRODUCT_ID);
+        return 1;
+    }
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        // The first byte written to a hidraw device is the report ID,
+        // which is 0 because the report descriptor does not use report IDs.
+        unsigned char out[REPORT_SIZE + 1], in[REPORT_SIZE];
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        double start, elapsed;
+        int j;
+
+        out[0] = 0;
+        for (j = 0; j < REPORT_SIZE; j++) { out[j + 1] = (unsigned char)(i + j); }
+
+        start = now();
+        if (write(fd, out, sizeof(out)) != sizeof(out))
+        {
+            perror("write");
+            return 1;
+        }
+
+        if (poll(&pfd, 1, 1000) <= 0)
+        {
+            fprintf(stderr, "Timeout waiting for report %u.\n", i);
+            return 1;
+        }
+        if (read(fd, in, sizeof(in)) != sizeof(in))
+        {
+            perror("read");
+            return 1;
+        }
+        elapsed = now() - start;
+
+        // The Wixel replaces the last byte with its queue length.
+        if (memcmp(in, out + 1, REPORT_SIZE - 1) != 0) { errors++; }
+
+        total += elapsed;
+        if (elapsed < min) { min = elapsed; }
+        if (elapsed > max) { max = elapsed; }
+    }
+
+    if (count == 0)
+    {
+        printf("0 reports\n");
+    }
+    else
+    {
+        printf("%u reports, %u errors, round trip min/avg/max = %.3f/%.3f/%.3f ms\n",
+            count, errors, min * 1000, total / count * 1000, max * 1000);
+    }
+
+    close(fd);
+    return errors ? 2 : 0;
+}
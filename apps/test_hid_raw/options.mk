@@ -0,0 +1 @@
+APP_LIBS := usb.lib usb_hid_raw.lib wixel.lib
@@ -0,0 +1,76 @@
+/** test_hid_raw app:
+
+This app tests the latency of the usb_hid_raw library, which implements a
+USB HID interface with vendor-defined 64-byte input and output reports.
+
+Every output report that the app receives from the computer is sent back
+to the computer as an input report, unchanged except for byte 63, which is
+set to the number of input reports that were already queued when the
+report arrived.  The round trip time of a report is therefore the latency
+of a simple command and response.
+
+The apps/test_hid_raw/host directory contains a program for Linux that
+sends reports through /dev/hidraw and reports the round trip times.
+
+== LEDs ==
+
+The green LED shows the USB status, as usual.
+The yellow LED toggles every 128 reports.
+The red LED is on while the input report queue is full.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+#include <usb.h>
+#include <usb_hid_raw.h>
+
+/** Global Variables **********************************************************/
+
+static uint8 XDATA reportCount = 0;
+static BIT queueFull = 0;
+
+/** Functions *****************************************************************/
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+    LED_YELLOW(reportCount & 0x80);
+    LED_RED(queueFull);
+}
+
+void reportReceived(uint8 XDATA * report)
+{
+    uint8 XDATA * response = usbHidRawTxCurrentReport();
+    uint8 i;
+
+    if (response == 0)
+    {
+        // The computer is sending reports faster than it reads them.
+        queueFull = 1;
+        return;
+    }
+    queueFull = 0;
+
+    for (i = 0; i < USB_HID_RAW_REPORT_SIZE - 1; i++)
+    {
+        response[i] = report[i];
+    }
+    response[USB_HID_RAW_REPORT_SIZE - 1] = usbHidRawTxQueued();
+    usbHidRawTxSendReport();
+
+    reportCount++;
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    usbHidRawRxReportHandler = reportReceived;
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbHidRawService();
+    }
+}
@@ -0,0 +1,326 @@
+/* usb_bulk_test: A host-side program for the test_usb_bulk app.
+ *
+ * This program runs on the computer, not on the Wixel.  It talks to the
+ * Wixel's vendor-specific bulk interface (see usb_bulk.h) directly through
+ * the Linux usbfs interface (/dev/bus/usb), so it does not need libusb or a
+ * kernel driver.  It keeps several large transfers queued at all times so
+ * that the USB host controller never has to wait for this program, and it
+ * prints the throughput once per second.
+ *
+ * To build it:
+ *
+ *   cc -O2 -o usb_bulk_test usb_bulk_test.c
+ *
+ * Usage:
+ *
+ *   ./usb_bulk_test read [DEVICE]   Reads packets from the Wixel and checks
+ *                                   their counters and contents.
+ *   ./usb_bulk_test write [DEVICE]  Sends packets with counters to the Wixel.
+ *   ./usb_bulk_test boot [DEVICE]   Makes the Wixel start its bootloader.
+ *
+ * DEVICE is the usbfs device file, for example /dev/bus/usb/002/005.  If it
+ * is not specified, the program finds the first Wixel with product ID 0x2202.
+ * You might need to run the program as root or add a udev rule that gives
+ * you access to the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <linux/usbdevice_fs.h>
+
+#define VENDOR_ID        0x1FFB
+#define PRODUCT_ID       0x2202
+#define INTERFACE_NUMBER 0
+#define ENDPOINT_IN      0x84
+#define ENDPOINT_OUT     0x04
+#define PACKET_SIZE      64
+
+#define REQUEST_START_BOOTLOADER 0xFF
+
+// 8 transfers of 16 KB each: enough for the 16 ms or so that Linux might
+// take to get around to reaping a transfer.
+#define TRANSFER_COUNT   8
+#define TRANSFER_SIZE    (256 * PACKET_SIZE)
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static unsigned readSysfsHex(const char * dir, const char * name)
+{
+    char path[512];
+    unsigned value = 0;
+    FILE * file;
+
+    snprintf(path, sizeof(path), "/sys/bus/usb/devices/%s/%s", dir, name);
+    file = fopen(path, "r");
+    if (file)
+    {
+        if (fscanf(file, "%x", &value) != 1) { value = 0; }
+        fclose(file);
+    }
+    return value;
+}
+
+static unsigned readSysfsDecimal(const char * dir, const char * name)
+{
+    char path[512];
+    unsigned value = 0;
+    FILE * file;
+
+    snprintf(path, sizeof(path), "/sys/bus/usb/devices/%s/%s", dir, name);
+    file = fopen(path, "r");
+    if (file)
+    {
+        if (fscanf(file, "%u", &value) != 1) { value = 0; }
+        fclose(file);
+    }
+    return value;
+}
+
+// Finds the usbfs device file of the first Wixel running the test_usb_bulk app.
+// Returns 0 on success.
+static int findDevice(char * path, size_t size)
+{
+    DIR * dir = opendir("/sys/bus/usb/devices");
+    struct dirent * entry;
+    int result = -1;
+
+    if (!dir)
+    {
+        return -1;
+    }
+
+    while ((entry = readdir(dir)))
+    {
+        if (entry->d_name[0] == '.' || strchr(entry->d_name, ':'))
+        {
+            // Skip interfaces; we are looking for devices.
+            continue;
+        }
+
+        if (readSysfsHex(entry->d_name, "idVendor") == VENDOR_ID &&
+            readSysfsHex(entry->d_name, "idProduct") == PRODUCT_ID)
+        {
+            snprintf(path, size, "/dev/bus/usb/%03u/%03u",
+                readSysfsDecimal(entry->d_name, "busnum"),
+                readSysfsDecimal(entry->d_name, "devnum"));
+            result = 0;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return result;
+}
+
+static uint32_t readUint32(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeUint32(uint8_t * p, uint32_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+static int startBootloader(int fd)
+{
+    struct usbdevfs_ctrltransfer control;
+
+    memset(&control, 0, sizeof(control));
+    control.bRequestType = 0x40;   // Direction=OUT, Type=Vendor, Recipient=Device
+    control.bRequest = REQUEST_START_BOOTLOADER;
+    control.timeout = 1000;
+
+    if (ioctl(fd, USBDEVFS_CONTROL, &control) < 0)
+    {
+        perror("USBDEVFS_CONTROL");
+        return 1;
+    }
+    return 0;
+}
+
+// Streams data in one direction until an error happens.
+static int stream(int fd, int reading)
+{
+    static struct usbdevfs_urb urbs[TRANSFER_COUNT];
+    static uint8_t buffers[TRANSFER_COUNT][TRANSFER_SIZE];
+    uint32_t counter = 0;
+    int synced = 0;
+    unsigned long bytes = 0, counterErrors = 0, dataErrors = 0;
+    double start;
+    int i;
+
+    for (i = 0; i < TRANSFER_COUNT; i++)
+    {
+        struct usbdevfs_urb * urb = &urbs[i];
+        memset(urb, 0, sizeof(*urb));
+        urb->type = USBDEVFS_URB_TYPE_BULK;
+        urb->endpoint = reading ? ENDPOINT_IN : ENDPOINT_OUT;
+        urb->buffer = buffers[i];
+        urb->buffer_length = TRANSFER_SIZE;
+
+        if (!reading)
+        {
+            int p;
+            for (p = 0; p < TRANSFER_SIZE; p += PACKET_SIZE)
+            {
+                int j;
+                writeUint32(buffers[i] + p, counter++);
+                for (j = 4; j < PACKET_SIZE; j++) { buffers[i][p + j] = j; }
+            }
+        }
+
+        if (ioctl(fd, USBDEVFS_SUBMITURB, urb) < 0)
+        {
+            perror("USBDEVFS_SUBMITURB");
+            return 1;
+        }
+    }
+
+    start = now();
+
+    while (1)
+    {
+        struct usbdevfs_urb * urb;
+        uint8_t * buffer;
+        double elapsed;
+        int p;
+
+        if (ioctl(fd, USBDEVFS_REAPURB, &urb) < 0)
+        {
+            perror("USBDEVFS_REAPURB");
+            return 1;
+        }
+        if (urb->status)
+        {
+            fprintf(stderr, "Transfer failed: %s\n", strerror(-urb->status));
+            return 1;
+        }
+
+        buffer = urb->buffer;
+        bytes += urb->actual_length;
+
+        for (p = 0; p < TRANSFER_SIZE; p += PACKET_SIZE)
+        {
+            if (reading)
+            {
+                int j;
+
+                if (p + PACKET_SIZE > urb->actual_length) { break; }
+
+                // The Wixel fills its IN buffers before we start reading,
+                // so the first counter we see can be anything.
+                if (synced && readUint32(buffer + p) != counter) { counterErrors++; }
+                counter = readUint32(buffer + p) + 1;
+                synced = 1;
+
+                for (j = 4; j < PACKET_SIZE; j++)
+                {
+                    if (buffer[p + j] != j) { dataErrors++; break; }
+                }
+            }
+            else
+            {
+                writeUint32(buffer + p, counter++);
+            }
+        }
+
+        if (ioctl(fd, USBDEVFS_SUBMITURB, urb) < 0)
+        {
+            perror("USBDEVFS_SUBMITURB");
+            return 1;
+        }
+
+        elapsed = now() - start;
+        if (elapsed >= 1.0)
+        {
+            printf("%8.1f KB/s", bytes / elapsed / 1000);
+            if (reading)
+            {
+                printf("  counter errors: %lu  data errors: %lu", counterErrors, dataErrors);
+            }
+            printf("\n");
+            fflush(stdout);
+
+            bytes = 0;
+            start = now();
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    char path[64];
+    const char * command;
+    unsigned int interfaceNumber = INTERFACE_NUMBER;
+    int fd, result;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s read|write|boot [DEVICE]\n", argv[0]);
+        return 2;
+    }
+    command = argv[1];
+
+    if (argc > 2)
+    {
+        snprintf(path, sizeof(path), "%s", argv[2]);
+    }
+    else if (findDevice(path, sizeof(path)))
+    {
+        fprintf(stderr, "No Wixel with product ID 0x%04X was found.\n", PRODUCT_ID);
+        return 1;
+    }
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &interfaceNumber) < 0)
+    {
+        perror("USBDEVFS_CLAIMINTERFACE");
+        close(fd);
+        return 1;
+    }
+
+    if (strcmp(command, "read") == 0)
+    {
+        result = stream(fd, 1);
+    }
+    else if (strcmp(command, "write") == 0)
+    {
+        result = stream(fd, 0);
+    }
+    else if (strcmp(command, "boot") == 0)
+    {
+        result = startBootloader(fd);
+    }
+    else
+    {
+        fprintf(stderr, "Unknown command: %s\n", command);
+        result = 2;
+    }
+
+    ioctl(fd, USBDEVFS_RELEASEINTERFACE, &interfaceNumber);
+    close(fd);
+    return result;
+}
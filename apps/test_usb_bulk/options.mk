@@ -0,0 +1 @@
+APP_LIBS := usb.lib usb_bulk.lib dma.lib wixel.lib
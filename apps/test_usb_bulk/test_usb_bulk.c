@@ -0,0 +1,127 @@
+/** test_usb_bulk app:
+
+This app tests the throughput of the usb_bulk library, which implements a
+vendor-specific USB interface with a pair of bulk endpoints.
+
+The app sends packets to the computer on the bulk IN endpoint as fast as
+the computer reads them.  Each packet is 64 bytes long: bytes 0-3 are a
+packet counter (little-endian) that increases by one for every packet, and
+bytes 4-63 have the values 4 through 63.
+
+The app also receives packets from the computer on the bulk OUT endpoint.
+It expects the first four bytes of each packet to be a packet counter in the
+same format, and it counts the packets that do not have the expected value.
+A packet with a counter of 0 starts a new test.
+
+The apps/test_usb_bulk/host directory contains a program for Linux that
+reads or writes these packets and reports the throughput.
+
+== LEDs ==
+
+The green LED shows the USB status, as usual.
+The yellow LED toggles every 1024 packets sent or received.
+The red LED is on for 100 ms after a packet with the wrong counter is
+received.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+#include <usb.h>
+#include <usb_bulk.h>
+
+/** Global Variables **********************************************************/
+
+// Two packets to send.  Only the counters change.
+static uint8 XDATA txPackets[2 * USB_BULK_PACKET_SIZE];
+static uint32 XDATA txPacketCount = 0;
+
+static uint8 XDATA rxPacket[USB_BULK_PACKET_SIZE];
+static uint32 XDATA rxExpectedCount = 0;
+static uint32 XDATA rxErrorCount = 0;
+
+// The lower 8 bits of getMs() when the last error happened.
+static uint8 XDATA rxErrorTime;
+static BIT rxErrorRecent = 0;
+
+static BIT yellowLed = 0;
+
+/** Functions *****************************************************************/
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+    LED_YELLOW(yellowLed);
+
+    if (rxErrorRecent && (uint8)((uint8)getMs() - rxErrorTime) > 100)
+    {
+        rxErrorRecent = 0;
+    }
+    LED_RED(rxErrorRecent);
+}
+
+void txPacketsInit()
+{
+    uint8 i;
+    for (i = 0; i < USB_BULK_PACKET_SIZE; i++)
+    {
+        txPackets[i] = txPackets[USB_BULK_PACKET_SIZE + i] = i;
+    }
+}
+
+void bulkTxService()
+{
+    uint8 size = usbBulkTxAvailable();
+    if (size)
+    {
+        *(uint32 XDATA *)&txPackets[0] = txPacketCount++;
+        if (size > USB_BULK_PACKET_SIZE)
+        {
+            *(uint32 XDATA *)&txPackets[USB_BULK_PACKET_SIZE] = txPacketCount++;
+        }
+        usbBulkTxSend(txPackets, size);
+
+        if (((uint16)txPacketCount & 1023) < (size >> 6))
+        {
+            yellowLed ^= 1;
+        }
+    }
+}
+
+void bulkRxService()
+{
+    uint32 count;
+
+    if (usbBulkRxReceive(rxPacket) >= 4)
+    {
+        count = *(uint32 XDATA *)&rxPacket[0];
+        // A counter of 0 means the computer started a new test.
+        if (count != rxExpectedCount && count != 0)
+        {
+            rxErrorCount++;
+            rxErrorTime = (uint8)getMs();
+            rxErrorRecent = 1;
+        }
+        rxExpectedCount = count + 1;
+
+        if (((uint16)rxExpectedCount & 1023) == 0)
+        {
+            yellowLed ^= 1;
+        }
+    }
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    txPacketsInit();
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbBulkService();
+        bulkTxService();
+        bulkRxService();
+    }
+}
@@ -0,0 +1,158 @@
+/* adc_stream_reader: A host-side program for the usb_adc_stream app.
+ *
+ * This program runs on the computer, not on the Wixel.  It opens the Wixel's
+ * virtual COM port, reads the binary frames sent by the usb_adc_stream app,
+ * checks their sequence numbers, and prints the achieved sample rate, the
+ * number of lost frames, and the number of samples that the Wixel reported
+ * dropping once per second.
+ *
+ * It uses only POSIX APIs, so it works on Linux and Mac OS X.  To build it:
+ *
+ *   cc -O2 -o adc_stream_reader adc_stream_reader.c
+ *
+ * Usage:
+ *
+ *   ./adc_stream_reader /dev/ttyACM0
+ *
+ * Specify -v as a second argument to also print the first sample of every
+ * channel once per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/time.h>
+
+#define FRAME_HEADER_SIZE 10
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + 2 * 255)
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static uint16_t readUint16(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+// Reads exactly count bytes.  Returns 0 on success.
+static int readAll(int fd, uint8_t * buffer, size_t count)
+{
+    while (count)
+    {
+        ssize_t n = read(fd, buffer, count);
+        if (n <= 0)
+        {
+            return -1;
+        }
+        buffer += n;
+        count -= n;
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    struct termios options;
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint16_t expectedSequence = 0;
+    int synced = 0, verbose = 0;
+    unsigned long samples = 0, frames = 0, lostFrames = 0, syncErrors = 0;
+    uint16_t dropped = 0;
+    double start;
+    int fd;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s PORT [-v]\n", argv[0]);
+        return 2;
+    }
+    verbose = (argc > 2 && strcmp(argv[2], "-v") == 0);
+
+    fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // Raw mode.  Opening the port asserts DTR, which starts the sampling.
+    tcgetattr(fd, &options);
+    cfmakeraw(&options);
+    options.c_cflag |= CLOCAL | CREAD | HUPCL;
+    tcsetattr(fd, TCSANOW, &options);
+    tcflush(fd, TCIFLUSH);
+
+    start = now();
+
+    while (1)
+    {
+        uint8_t channelCount, sampleCount;
+        uint16_t sequence;
+        double elapsed;
+
+        // Find the sync bytes.
+        if (readAll(fd, frame, 1)) break;
+        if (frame[0] != 0xA5) { syncErrors += synced; synced = 0; continue; }
+        if (readAll(fd, frame + 1, 1)) break;
+        if (frame[1] != 0x5A) { syncErrors += synced; synced = 0; continue; }
+
+        if (readAll(fd, frame + 2, FRAME_HEADER_SIZE - 2)) break;
+        sequence = readUint16(frame + 2);
+        channelCount = frame[4];
+        sampleCount = frame[5];
+        dropped = readUint16(frame + 6);
+
+        if (channelCount == 0 || channelCount > 6 || sampleCount % channelCount)
+        {
+            // Not a real frame header; keep looking.
+            syncErrors++;
+            synced = 0;
+            continue;
+        }
+
+        if (readAll(fd, frame + FRAME_HEADER_SIZE, 2 * sampleCount)) break;
+
+        if (synced && sequence != expectedSequence)
+        {
+            lostFrames += (uint16_t)(sequence - expectedSequence);
+        }
+        synced = 1;
+        expectedSequence = sequence + 1;
+
+        frames++;
+        samples += sampleCount;
+
+        elapsed = now() - start;
+        if (elapsed >= 1.0)
+        {
+            printf("%8.0f samples/s  %6.1f frames/s  lost frames: %lu  dropped samples: %u  sync errors: %lu\n",
+                samples / elapsed, frames / elapsed, lostFrames, dropped, syncErrors);
+
+            if (verbose)
+            {
+                int i;
+                for (i = 0; i < channelCount; i++)
+                {
+                    printf("  AIN%d = %4u", i, readUint16(frame + FRAME_HEADER_SIZE + 2 * i));
+                }
+                printf("\n");
+            }
+            fflush(stdout);
+
+            samples = frames = 0;
+            start = now();
+        }
+    }
+
+    fprintf(stderr, "Error reading from %s.\n", argv[1]);
+    close(fd);
+    return 1;
+}
@@ -0,0 +1 @@
+APP_LIBS := usb.lib usb_cdc_acm.lib wixel.lib adc.lib dma.lib
@@ -0,0 +1,235 @@
+/** usb_adc_stream app:
+
+This app continuously samples one or more of the Wixel's analog inputs
+(P0_0 through P0_5) at a precise rate and streams the readings to the
+computer over USB as compact binary frames.  It can be used as a simple
+oscilloscope or data-acquisition device.
+
+Sampling starts when a program on the computer opens the Wixel's virtual
+COM port (asserts DTR) and stops when the port is closed.
+The yellow LED is on while sampling.
+
+The samples are taken by Timer 1 and DMA (see adc_stream.h), so the sample
+timing does not depend on USB traffic.  The main loop converts each block of
+samples into a frame while the previous frame is being sent to the USB
+endpoint (double buffering).
+
+== Frame format ==
+
+All multi-byte values are little-endian.
+
+Byte 0-1: Sync bytes: 0xA5, 0x5A.
+Byte 2-3: Frame sequence number.  Increases by one for every frame sent.
+Byte 4:   Channel count (C).
+Byte 5:   Sample count (N).  This is a multiple of C.
+Byte 6-7: Total number of samples dropped by the ADC stream because the
+          USB link could not keep up (since sampling started).
+Byte 8-9: Reserved (0).
+Byte 10-: N samples, each two bytes, with values from 0 to 2047.
+          The samples are interleaved: AIN0, AIN1, ..., AIN(C-1), AIN0, ...
+
+The apps/usb_adc_stream/host directory contains a small program that reads
+these frames and reports the achieved sample rate.
+
+== Parameters ==
+
+channel_count: The number of channels to sample, from 1 to 6.
+  The channels sampled are P0_0 through P0_(channel_count-1).
+
+sequence_rate: The number of times per second to sample all the channels,
+  from 3 to 65535.
+
+input_mode: Same as in the wireless_adc_tx app: 0 disables the pull-up and
+  pull-down resistors on Port 0, 1 enables pull-ups, -1 enables pull-downs.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+#include <usb.h>
+#include <usb_com.h>
+#include <adc_stream.h>
+
+/** Parameters ****************************************************************/
+
+int32 CODE param_channel_count = 1;
+
+int32 CODE param_sequence_rate = 2000;
+
+int32 CODE param_input_mode = 0;
+
+/** Global Variables **********************************************************/
+
+#define FRAME_HEADER_SIZE  10
+#define FRAME_MAX_SIZE     (FRAME_HEADER_SIZE + 2 * ADC_STREAM_MAX_BLOCK_SIZE)
+
+// Two frame buffers: one is being filled from the ADC stream while the
+// other one is being sent to USB.
+static uint8 XDATA frames[2][FRAME_MAX_SIZE];
+
+// The length of each frame, or 0 if the frame buffer is empty.
+static uint8 frameLength[2] = {0, 0};
+
+static uint8 fillIndex = 0;    // The frame buffer that will be filled next.
+static uint8 sendIndex = 0;    // The frame buffer that is being sent.
+static uint8 sendOffset = 0;   // The number of bytes of that frame already sent.
+
+static uint16 frameSequenceNumber = 0;
+
+// The number of channels being sampled: param_channel_count limited to 1-6.
+static uint8 channelCount = 1;
+
+static BIT streaming = 0;
+
+/** Functions *****************************************************************/
+
+void analogInputsInit()
+{
+    switch(param_input_mode)
+    {
+    case 1: // Enable pull-up resistors for all pins on Port 0.
+        P2INP &= ~(1<<5);  // PDUP0 = 0: Pull-ups on Port 0.
+        P0INP = 0;
+        break;
+
+    case -1: // Enable pull-down resistors for all pins on Port 0.
+        P2INP |= (1<<5);   // PDUP0 = 1: Pull-downs on Port 0.
+        P0INP = 0;
+        break;
+
+    default: // Disable pull-ups and pull-downs for all pins on Port 0.
+        P0INP = 0x3F;
+        break;
+    }
+}
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+    LED_YELLOW(streaming);
+    LED_RED(0);
+}
+
+// Starts or stops sampling depending on whether the COM port is open.
+void streamControlService()
+{
+    BIT portOpen = (usbComRxControlSignals() & ACM_CONTROL_LINE_DTR) ? 1 : 0;
+    uint16 sequenceRate;
+
+    if (portOpen && !streaming)
+    {
+        frameLength[0] = frameLength[1] = 0;
+        fillIndex = sendIndex = sendOffset = 0;
+        frameSequenceNumber = 0;
+
+        // Limit the parameters to the ranges supported by adcStreamStart().
+        if (param_channel_count < 1){ channelCount = 1; }
+        else if (param_channel_count > 6){ channelCount = 6; }
+        else { channelCount = param_channel_count; }
+
+        if (param_sequence_rate < 3){ sequenceRate = 3; }
+        else if (param_sequence_rate > 0xFFFF){ sequenceRate = 0xFFFF; }
+        else { sequenceRate = param_sequence_rate; }
+
+        adcStreamStart(channelCount, sequenceRate, 0);
+        streaming = 1;
+    }
+    else if (!portOpen && streaming)
+    {
+        adcStreamStop();
+        streaming = 0;
+    }
+}
+
+// Turns the next block of samples (if there is one) into a frame.
+void frameFillService()
+{
+    uint16 XDATA * block;
+    uint8 XDATA * frame;
+    uint16 dropped;
+    uint8 i, sampleCount;
+
+    if (frameLength[fillIndex] != 0 || !(block = adcStreamRxCurrentBlock()))
+    {
+        // Both frame buffers are in use, or there are no new samples.
+        return;
+    }
+
+    frame = frames[fillIndex];
+    sampleCount = adcStreamBlockSize();
+    dropped = adcStreamSamplesDropped();
+
+    frame[0] = 0xA5;
+    frame[1] = 0x5A;
+    frame[2] = (uint8)frameSequenceNumber;
+    frame[3] = (uint8)(frameSequenceNumber >> 8);
+    frame[4] = channelCount;
+    frame[5] = sampleCount;
+    frame[6] = (uint8)dropped;
+    frame[7] = (uint8)(dropped >> 8);
+    frame[8] = 0;
+    frame[9] = 0;
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        uint16 sample = ADC_STREAM_SAMPLE(block[i]);
+        frame[FRAME_HEADER_SIZE + 2*i] = (uint8)sample;
+        frame[FRAME_HEADER_SIZE + 2*i + 1] = (uint8)(sample >> 8);
+    }
+
+    adcStreamRxDoneWithBlock();
+
+    frameSequenceNumber++;
+    frameLength[fillIndex] = FRAME_HEADER_SIZE + 2 * sampleCount;
+    fillIndex ^= 1;
+}
+
+// Sends as much of the current frame to USB as possible.
+void frameSendService()
+{
+    uint8 length = frameLength[sendIndex];
+    uint8 count;
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    count = usbComTxAvailable();
+    if (count > length - sendOffset)
+    {
+        count = length - sendOffset;
+    }
+
+    if (count)
+    {
+        usbComTxSend(frames[sendIndex] + sendOffset, count);
+        sendOffset += count;
+    }
+
+    if (sendOffset == length)
+    {
+        frameLength[sendIndex] = 0;
+        sendOffset = 0;
+        sendIndex ^= 1;
+    }
+}
+
+void main()
+{
+    systemInit();
+    analogInputsInit();
+    usbInit();
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbComService();
+        streamControlService();
+        if (streaming)
+        {
+            frameFillService();
+            frameSendService();
+        }
+    }
+}
@@ -0,0 +1 @@
+APP_LIBS := usb.lib adc.lib dma.lib wixel.lib
\ No newline at end of file
@@ -0,0 +1,426 @@
+/** usb_audio_adc app:
+
+This app makes the Wixel appear to the computer as a USB microphone: a
+USB Audio Class 1.0 input device with one 16-bit channel sampled at
+8000 Hz.  The signal is read from analog input P0_0.  No driver is needed
+on Windows, Mac OS X, or Linux; the Wixel shows up as a recording device
+that any audio program can use.
+
+The samples are taken by Timer 1 and DMA (see adc_stream.h), so the sample
+timing does not depend on USB traffic or on the main loop.  The samples are
+sent on an isochronous endpoint, which has guaranteed bandwidth: the
+computer reads one packet of about 8 samples in every 1 ms USB frame.
+The app starts sampling when the computer selects the streaming alternate
+setting (when an audio program starts recording) and stops when it goes
+back to alternate setting 0.
+
+The ADC converts voltages from 0 V to 3.3 V, so the signal on P0_0 should
+be centered at about 1.65 V.  1.65 V is reported as a sample value of 0.
+
+== LEDs ==
+
+The green LED shows the USB status, as usual.
+The yellow LED is on while the app is streaming.
+The red LED is on for 100 ms after samples are lost because the computer
+did not read them fast enough.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+#include <usb.h>
+#include <adc_stream.h>
+
+/** Audio Configuration *******************************************************/
+
+#define SAMPLE_RATE                 8000
+
+// The number of samples we normally send in each 1 ms frame, and the
+// maximum.  We send an extra sample in some frames if samples are piling up
+// because our clock is a little faster than the computer's.
+#define SAMPLES_PER_FRAME           (SAMPLE_RATE / 1000)
+#define MAX_SAMPLES_PER_PACKET      (SAMPLES_PER_FRAME + 2)
+#define AUDIO_PACKET_SIZE           (MAX_SAMPLES_PER_PACKET * 2)
+
+#define AUDIO_CONTROL_INTERFACE     0
+#define AUDIO_STREAMING_INTERFACE   1
+
+#define AUDIO_ENDPOINT              4
+#define AUDIO_FIFO                  USB_FIFO(AUDIO_ENDPOINT)
+
+// Terminal IDs in the audio function.
+#define INPUT_TERMINAL_ID           1
+#define OUTPUT_TERMINAL_ID          2
+
+/** USB Audio Class Constants *************************************************/
+// From the USB Device Class Definition for Audio Devices 1.0 (audio10.pdf)
+// and the USB Device Class Definition for Audio Data Formats 1.0 (frmts10.pdf).
+
+#define AUDIO_CLASS                         1
+#define AUDIO_SUBCLASS_CONTROL              1
+#define AUDIO_SUBCLASS_STREAMING            2
+
+#define AUDIO_CS_INTERFACE                  0x24
+#define AUDIO_CS_ENDPOINT                   0x25
+
+#define AUDIO_AC_HEADER                     1
+#define AUDIO_AC_INPUT_TERMINAL             2
+#define AUDIO_AC_OUTPUT_TERMINAL            3
+
+#define AUDIO_AS_GENERAL                    1
+#define AUDIO_AS_FORMAT_TYPE                2
+#define AUDIO_EP_GENERAL                    1
+
+#define AUDIO_FORMAT_TYPE_I                 1
+#define AUDIO_FORMAT_PCM                    1
+
+#define AUDIO_TERMINAL_USB_STREAMING        0x0101
+#define AUDIO_TERMINAL_MICROPHONE           0x0201
+
+// bmAttributes of an isochronous endpoint: USB 2.0 Table 9-13.
+#define ENDPOINT_SYNC_ASYNCHRONOUS          (1<<2)
+
+#define AUDIO_LSB(x)  ((uint8)(x))
+#define AUDIO_MSB(x)  ((uint8)((x) >> 8))
+
+/** USB Descriptors ***********************************************************/
+
+USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
+{
+    sizeof(USB_DESCRIPTOR_DEVICE),
+    USB_DESCRIPTOR_TYPE_DEVICE,
+    0x0200,                 // USB Spec Release Number in BCD format
+    0,                      // Class Code: undefined (use class code info from Interface Descriptors)
+    0,                      // Subclass code
+    0,                      // Protocol
+    USB_EP0_PACKET_SIZE,    // Max packet size for Endpoint 0
+    USB_VENDOR_ID_POLOLU,   // Vendor ID
+    0x2205,                 // Product ID (Generic Wixel with a USB Audio input)
+    0x0000,                 // Device release number in BCD format
+    1,                      // Index of Manufacturer String Descriptor
+    2,                      // Index of Product String Descriptor
+    3,                      // Index of Serial Number String Descriptor
+    1                       // Number of possible configurations.
+};
+
+CODE struct CONFIG1 {
+    USB_DESCRIPTOR_CONFIGURATION configuration;
+
+    USB_DESCRIPTOR_INTERFACE control_interface;
+    uint8 control_header[9];           // Class-Specific AC Interface Header Descriptor (audio10 4.3.2)
+    uint8 input_terminal[12];          // Input Terminal Descriptor (audio10 4.3.2.1)
+    uint8 output_terminal[9];          // Output Terminal Descriptor (audio10 4.3.2.2)
+
+    USB_DESCRIPTOR_INTERFACE streaming_interface_off;
+    USB_DESCRIPTOR_INTERFACE streaming_interface_on;
+    uint8 streaming_general[7];        // Class-Specific AS Interface Descriptor (audio10 4.5.2)
+    uint8 streaming_format[11];        // Type I Format Type Descriptor (frmts10 2.2.5)
+    uint8 streaming_endpoint[9];       // Standard AS Isochronous Audio Data Endpoint Descriptor (audio10 4.6.1.1)
+    uint8 streaming_endpoint_cs[7];    // Class-Specific AS Isochronous Audio Data Endpoint Descriptor (audio10 4.6.1.2)
+} usbConfigurationDescriptor
+=
+{
+    {                                                    // Configuration Descriptor
+        sizeof(USB_DESCRIPTOR_CONFIGURATION),
+        USB_DESCRIPTOR_TYPE_CONFIGURATION,
+        sizeof(struct CONFIG1),                          // wTotalLength
+        2,                                               // bNumInterfaces
+        1,                                               // bConfigurationValue
+        0,                                               // iConfiguration
+        0xC0,                                            // bmAttributes: self powered (but may use bus power)
+        50,                                              // bMaxPower
+    },
+    {                                                    // Audio Control Interface
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        AUDIO_CONTROL_INTERFACE,                         // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        0,                                               // bNumEndpoints
+        AUDIO_CLASS,                                     // bInterfaceClass
+        AUDIO_SUBCLASS_CONTROL,                          // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.control_header),
+        AUDIO_CS_INTERFACE,
+        AUDIO_AC_HEADER,
+        0x00, 0x01,                                      // bcdADC.  We conform to Audio 1.0.
+        sizeof(usbConfigurationDescriptor.control_header)
+            + sizeof(usbConfigurationDescriptor.input_terminal)
+            + sizeof(usbConfigurationDescriptor.output_terminal), 0,  // wTotalLength
+        1,                                               // bInCollection: one streaming interface
+        AUDIO_STREAMING_INTERFACE,                       // baInterfaceNr(1)
+    },
+    {
+        sizeof(usbConfigurationDescriptor.input_terminal),
+        AUDIO_CS_INTERFACE,
+        AUDIO_AC_INPUT_TERMINAL,
+        INPUT_TERMINAL_ID,                               // bTerminalID
+        AUDIO_LSB(AUDIO_TERMINAL_MICROPHONE), AUDIO_MSB(AUDIO_TERMINAL_MICROPHONE), // wTerminalType
+        0,                                               // bAssocTerminal
+        1,                                               // bNrChannels
+        0, 0,                                            // wChannelConfig: mono
+        0,                                               // iChannelNames
+        0,                                               // iTerminal
+    },
+    {
+        sizeof(usbConfigurationDescriptor.output_terminal),
+        AUDIO_CS_INTERFACE,
+        AUDIO_AC_OUTPUT_TERMINAL,
+        OUTPUT_TERMINAL_ID,                              // bTerminalID
+        AUDIO_LSB(AUDIO_TERMINAL_USB_STREAMING), AUDIO_MSB(AUDIO_TERMINAL_USB_STREAMING), // wTerminalType
+        0,                                               // bAssocTerminal
+        INPUT_TERMINAL_ID,                               // bSourceID
+        0,                                               // iTerminal
+    },
+    {                                                    // Audio Streaming Interface, Alternate Setting 0: no bandwidth
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        AUDIO_STREAMING_INTERFACE,                       // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        0,                                               // bNumEndpoints
+        AUDIO_CLASS,                                     // bInterfaceClass
+        AUDIO_SUBCLASS_STREAMING,                        // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {                                                    // Audio Streaming Interface, Alternate Setting 1: streaming
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        AUDIO_STREAMING_INTERFACE,                       // bInterfaceNumber
+        1,                                               // bAlternateSetting
+        1,                                               // bNumEndpoints
+        AUDIO_CLASS,                                     // bInterfaceClass
+        AUDIO_SUBCLASS_STREAMING,                        // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.streaming_general),
+        AUDIO_CS_INTERFACE,
+        AUDIO_AS_GENERAL,
+        OUTPUT_TERMINAL_ID,                              // bTerminalLink
+        1,                                               // bDelay: 1 frame
+        AUDIO_FORMAT_PCM, 0,                             // wFormatTag
+    },
+    {
+        sizeof(usbConfigurationDescriptor.streaming_format),
+        AUDIO_CS_INTERFACE,
+        AUDIO_AS_FORMAT_TYPE,
+        AUDIO_FORMAT_TYPE_I,                             // bFormatType
+        1,                                               // bNrChannels
+        2,                                               // bSubframeSize: 2 bytes per sample
+        16,                                              // bBitResolution
+        1,                                               // bSamFreqType: one discrete sample rate
+        AUDIO_LSB(SAMPLE_RATE), AUDIO_MSB(SAMPLE_RATE), 0,          // tSamFreq
+    },
+    {
+        sizeof(usbConfigurationDescriptor.streaming_endpoint),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | AUDIO_ENDPOINT,        // bEndpointAddress
+        USB_TRANSFER_TYPE_ISOCHRONOUS | ENDPOINT_SYNC_ASYNCHRONOUS, // bmAttributes
+        AUDIO_PACKET_SIZE, 0,                            // wMaxPacketSize
+        1,                                               // bInterval: every frame
+        0,                                               // bRefresh
+        0,                                               // bSynchAddress
+    },
+    {
+        sizeof(usbConfigurationDescriptor.streaming_endpoint_cs),
+        AUDIO_CS_ENDPOINT,
+        AUDIO_EP_GENERAL,
+        0,                                               // bmAttributes: no sampling frequency or pitch control
+        0,                                               // bLockDelayUnits
+        0, 0,                                            // wLockDelay
+    },
+};
+
+uint8 CODE usbStringDescriptorCount = 4;
+DEFINE_STRING_DESCRIPTOR(languages, 1, USB_LANGUAGE_EN_US)
+DEFINE_STRING_DESCRIPTOR(manufacturer, 18, 'P','o','l','o','l','u',' ','C','o','r','p','o','r','a','t','i','o','n')
+DEFINE_STRING_DESCRIPTOR(product, 5, 'W','i','x','e','l')
+uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product, serialNumberStringDescriptor };
+
+/** Global Variables **********************************************************/
+
+// Set by the Set Interface handler, which might run in the USB interrupt.
+// The main loop starts and stops the ADC stream to match it.
+static volatile BIT streamingRequested = 0;
+static BIT streaming = 0;
+
+// The block of samples we are sending and our position in it.
+static uint16 XDATA * XDATA block = 0;
+static uint8 XDATA blockIndex;
+
+static uint16 XDATA lastSamplesDropped;
+static uint8 XDATA lastDropTime;
+static BIT dropRecent = 0;
+
+/** USB Callbacks *************************************************************/
+
+void usbCallbackInitEndpoints()
+{
+    usbInitEndpointIsoIn(AUDIO_ENDPOINT, AUDIO_PACKET_SIZE);
+}
+
+void usbCallbackSetupHandler()
+{
+    // We do not support any audio class requests, so they will be stalled.
+}
+
+void usbCallbackClassDescriptorHandler()
+{
+    // The class-specific descriptors are part of the configuration descriptor.
+}
+
+void usbCallbackControlWriteHandler()
+{
+}
+
+uint8 setInterface()
+{
+    switch (usbSetupPacket.wIndex)
+    {
+    case AUDIO_CONTROL_INTERFACE:
+        return usbSetupPacket.wValue == 0;
+
+    case AUDIO_STREAMING_INTERFACE:
+        if (usbSetupPacket.wValue > 1)
+        {
+            return 0;
+        }
+        streamingRequested = usbSetupPacket.wValue;
+        return 1;
+    }
+    return 0;
+}
+
+/** Functions *****************************************************************/
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+    LED_YELLOW(streaming);
+
+    if (dropRecent && (uint8)((uint8)getMs() - lastDropTime) > 100)
+    {
+        dropRecent = 0;
+    }
+    LED_RED(dropRecent);
+}
+
+void startOrStopStreaming()
+{
+    BIT requested = streamingRequested && usbDeviceState == USB_STATE_CONFIGURED;
+
+    if (requested == streaming)
+    {
+        return;
+    }
+
+    if (requested)
+    {
+        adcStreamStart(1, SAMPLE_RATE, ADC_BITS_10);
+        lastSamplesDropped = 0;
+    }
+    else
+    {
+        adcStreamStop();
+    }
+    block = 0;
+    streaming = requested;
+}
+
+// Converts a raw ADC sample to a 16-bit signed PCM sample with 1.65 V as 0.
+int16 pcmFromSample(uint16 raw)
+{
+    if (raw & 0x8000)
+    {
+        // The input is below 0 V.
+        return -32768;
+    }
+    return (int16)((raw - 0x4000) << 1);
+}
+
+void audioService()
+{
+    uint8 samplesLeft;
+    int16 pcm;
+
+    startOrStopStreaming();
+
+    if (!streaming)
+    {
+        return;
+    }
+
+    if (adcStreamSamplesDropped() != lastSamplesDropped)
+    {
+        lastSamplesDropped = adcStreamSamplesDropped();
+        lastDropTime = (uint8)getMs();
+        dropRecent = 1;
+    }
+
+    USBINDEX = AUDIO_ENDPOINT;
+    if (USBCSIL & USBCSIL_INPKT_RDY)
+    {
+        // Both buffers are full.  The computer reads one packet per frame.
+        return;
+    }
+
+    samplesLeft = SAMPLES_PER_FRAME;
+    if (adcStreamRxAvailable() > 2)
+    {
+        // Samples are piling up, so send an extra one.
+        samplesLeft++;
+    }
+
+    // Wait until there are samples to send.  Meanwhile, the USB module
+    // sends empty packets on its own.
+    if (block == 0 && adcStreamRxAvailable() == 0)
+    {
+        return;
+    }
+
+    while (samplesLeft)
+    {
+        if (block == 0)
+        {
+            block = adcStreamRxCurrentBlock();
+            if (block == 0)
+            {
+                break;
+            }
+            blockIndex = 0;
+        }
+
+        pcm = pcmFromSample(block[blockIndex]);
+        AUDIO_FIFO = (uint8)pcm;
+        AUDIO_FIFO = (uint8)(pcm >> 8);
+        samplesLeft--;
+
+        if (++blockIndex >= adcStreamBlockSize())
+        {
+            adcStreamRxDoneWithBlock();
+            block = 0;
+        }
+    }
+
+    USBINDEX = AUDIO_ENDPOINT;
+    USBCSIL |= USBCSIL_INPKT_RDY;
+    usbActivityFlag = 1;
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    usbSetInterfaceHandler = setInterface;
+
+    while(1)
+    {
+        boardService();
+        updateLeds();
+        usbPoll();
+        audioService();
+    }
+}
@@ -0,0 +1 @@
+APP_LIBS := dma.lib power.lib radio_mac.lib radio_queue.lib radio_registers.lib random.lib sensor_node.lib usb.lib usb_cdc_acm.lib wixel.lib adc.lib
@@ -0,0 +1,146 @@
+/** wireless_adc_node app:
+
+This app is a low-power version of wireless_adc_tx for Wixels that run from
+a battery.  It wakes up periodically, reads the voltages on its six analog
+inputs (P0_0, P0_1, P0_2, P0_3, P0_4, and P0_5), transmits them wirelessly,
+and then goes back to sleep in Power Mode 2 with the radio turned off.
+
+The packets it sends have the same format as the packets from wireless_adc_tx,
+so you can receive them with the wireless_adc_rx app.  For more information,
+see the documentation in apps/wireless_adc_rx/wireless_adc_rx.c.
+
+While the Wixel is connected to USB power, it stays awake (with the radio on)
+so that you can configure it and load new apps onto it.
+
+
+== Parameters ==
+
+input_mode: Specifies whether to enable the internal pull-up or pull-down
+  resistors on the analog inputs.  0 means no pull-up or pull-down
+  resistors (the default), 1 means pull-ups, and -1 means pull-downs.
+  The pull-ups and pull-downs draw current from the battery.
+
+report_period_ms: The time between reports, in milliseconds (1 to 32767).
+
+ack_timeout_ms: If this is not 0, the app waits up to this many
+  milliseconds (1 to 255) for the receiver to acknowledge each report.
+  Set the send_acks parameter of wireless_adc_rx to 1 when you use this.
+
+ack_attempts: The maximum number of times to send each report if it is not
+  acknowledged.
+
+radio_channel: See description in radio_queue.h.
+*/
+
+/** Dependencies **************************************************************/
+#include <wixel.h>
+#include <usb.h>
+#include <usb_com.h>
+#include <radio_queue.h>
+#include <sensor_node.h>
+#include <power.h>
+
+
+/** Parameters ****************************************************************/
+
+int32 CODE param_input_mode = 0;
+
+int32 CODE param_report_period_ms = 1000;
+
+int32 CODE param_ack_timeout_ms = 0;
+
+int32 CODE param_ack_attempts = 3;
+
+
+/** Functions *****************************************************************/
+void analogInputsInit()
+{
+    switch(param_input_mode)
+    {
+    case 1: // Enable pull-up resistors for all pins on Port 0.
+        P2INP &= ~(1<<5);  // PDUP0 = 0: Pull-ups on Port 0.
+        P0INP = 0;
+        break;
+
+    case -1: // Enable pull-down resistors for all pins on Port 0.
+        P2INP |= (1<<5);   // PDUP0 = 1: Pull-downs on Port 0.
+        P0INP = 0;
+        break;
+
+    default: // Disable pull-ups and pull-downs for all pins on Port 0.
+        P0INP = 0x3F;
+        break;
+    }
+}
+
+void updateLeds()
+{
+    usbShowStatusWithGreenLed();
+
+    // The yellow LED is on while the Wixel is awake for a report.
+    LED_YELLOW(!sensorNodeSleeping());
+    LED_RED(0);
+}
+
+// Reads the ADC values and sends them to the radio when a report is due.
+void adcToRadioService()
+{
+    uint8 XDATA * txPacket;
+
+    if (sensorNodeReportDue() && (txPacket = radioQueueTxCurrentPacket()))
+    {
+        uint8 i;
+        uint16 XDATA * ptr = (uint16 XDATA *)&txPacket[5];
+
+        // Byte 0 is the length.
+        txPacket[0] = 16;
+
+        // Bytes 1-4 are the serial number.
+        txPacket[1] = serialNumber[0];
+        txPacket[2] = serialNumber[1];
+        txPacket[3] = serialNumber[2];
+        txPacket[4] = serialNumber[3];
+
+        adcSetMillivoltCalibration(adcReadVddMillivolts());
+
+        // Bytes 5-16 are the ADC readings on channels 0-6.
+        for (i = 0; i < 6; i++)
+        {
+            *(ptr++) = adcConvertToMillivolts(adcRead(i));
+        }
+
+        radioQueueTxSendPacket();
+        sensorNodeReportQueued();
+    }
+}
+
+// We do not expect to receive anything except acknowledgments, which
+// sensorNodeService() takes care of, so discard any other packets.
+void radioRxService()
+{
+    uint8 XDATA * rxPacket = radioQueueRxCurrentPacket();
+    if (rxPacket && !sensorNodeIsAck(rxPacket))
+    {
+        radioQueueRxDoneWithPacket();
+    }
+}
+
+void main(void)
+{
+    systemInit();
+    analogInputsInit();
+    usbInit();
+    sensorNodeInit(param_report_period_ms, param_ack_timeout_ms, param_ack_attempts);
+
+    while(1)
+    {
+        updateLeds();
+        boardService();
+        usbComService();
+        sensorNodeService();
+        adcToRadioService();
+        radioRxService();
+
+        powerIdle(sensorNodeMsUntilWake());
+    }
+}
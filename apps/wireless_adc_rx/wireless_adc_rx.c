@@ -40,6 +40,13 @@ To use this data in your application, you can either write PC software that
 reads the data from the COM port and does something with it, or you can
 modify this app.
 
+== Acknowledgments ==
+
+If the send_acks parameter is 1, this app sends an acknowledgment back to
+the transmitter for every report it receives.  The low-power wireless_adc_node
+app can use these acknowledgments to retry reports that were lost
+(see its ack_timeout_ms parameter).
+
 */
 
 /** Dependencies **************************************************************/
@@ -48,8 +55,14 @@ modify this app.
 #include <usb_com.h>
 #include <radio_queue.h>
 
+#include <sensor_node_ack.h>
+
 #include <stdio.h>
 
+/** Parameters ****************************************************************/
+
+int32 CODE param_send_acks = 0;
+
 /** Types *********************************************************************/
 
 typedef struct adcReport
@@ -72,6 +85,23 @@ void putchar(char c)
     usbComTxSendByte(c);
 }
 
+// Sends an acknowledgment to the Wixel with the given serial number.
+// If there is no radio TX buffer available, the transmitter will just
+// send its report again.
+void sendAck(uint8 XDATA * serial)
+{
+    uint8 XDATA * txPacket = radioQueueTxCurrentPacket();
+    if (txPacket)
+    {
+        txPacket[0] = SENSOR_NODE_ACK_LENGTH;
+        txPacket[1] = serial[0];
+        txPacket[2] = serial[1];
+        txPacket[3] = serial[2];
+        txPacket[4] = serial[3];
+        radioQueueTxSendPacket();
+    }
+}
+
 void radioToUsbService()
 {
     adcReport XDATA * rxPacket;
@@ -86,6 +116,14 @@ void radioToUsbService()
 
         uint8 i;
 
+        if (rxPacket->length != sizeof(adcReport) - 1)
+        {
+            // This is some other kind of packet, such as an acknowledgment
+            // sent by another receiver, so ignore it.
+            radioQueueRxDoneWithPacket();
+            return;
+        }
+
         printf("%02X-%02X-%02X-%02X %5u",
                rxPacket->serialNumber[3],
                rxPacket->serialNumber[2],
@@ -102,6 +140,11 @@ void radioToUsbService()
         putchar('\r');
         putchar('\n');
 
+        if (param_send_acks)
+        {
+            sendAck(rxPacket->serialNumber);
+        }
+
         radioQueueRxDoneWithPacket();
     }
 }
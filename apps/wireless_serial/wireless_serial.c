@@ -230,7 +230,7 @@ void errorService()
 
     if (framingErrorActive)
     {
-        if (!isPinHigh(17))
+        if (!GPIO_IS_HIGH(17))
         {
             errorOccurred();
         }
@@ -242,7 +242,7 @@ void errorService()
 
     if (uartRxDisabled)
     {
-        if (!isPinHigh(17))
+        if (!GPIO_IS_HIGH(17))
         {
             // The line is low.
             lastRxLowTime = (uint8)getMs();
@@ -284,16 +284,23 @@ void updateSerialMode()
 void usbToRadioService()
 {
     uint8 signals;
+    uint8 count, space;
 
     // Data
-    while(usbComRxAvailable() && radioComTxAvailable())
+    // Copy whole chunks directly between the USB FIFOs and the radio packet
+    // buffers instead of going through the byte-at-a-time functions.
+    while((count = usbComRxAvailable()) && (space = radioComTxWriteAvailable()))
     {
-        radioComTxSendByte(usbComRxReceiveByte());
+        if (count > space){ count = space; }
+        usbComRxReceive(radioComTxWritePointer(), count);
+        radioComTxWriteDone(count);
     }
 
-    while(radioComRxAvailable() && usbComTxAvailable())
+    while((count = radioComRxAvailable()) && (space = usbComTxAvailable()))
     {
-        usbComTxSendByte(radioComRxReceiveByte());
+        if (count > space){ count = space; }
+        usbComTxSend(radioComRxReadPointer(), count);
+        radioComRxReadDone(count);
     }
 
     // Control Signals
@@ -1 +1 @@
-APP_LIBS := dma.lib usb.lib usb_hid.lib wixel.lib radio_mac.lib radio_queue.lib radio_registers.lib random.lib
\ No newline at end of file
+APP_LIBS := dma.lib usb.lib usb_hid_1ms.lib wixel.lib radio_mac.lib radio_queue.lib radio_registers.lib random.lib
\ No newline at end of file
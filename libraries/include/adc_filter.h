@@ -0,0 +1,155 @@
+/*! \file adc_filter.h
+ * The <code>adc_filter.lib</code> library provides functions for getting
+ * cleaner readings out of the Analog-to-Digital Converter (ADC) than a single
+ * call to adcRead() can give you.
+ *
+ * It provides three tools:
+ *
+ * - <b>Oversampling and decimation</b>: adcReadOversampled() and
+ *   adcFilterBlockDecimate() add together 4<sup>n</sup> readings and
+ *   divide the result by 2<sup>n</sup>, which gives you <em>n</em>
+ *   extra bits of effective resolution if the input has a little noise on it.
+ * - <b>Moving average filter</b>: an #ADC_AVERAGE_FILTER keeps a running sum of the
+ *   last 2<sup>n</sup> readings and returns their average.
+ * - <b>First-order IIR (low-pass) filter</b>: an #ADC_IIR_FILTER keeps an
+ *   exponentially-weighted average that moves 1/2<sup>n</sup> of the way
+ *   towards each new reading.  It only needs two bytes of state.
+ *
+ * All of the filters operate on readings between 0 and 2047 (the values
+ * returned by adcRead()) and only use additions and shifts, so they are fast
+ * on the CC2511 and do not use SDCC's 16-bit multiplication or division
+ * routines.  The functions that process one reading at a time are reentrant,
+ * so they can be called from interrupts as well as from the main loop
+ * (but do not use the same filter in both places).
+ *
+ * The functions with "Block" in their names operate on blocks of raw samples
+ * from the streaming ADC interface (see adc_stream.h).  Those blocks
+ * contain interleaved samples from several channels, so these functions take
+ * a <em>stride</em> parameter that is normally the number of channels.
+ * To process channel <em>c</em>, pass a pointer to element <em>c</em> of
+ * the block.  For example:
+ *
+\code
+uint16 XDATA * block = adcStreamRxCurrentBlock();
+if (block)
+{
+    // Two channels: AIN0 and AIN1.
+    adcIirFilterBlock(&filter0, block + 0, adcStreamBlockSize() / 2, 2);
+    adcIirFilterBlock(&filter1, block + 1, adcStreamBlockSize() / 2, 2);
+    adcStreamRxDoneWithBlock();
+}
+\endcode
+ *
+ * This library depends on <code>adc.lib</code>.
+ */
+
+#ifndef _ADC_FILTER_H
+#define _ADC_FILTER_H
+
+#include <cc2511_types.h>
+
+/*! A moving average filter.  Initialize it with adcAverageFilterInit()
+ * and give it readings with adcAverageFilterUpdate().
+ * The fields of this struct should not be modified directly. */
+typedef struct ADC_AVERAGE_FILTER
+{
+    /*! Points to the last 2<sup>windowShift</sup> readings. */
+    uint16 XDATA * history;
+
+    /*! The sum of all the readings in the history. */
+    uint16 sum;
+
+    /*! The index in the history of the oldest reading. */
+    uint8 index;
+
+    /*! The base-2 logarithm of the number of readings that are averaged. */
+    uint8 windowShift;
+} ADC_AVERAGE_FILTER;
+
+/*! A first-order IIR low-pass filter.  Initialize it with adcIirFilterInit()
+ * and give it readings with adcIirFilterUpdate().
+ *
+ * Each update computes <em>output += (reading - output) / 2<sup>shift</sup></em>.
+ * A shift of 0 means no filtering; each increase of the shift by one
+ * roughly doubles the time constant of the filter, which is about
+ * 2<sup>shift</sup> updates. */
+typedef struct ADC_IIR_FILTER
+{
+    /*! The output of the filter times 2<sup>shift</sup>.
+     * Keeping the extra bits avoids rounding errors. */
+    uint16 state;
+
+    /*! Determines how strong the filter is.  The allowed values are 0 through 5. */
+    uint8 shift;
+} ADC_IIR_FILTER;
+
+/*! Takes 4<sup>extraBits</sup> readings from the specified channel (see adc.h)
+ * and returns a reading with <em>extraBits</em> more bits of resolution than
+ * adcRead() would return.
+ *
+ * \param channel The channel and options, as described in adc.h.
+ * \param extraBits The number of extra bits to get, from 0 to 4.
+ *
+ * \return A number between 0 and 2047&times;2<sup>extraBits</sup>.
+ *
+ * This function blocks until all the readings are done.  At the default
+ * 12-bit resolution, each reading takes about 132 microseconds, so getting
+ * two extra bits (16 readings) takes about 2 ms. */
+uint16 adcReadOversampled(uint8 channel, uint8 extraBits);
+
+/*! Initializes a moving average filter.
+ *
+ * \param filter A pointer to the filter.
+ * \param history A buffer that holds 2<sup>windowShift</sup> readings.
+ * \param windowShift The base-2 logarithm of the number of readings to average,
+ *   from 0 to 5 (1 to 32 readings).
+ * \param initialValue The value that all the readings in the history will start at. */
+void adcAverageFilterInit(ADC_AVERAGE_FILTER XDATA * filter, uint16 XDATA * history,
+    uint8 windowShift, uint16 initialValue);
+
+/*! Adds a reading to a moving average filter.
+ * \param filter A pointer to the filter.
+ * \param reading A number between 0 and 2047.
+ * \return The average of the last 2<sup>windowShift</sup> readings. */
+uint16 adcAverageFilterUpdate(ADC_AVERAGE_FILTER XDATA * filter, uint16 reading) __reentrant;
+
+/*! Initializes a first-order IIR filter.
+ * \param filter A pointer to the filter.
+ * \param shift Determines the strength of the filter, from 0 to 5.
+ * \param initialValue The value that the output will start at. */
+void adcIirFilterInit(ADC_IIR_FILTER XDATA * filter, uint8 shift, uint16 initialValue);
+
+/*! Adds a reading to a first-order IIR filter.
+ * \param filter A pointer to the filter.
+ * \param reading A number between 0 and 2047.
+ * \return The new output of the filter. */
+uint16 adcIirFilterUpdate(ADC_IIR_FILTER XDATA * filter, uint16 reading) __reentrant;
+
+/*! \return The current output of a first-order IIR filter. */
+#define adcIirFilterOutput(filter)  ((filter)->state >> (filter)->shift)
+
+/*! Sums 4<sup>extraBits</sup> raw samples from a streaming ADC block and
+ * returns a reading with <em>extraBits</em> more bits of resolution than a
+ * single sample.
+ *
+ * \param samples A pointer to the first sample to use.
+ * \param stride The distance between consecutive samples of the same channel
+ *   (normally the channel count).
+ * \param extraBits The number of extra bits to get, from 0 to 2.  The block
+ *   must contain at least 4<sup>extraBits</sup> samples of the channel.
+ * \return A number between 0 and 2047&times;2<sup>extraBits</sup>. */
+uint16 adcFilterBlockDecimate(const uint16 XDATA * samples, uint8 stride, uint8 extraBits);
+
+/*! Feeds <em>count</em> raw samples from a streaming ADC block into a
+ * moving average filter.
+ * \return The output of the filter after the last sample. */
+uint16 adcAverageFilterBlock(ADC_AVERAGE_FILTER XDATA * filter, const uint16 XDATA * samples,
+    uint8 count, uint8 stride);
+
+/*! Feeds <em>count</em> raw samples from a streaming ADC block into a
+ * first-order IIR filter.
+ * \return The output of the filter after the last sample. */
+uint16 adcIirFilterBlock(ADC_IIR_FILTER XDATA * filter, const uint16 XDATA * samples,
+    uint8 count, uint8 stride);
+
+#endif
@@ -0,0 +1,113 @@
+/*! \file adc_stream.h
+ * This header file provides functions from <code>adc.lib</code> for
+ * continuously sampling several analog inputs at a precise rate with
+ * almost no CPU overhead.
+ *
+ * Once adcStreamStart() is called, Timer 1 triggers a sequence of ADC
+ * conversions at a fixed rate.  Each sequence converts the channels AIN0
+ * through AIN<em>N</em>-1, where <em>N</em> is the channel count.
+ * The DMA controller moves every result into a ring of sample blocks in
+ * RAM, so the CPU does not have to wait for any conversions and the
+ * timing of the samples does not depend on what the main loop is doing.
+ * The main loop consumes the samples one block at a time with
+ * adcStreamRxCurrentBlock() and adcStreamRxDoneWithBlock().
+ *
+ * Each block always starts with a sample from AIN0 and contains a whole
+ * number of sequences, so the samples in a block are interleaved like this:
+ * AIN0, AIN1, ..., AIN<em>N</em>-1, AIN0, AIN1, ...
+ *
+ * Each sample is the raw 16-bit value of the ADC result register.
+ * Use #ADC_STREAM_SAMPLE to convert it to the same kind of number that
+ * adcRead() returns.
+ *
+ * If the main loop does not consume blocks fast enough, the library
+ * overwrites the newest block instead of blocking or corrupting a block
+ * that the main loop is reading, and counts the samples that were lost.
+ * See adcStreamSamplesDropped().
+ *
+ * This part of the library uses Timer 1, so it will conflict with any other
+ * library that uses Timer 1, such as <code>servo.lib</code>.  It also uses
+ * DMA channel #DMA_CHANNEL_ADC and the DMA interrupt, so it will conflict
+ * with any other code that uses the DMA interrupt.
+ *
+ * While streaming is active, you should not call the functions in adc.h,
+ * because their conversions would be interleaved with the streaming ones.
+ *
+ * Any source file that uses this part of the library must include this
+ * header file so that the DMA interrupt service routine gets linked in.
+ */
+
+#ifndef _ADC_STREAM_H
+#define _ADC_STREAM_H
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+#include <adc.h>
+
+/*! The maximum number of samples in one block.  The actual number depends
+ * on the channel count; see adcStreamBlockSize(). */
+#define ADC_STREAM_MAX_BLOCK_SIZE  32
+
+/*! Converts a raw sample from the streaming buffer to a number between
+ * 0 and 2047, the same way that adcRead() does. */
+#define ADC_STREAM_SAMPLE(raw)  (((raw) & 0x8000) ? 0 : ((raw) >> 4))
+
+/*! Converts a raw sample from the streaming buffer to a number between
+ * -2048 and 2047 (useful with the #ADC_REFERENCE_INTERNAL option when
+ * measuring small signals). */
+#define ADC_STREAM_SIGNED_SAMPLE(raw)  ((int16)(raw) >> 4)
+
+/*! Starts sampling analog inputs continuously.
+ *
+ * \param channelCount The number of channels to sample, from 1 to 6.
+ *   The channels sampled will be AIN0 (P0_0) through AIN<em>channelCount-1</em>.
+ *   Those pins will be configured as analog inputs.
+ *
+ * \param sequenceRate The number of sequences to take per second.
+ *   Each sequence contains one sample from each channel.
+ *   The minimum supported value is 3.
+ *
+ * \param options Specifies the reference and the resolution of the
+ *   conversions.  This may be 0 or the bitwise OR of #ADC_REFERENCE_INTERNAL
+ *   and one of #ADC_BITS_7, #ADC_BITS_9, #ADC_BITS_10, or #ADC_BITS_12,
+ *   as described in adc.h.
+ *
+ * Be sure that the conversions can keep up with the rate you request:
+ * one sequence takes <em>channelCount</em> times the conversion time listed
+ * for the resolution you chose.
+ *
+ * If streaming was already active, it is restarted and any samples that
+ * were not consumed are discarded. */
+void adcStreamStart(uint8 channelCount, uint16 sequenceRate, uint8 options);
+
+/*! Stops the timer and the DMA transfers started by adcStreamStart().
+ * Samples that have not been consumed yet are discarded. */
+void adcStreamStop(void);
+
+/*! \return The number of samples in each block.  This is the largest
+ * multiple of the channel count that is not larger than
+ * #ADC_STREAM_MAX_BLOCK_SIZE. */
+uint8 adcStreamBlockSize(void);
+
+/*! \return The number of complete blocks that are waiting to be consumed
+ * by the main loop. */
+uint8 adcStreamRxAvailable(void);
+
+/*! \return A pointer to the oldest complete block of samples, or 0 if no
+ * complete block is available yet.
+ *
+ * The block stays valid until you call adcStreamRxDoneWithBlock(). */
+uint16 XDATA * adcStreamRxCurrentBlock(void);
+
+/*! Releases the block returned by adcStreamRxCurrentBlock() so its memory
+ * can be used for new samples.  Only call this if adcStreamRxCurrentBlock()
+ * returned a non-zero pointer. */
+void adcStreamRxDoneWithBlock(void);
+
+/*! \return The number of samples that were lost since adcStreamStart()
+ * because the main loop did not consume blocks fast enough. */
+uint16 adcStreamSamplesDropped(void);
+
+ISR(DMA, 0);
+
+#endif
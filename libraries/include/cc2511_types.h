@@ -79,4 +79,10 @@ typedef unsigned char BIT;
 #error "Unknown compiler."
 #endif
 
+/** Generates a compiler error if <em>condition</em> is false.  The condition
+ * must be a constant expression.  <em>name</em> must be an identifier that is
+ * unique in the file; it appears in the error message.
+ */
+#define STATIC_ASSERT(name, condition)  typedef char name##StaticAssert[(condition) ? 1 : -1];
+
 #endif
@@ -20,6 +20,18 @@ void dmaInit(void);
  * transmitting and receiving radio packets. */
 #define DMA_CHANNEL_RADIO  1
 
+/*! This is the number of the DMA channel we have chosen to use for
+ * moving ADC results into RAM (see adc_stream.h). */
+#define DMA_CHANNEL_ADC    2
+
+/*! This is the number of the DMA channel we have chosen to use for
+ * duty cycle sequences of hardware PWM outputs (see pwm.h). */
+#define DMA_CHANNEL_PWM    3
+
+/*! This is the number of the DMA channel we have chosen to use for
+ * copying packets to and from USB endpoint FIFOs (see usb_bulk.h). */
+#define DMA_CHANNEL_USB    4
+
 /*! This struct consists of 4 DMA config registers
  * for DMA channels 1-4. */
 typedef struct DMA14_CONFIG
@@ -29,14 +41,19 @@ typedef struct DMA14_CONFIG
      * radio packets. */
     volatile DMA_CONFIG radio;
 
-    /*! Config struct for DMA channel 2 (unassigned) */
-    volatile DMA_CONFIG _2;
+    /*! This is the DMA configuration struct for DMA channel 2,
+     * which we have chosen to use for streaming ADC results
+     * into RAM. */
+    volatile DMA_CONFIG adc;
 
-    /*! Config struct for DMA channel 3 (unassigned) */
-    volatile DMA_CONFIG _3;
+    /*! This is the DMA configuration struct for DMA channel 3,
+     * which we have chosen to use for PWM duty cycle sequences. */
+    volatile DMA_CONFIG pwm;
 
-    /*! Config struct for DMA channel 4 (unassigned) */
-    volatile DMA_CONFIG _4;
+    /*! This is the DMA configuration struct for DMA channel 4,
+     * which we have chosen to use for copying packets to and from
+     * USB endpoint FIFOs. */
+    volatile DMA_CONFIG usb;
 } DMA14_CONFIG;
 
 /*! This structure in XDATA holds the configuration options
@@ -86,6 +86,23 @@ P1DIR = (P1DIR & MASK) | VALUE;
  * SDCC 3.0.0 (#6037) and it was found that an I/O line could be toggled once
  * every 3.2 microseconds by calling setDigitalOutput() several times in a row.
  *
+ * If the pin number is a constant, you can use the macros #GPIO_IS_HIGH,
+ * #GPIO_WRITE, #GPIO_TOGGLE, #GPIO_SET_OUTPUT, and #GPIO_SET_INPUT instead.
+ * They take the same pin numbers as the functions, but they are expanded
+ * by the preprocessor into the pin's own bit and registers, so they compile
+ * to one or two instructions with no function call.  The pin number must be
+ * a number or a macro that expands to a number, for example:
+\code
+#define BUTTON_PIN 12
+if (!GPIO_IS_HIGH(BUTTON_PIN)) { GPIO_TOGGLE(17); }
+\endcode
+ *
+ * To read or change several pins on the same port at once, use
+ * #GPIO_PORT_READ, #GPIO_PORT_WRITE, and #GPIO_PORT_TOGGLE.  Each of these
+ * takes a constant port number (0, 1, or 2) and a bit mask of the pins to
+ * use (bit 0 is Px_0).  All the pins in the mask are read or changed at the
+ * same time.
+ *
  * \section caveats Caveats
  *
  * To use your digital I/O pins correctly, there are several things you should be aware of:
@@ -218,4 +235,108 @@ void setPort1PullType(BIT pullType) __reentrant;
  * functions declared in board.h. */
 void setPort2PullType(BIT pullType) __reentrant;
 
+// Lookup tables for the macros below: the port and bit of each pin number.
+#define GPIO_PORT_0   0
+#define GPIO_PORT_1   0
+#define GPIO_PORT_2   0
+#define GPIO_PORT_3   0
+#define GPIO_PORT_4   0
+#define GPIO_PORT_5   0
+#define GPIO_PORT_10  1
+#define GPIO_PORT_11  1
+#define GPIO_PORT_12  1
+#define GPIO_PORT_13  1
+#define GPIO_PORT_14  1
+#define GPIO_PORT_15  1
+#define GPIO_PORT_16  1
+#define GPIO_PORT_17  1
+#define GPIO_PORT_20  2
+#define GPIO_PORT_21  2
+#define GPIO_PORT_22  2
+#define GPIO_PORT_23  2
+#define GPIO_PORT_24  2
+
+#define GPIO_BIT_0   0
+#define GPIO_BIT_1   1
+#define GPIO_BIT_2   2
+#define GPIO_BIT_3   3
+#define GPIO_BIT_4   4
+#define GPIO_BIT_5   5
+#define GPIO_BIT_10  0
+#define GPIO_BIT_11  1
+#define GPIO_BIT_12  2
+#define GPIO_BIT_13  3
+#define GPIO_BIT_14  4
+#define GPIO_BIT_15  5
+#define GPIO_BIT_16  6
+#define GPIO_BIT_17  7
+#define GPIO_BIT_20  0
+#define GPIO_BIT_21  1
+#define GPIO_BIT_22  2
+#define GPIO_BIT_23  3
+#define GPIO_BIT_24  4
+
+// Helpers that paste their arguments together after expanding them.
+#define GPIO_PASTE_(a, b, c, d)  a##b##c##d
+#define GPIO_PASTE(a, b, c, d)   GPIO_PASTE_(a, b, c, d)
+#define GPIO_LOOKUP_(table, pinNumber)  table##pinNumber
+#define GPIO_LOOKUP(table, pinNumber)   GPIO_LOOKUP_(table, pinNumber)
+
+// The bit (e.g. P1_2), register (e.g. P1DIR), and bit mask of a pin.
+#define GPIO_SBIT(pinNumber)  GPIO_PASTE(P, GPIO_LOOKUP(GPIO_PORT_, pinNumber), _, GPIO_LOOKUP(GPIO_BIT_, pinNumber))
+#define GPIO_REG(pinNumber, reg)  GPIO_PASTE(P, GPIO_LOOKUP(GPIO_PORT_, pinNumber), reg, )
+#define GPIO_MASK(pinNumber)  (1 << GPIO_LOOKUP(GPIO_BIT_, pinNumber))
+
+/*! Same as isPinHigh(), but <em>pinNumber</em> must be a constant.  This
+ * compiles to a single bit read. */
+#define GPIO_IS_HIGH(pinNumber)  (GPIO_SBIT(pinNumber))
+
+/*! Sets the output value of a pin that is already an output.
+ * <em>pinNumber</em> must be a constant.  This compiles to a single bit
+ * write. */
+#define GPIO_WRITE(pinNumber, value)  (GPIO_SBIT(pinNumber) = (value))
+
+/*! Inverts the output value of a pin that is already an output.
+ * <em>pinNumber</em> must be a constant.  This compiles to a single CPL
+ * instruction. */
+#define GPIO_TOGGLE(pinNumber)  (GPIO_SBIT(pinNumber) = !GPIO_SBIT(pinNumber))
+
+/*! Same as setDigitalOutput(), but <em>pinNumber</em> must be a constant. */
+#define GPIO_SET_OUTPUT(pinNumber, value)  do { \
+    GPIO_SBIT(pinNumber) = (value); \
+    GPIO_REG(pinNumber, DIR) |= GPIO_MASK(pinNumber); } while(0)
+
+/*! Same as setDigitalInput(), but <em>pinNumber</em> must be a constant. */
+#define GPIO_SET_INPUT(pinNumber, pulled)  do { \
+    if (pulled) { GPIO_REG(pinNumber, INP) &= ~GPIO_MASK(pinNumber); } \
+    else { GPIO_REG(pinNumber, INP) |= GPIO_MASK(pinNumber); } \
+    GPIO_REG(pinNumber, DIR) &= ~GPIO_MASK(pinNumber); } while(0)
+
+/*! Evaluates to the values of the pins of a port that are selected by
+ * <em>mask</em>; the other bits are 0.
+ * \param port A constant port number: 0, 1, or 2.
+ * \param mask A bit mask; bit 0 is Px_0 and bit 7 is Px_7. */
+#define GPIO_PORT_READ(port, mask)  (GPIO_PASTE(P, port, , ) & (mask))
+
+/*! Sets the output values of the pins of a port that are selected by
+ * <em>mask</em> to the corresponding bits of <em>value</em>, without
+ * changing the other pins.  The pins must already be outputs.
+ *
+ * This takes two instructions (ORL and ANL), each of which is atomic, so it
+ * is safe to use even if an interrupt changes other pins on the same port.
+ * Pins that go high change one instruction before pins that go low.
+ *
+ * \param port A constant port number: 0, 1, or 2.
+ * \param mask A bit mask; bit 0 is Px_0 and bit 7 is Px_7.
+ * \param value The new values of the pins. */
+#define GPIO_PORT_WRITE(port, mask, value)  do { \
+    GPIO_PASTE(P, port, , ) |= (value) & (mask); \
+    GPIO_PASTE(P, port, , ) &= (value) | ~(mask); } while(0)
+
+/*! Inverts the output values of the pins of a port that are selected by
+ * <em>mask</em>.  This compiles to a single XRL instruction.
+ * \param port A constant port number: 0, 1, or 2.
+ * \param mask A bit mask; bit 0 is Px_0 and bit 7 is Px_7. */
+#define GPIO_PORT_TOGGLE(port, mask)  (GPIO_PASTE(P, port, , ) ^= (mask))
+
 #endif
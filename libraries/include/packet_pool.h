@@ -0,0 +1,142 @@
+/*! \file packet_pool.h
+ * The <code>packet_pool.lib</code> library manages a pool of fixed-size
+ * packet buffers in XDATA that can be shared by several parts of your app.
+ * Instead of giving every layer (radio, UART, USB) its own set of buffers
+ * that are sized for the worst case, you give the pool one array, and each
+ * layer allocates buffers from it as the current traffic needs them.
+ *
+ * A buffer is identified by a one-byte <em>handle</em>.  Whoever allocates a
+ * buffer owns it, and can pass the ownership to another part of the app
+ * just by passing the handle (for example through a queue of handles built
+ * with ring.h), so the data does not need to be copied at every layer.  The
+ * part of the app that is done with the buffer calls packetPoolRelease().
+ *
+ * Each buffer has a reference count.  If more than one part of the app needs
+ * to read the same buffer (for example to send one received radio packet to
+ * both the USB and the UART), call packetPoolRetain() once for each extra
+ * owner; the buffer is returned to the pool when every owner has released
+ * it.
+ *
+ * The functions in this library are reentrant and disable interrupts
+ * briefly while they run, so they can be called from interrupts and from the
+ * main loop at the same time.
+ *
+ * The apps/radio_usb_bridge app uses the pool to pass received radio packets
+ * to USB and to UART1 without copying them (see radioQueueRxTakePacket()).
+ *
+ * Example:
+ *
+\code
+#define POOL_BLOCKS 8
+#define RX_QUEUE_SIZE 8
+uint8 XDATA poolStorage[PACKET_POOL_STORAGE_SIZE(POOL_BLOCKS)];
+volatile uint8 XDATA rxQueue[RX_QUEUE_SIZE];   // Handles of received packets.
+volatile uint8 DATA rxHead = 0, rxTail = 0;
+
+void packetReceived()   // Called from an interrupt.
+{
+    if (!RING_IS_FULL(rxHead, rxTail, RX_QUEUE_SIZE))
+    {
+        uint8 handle = packetPoolAlloc();
+        if (handle != PACKET_POOL_NONE)
+        {
+            uint8 XDATA * packet = packetPoolBuffer(handle);
+            // ... fill in packet, with the length in packet[0] ...
+            rxQueue[rxHead] = handle;
+            rxHead = RING_NEXT(rxHead, RX_QUEUE_SIZE);
+        }
+    }
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    packetPoolInit(poolStorage, POOL_BLOCKS);
+
+    while(1)
+    {
+        boardService();
+        usbComService();
+        if (!RING_IS_EMPTY(rxHead, rxTail))
+        {
+            uint8 handle = rxQueue[rxTail];
+            uint8 XDATA * packet = packetPoolBuffer(handle);
+            if (usbComTxAvailable() >= packet[0])
+            {
+                usbComTxSend(packet + 1, packet[0]);
+                rxTail = RING_NEXT(rxTail, RX_QUEUE_SIZE);
+                packetPoolRelease(handle);
+            }
+        }
+    }
+}
+\endcode
+ */
+
+#ifndef _PACKET_POOL_H
+#define _PACKET_POOL_H
+
+#include <cc2511_types.h>
+
+/*! The size of each buffer in the pool, in bytes.  This is enough for any
+ * packet of radio_queue.h or radio_link.h (including the length byte and
+ * the two status bytes appended by the radio) and for half of a full-speed
+ * USB bulk packet. */
+#define PACKET_POOL_BLOCK_SIZE  32
+
+/*! The maximum number of buffers in the pool. */
+#define PACKET_POOL_MAX_BLOCKS  64
+
+/*! Evaluates to the number of bytes of storage that packetPoolInit() needs
+ * for a pool of <em>blockCount</em> buffers: the buffers themselves, plus
+ * two bytes per buffer for the reference count and the free list.  Use a
+ * constant for <em>blockCount</em> so you can declare the storage array
+ * with it. */
+#define PACKET_POOL_STORAGE_SIZE(blockCount)  ((uint16)(blockCount) * (PACKET_POOL_BLOCK_SIZE + 2))
+
+/*! The handle returned by packetPoolAlloc() when the pool is empty. */
+#define PACKET_POOL_NONE  0xFF
+
+/*! Pointer to the array passed to packetPoolInit().  Use packetPoolBuffer()
+ * instead of this variable. */
+extern uint8 XDATA * DATA packetPoolStorage;
+
+/*! Evaluates to a pointer to the #PACKET_POOL_BLOCK_SIZE bytes of the buffer
+ * with the specified handle.  The pointer is only valid while you own the
+ * buffer. */
+#define packetPoolBuffer(handle)  (packetPoolStorage + (uint16)(handle) * PACKET_POOL_BLOCK_SIZE)
+
+/*! Evaluates to the handle of the buffer that starts at <em>buffer</em>,
+ * which must be a pointer returned by packetPoolBuffer(). */
+#define packetPoolHandle(buffer)  ((uint8)((uint16)((uint8 XDATA *)(buffer) - packetPoolStorage) / PACKET_POOL_BLOCK_SIZE))
+
+/*! Gives the pool its memory and marks all the buffers as free.  This must
+ * be called before any other function in this library.
+ *
+ * \param storage An array of PACKET_POOL_STORAGE_SIZE(<em>blockCount</em>)
+ *   bytes.  It must stay allocated for as long as you use the pool (it is
+ *   usually a global variable).
+ * \param blockCount The number of buffers, from 1 to #PACKET_POOL_MAX_BLOCKS. */
+void packetPoolInit(uint8 XDATA * storage, uint8 blockCount);
+
+/*! Takes a buffer from the pool.  Its reference count is 1, and its contents
+ * are undefined.
+ *
+ * \return The handle of the buffer, or #PACKET_POOL_NONE if all the buffers
+ *   are in use. */
+uint8 packetPoolAlloc(void) __reentrant;
+
+/*! Adds an owner to a buffer you own, by incrementing its reference count.
+ * Each call must be matched by a call to packetPoolRelease(). */
+void packetPoolRetain(uint8 handle) __reentrant;
+
+/*! Gives up your ownership of a buffer.  When the last owner releases it,
+ * the buffer goes back to the pool, and its handle must not be used again
+ * until it is returned by packetPoolAlloc(). */
+void packetPoolRelease(uint8 handle) __reentrant;
+
+/*! \return The number of buffers that can currently be allocated. */
+uint8 packetPoolAvailable(void);
+
+#endif
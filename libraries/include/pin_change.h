@@ -0,0 +1,152 @@
+/*! \file pin_change.h
+ * The <code>pin_change.lib</code> library uses the port interrupts of the
+ * CC2511 to detect changes on digital input pins, so your app does not have
+ * to poll the pins every time through its main loop.  Each change is
+ * debounced and reported with a microsecond timestamp (in the same units as
+ * getUs()) of the moment the pin first started to change, no matter how long
+ * it takes the main loop to notice.
+ *
+ * Call pinChangeEnable() for each pin you want to watch, and call
+ * pinChangeService() regularly from your main loop.  When a pin has been
+ * stable at a new level for #pinChangeDebounceMs milliseconds,
+ * pinChangeService() reports the change in two ways:
+ * - It calls #pinChangeHandler (if it is not 0) with a ::PIN_CHANGE_EVENT
+ *   describing the change.  The handler runs in the main loop, so it can
+ *   call any other function in the SDK.
+ * - It sets a flag for the pin that can be read and cleared with
+ *   pinChangeOccurred().
+ *
+ * Example:
+ *
+\code
+void buttonChanged(PIN_CHANGE_EVENT XDATA * event)
+{
+    if (event->pinNumber == 12 && !event->level)
+    {
+        LED_YELLOW_TOGGLE();   // The button on P1_2 was pressed.
+    }
+}
+
+void main()
+{
+    systemInit();
+    pinChangeHandler = buttonChanged;
+    pinChangeEnable(12, PIN_CHANGE_FALLING);
+    while(1)
+    {
+        boardService();
+        pinChangeService();
+    }
+}
+\endcode
+ *
+ * This library works with the pins on Port 0 (pin numbers 0-5) and Port 1
+ * (pin numbers 10-17); see gpio.h for how pins are numbered.  Port 2 is not
+ * supported because its interrupt is shared with the USB module.  The pins
+ * should be configured as inputs; the library does not change their
+ * direction or pull resistors.
+ *
+ * The CC2511 can only detect one kind of edge (rising or falling) at a time
+ * on each port.  The interrupt always watches for the edge that takes the
+ * enabled pins away from their current level, so if all the enabled pins on
+ * a port are at the same level, every change gets an exact timestamp.  If
+ * they are at different levels, changes that the interrupt cannot see are
+ * detected by pinChangeService() instead, and are timestamped when
+ * pinChangeService() sees them.  The rising/falling selection of each pin
+ * only decides which debounced changes are reported.
+ *
+ * Changing a pin's level also causes a port interrupt, which wakes the
+ * CC2511 from PM1 or PM2 (see power.h).
+ *
+ * The Port 0 interrupt is also used by usbSleep() to wake up on USB resume
+ * (see usbSuspendMode in usb.h).  This library's ISR only clears the flags
+ * of its own pins and leaves the USB resume flag for usbSleep(); while that
+ * flag is set, the Port 0 interrupt stays masked until the next call to
+ * pinChangeService(), and pin changes are captured when it is unmasked.
+ *
+ * This library uses getUs(), so Timer 4 must be running (systemInit() starts
+ * it).  Since this library uses interrupts, the include statement must be
+ * present in the file that contains main().
+ */
+
+#ifndef _PIN_CHANGE_H
+#define _PIN_CHANGE_H
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+
+/*! Report changes from low to high.  See pinChangeEnable(). */
+#define PIN_CHANGE_RISING   1
+
+/*! Report changes from high to low.  See pinChangeEnable(). */
+#define PIN_CHANGE_FALLING  2
+
+/*! Report all changes.  See pinChangeEnable(). */
+#define PIN_CHANGE_BOTH     3
+
+/*! Describes a debounced change on a pin. */
+typedef struct PIN_CHANGE_EVENT
+{
+    /*! The pin that changed, as a pin number from gpio.h (e.g. 12 for P1_2). */
+    uint8 pinNumber;
+
+    /*! The new level of the pin: 0 (low) or 1 (high). */
+    uint8 level;
+
+    /*! The time when the pin first started to change, in the same units
+     * as getUs(). */
+    uint32 timeUs;
+} PIN_CHANGE_EVENT;
+
+/*! The type of function called when a pin changes.  The event is only
+ * valid until the function returns. */
+typedef void (PinChangeHandler)(PIN_CHANGE_EVENT XDATA * event);
+
+/*! The function that pinChangeService() calls when a pin changes.  The
+ * default value is 0, which means that changes are only reported through
+ * pinChangeOccurred(). */
+extern PinChangeHandler * pinChangeHandler;
+
+/*! The time, in milliseconds, that a pin must be stable at a new level
+ * before the change is reported.  The default is 5.  Set this to 0 if the
+ * signal is clean and you want changes reported as soon as possible. */
+extern uint8 pinChangeDebounceMs;
+
+/*! Starts watching a pin for changes.
+ * \param pinNumber A pin number on Port 0 or Port 1 (0-5 or 10-17).
+ * \param edges The changes to report: #PIN_CHANGE_RISING,
+ *   #PIN_CHANGE_FALLING, or #PIN_CHANGE_BOTH.
+ *
+ * The current level of the pin becomes its debounced level, so no change
+ * is reported until the pin changes. */
+void pinChangeEnable(uint8 pinNumber, uint8 edges);
+
+/*! Stops watching a pin for changes and clears its flag. */
+void pinChangeDisable(uint8 pinNumber);
+
+/*! Debounces the changes captured by the port interrupts, and reports the
+ * ones that are done.  This should be called regularly from your main
+ * loop. */
+void pinChangeService(void);
+
+/*! \return 1 if a change was reported on the pin since the last time this
+ * function was called for it, or 0 otherwise.  Calling this clears the
+ * pin's flag. */
+BIT pinChangeOccurred(uint8 pinNumber);
+
+/*! \return The debounced level of the pin: 0 (low) or 1 (high).  This does
+ * not change until pinChangeService() reports the change, even if the pin
+ * has been stable at the new level for a while. */
+BIT pinChangeLevel(uint8 pinNumber);
+
+/*! \return The time of the last change reported on the pin, in the same
+ * units as getUs(). */
+uint32 pinChangeTimeUs(uint8 pinNumber);
+
+/*! The Port 0 interrupt, which captures changes on pins 0-5. */
+ISR(P0INT, 0);
+
+/*! The Port 1 interrupt, which captures changes on pins 10-17. */
+ISR(P1INT, 0);
+
+#endif
@@ -0,0 +1,161 @@
+/*! \file power.h
+ * The <code>power.lib</code> library reduces the average current used by
+ * your Wixel by putting the CC2511 into a low-power mode whenever your main
+ * loop has nothing to do.
+ *
+ * The CC2511 has several power modes:
+ * - <b>Active</b>: The CPU is running.
+ * - <b>Idle (PM0)</b>: The CPU is halted but the clocks and all the
+ *   peripherals keep running.  Any enabled interrupt wakes the CPU up
+ *   within a few clock cycles.  The Timer 4 interrupt (see time.h) occurs
+ *   every millisecond, so the CPU never stays idle for longer than that.
+ * - <b>PM1</b> and <b>PM2</b>: The high-speed oscillators are off, so the
+ *   radio, USB, the UARTs, and the timers all stop.  Only the sleep timer
+ *   and I/O pin interrupts can wake the CPU.  Waking from PM2 takes longer
+ *   than waking from PM1, but PM2 uses much less current.
+ *
+ * Call powerIdle() at the end of each pass through your main loop.
+ * It asks every registered client (::POWER_CLIENT) what the deepest power
+ * mode is that it can tolerate right now, and then enters that mode.
+ * A client that has pending work can return #POWER_MODE_ACTIVE to keep
+ * the CPU running.  For example:
+ *
+\code
+POWER_CLIENT XDATA appPowerClient;
+
+uint8 appPowerMode()
+{
+    return usbComRxAvailable() ? POWER_MODE_ACTIVE : POWER_MODE_PM2;
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    powerRegisterUsb();    // Stay in PM0 or above while USB is connected.
+    appPowerClient.deepestMode = appPowerMode;
+    powerRegister(&appPowerClient);
+
+    while(1)
+    {
+        boardService();
+        usbComService();
+        // ...
+        powerIdle(softTimerMsUntilNext());
+    }
+}
+\endcode
+ *
+ * When powerIdle() enters PM1 or PM2, it uses powerSleep(), which wakes up
+ * with the sleep timer, restarts the crystal oscillator, and adds the time
+ * spent sleeping to getMs() and getUs().
+ *
+ * This library depends on <code>wixel.lib</code>.
+ */
+
+#ifndef _POWER_H
+#define _POWER_H
+
+#include <cc2511_types.h>
+
+/*! The CPU must keep running because there is work to do. */
+#define POWER_MODE_ACTIVE  0
+
+/*! Power Mode 0: the CPU is halted until the next interrupt. */
+#define POWER_MODE_IDLE    1
+
+/*! Power Mode 1: the high-speed oscillators are off. */
+#define POWER_MODE_PM1     2
+
+/*! Power Mode 2: the high-speed oscillators and the digital voltage
+ * regulator are off. */
+#define POWER_MODE_PM2     3
+
+/*! powerIdle() only uses PM1 or PM2 if it is allowed to sleep for at least
+ * this many milliseconds; otherwise the time needed to restart the crystal
+ * oscillator would not be worth it. */
+#define POWER_MIN_DEEP_SLEEP_MS  4
+
+/*! The type of function that tells the power manager the deepest power mode
+ * a client can tolerate.  It should return one of the POWER_MODE_*
+ * values. */
+typedef uint8 (PowerModeFunction)(void);
+
+/*! The type of function that is called before entering or after leaving
+ * PM1 or PM2.  The argument is the power mode (#POWER_MODE_PM1 or
+ * #POWER_MODE_PM2). */
+typedef void (PowerEventFunction)(uint8 mode);
+
+/*! A client of the power manager: usually a library or part of an app that
+ * needs certain clocks or interrupts.  The memory for this struct is
+ * provided by the client, and the struct must stay valid after it is
+ * registered with powerRegister().
+ *
+ * Any of the function pointers may be 0. */
+typedef struct POWER_CLIENT
+{
+    /*! The next client registered. */
+    struct POWER_CLIENT XDATA * next;
+
+    /*! The previous client registered. */
+    struct POWER_CLIENT XDATA * previous;
+
+    /*! Returns the deepest power mode this client can tolerate right now. */
+    PowerModeFunction * deepestMode;
+
+    /*! Called before entering PM1 or PM2.  The clients' functions are called
+     * in the order the clients were registered. */
+    PowerEventFunction * sleeping;
+
+    /*! Called after leaving PM1 or PM2.  The clients' functions are called in
+     * the opposite order from the order the clients were registered. */
+    PowerEventFunction * waking;
+} POWER_CLIENT;
+
+/*! Adds a client to the power manager.  This function sets the next and
+ * previous fields; the other fields should be set before calling it. */
+void powerRegister(POWER_CLIENT XDATA * client);
+
+/*! Puts the CPU into the deepest power mode allowed by all the registered
+ * clients, and returns when it wakes up.
+ *
+ * If any client returns #POWER_MODE_ACTIVE, this function returns
+ * immediately.  If the deepest mode allowed is #POWER_MODE_PM1 or
+ * #POWER_MODE_PM2 and \p maxSleepMs is at least #POWER_MIN_DEEP_SLEEP_MS,
+ * it calls powerSleep().  Otherwise it enters PM0 until the next interrupt.
+ *
+ * \param maxSleepMs The maximum number of milliseconds to sleep.
+ *   Pass 0 to never sleep, or 0xFFFF if there is no limit.  This is meant
+ *   to receive the time until your next scheduled event (for example,
+ *   the return value of softTimerMsUntilNext()). */
+void powerIdle(uint16 maxSleepMs);
+
+/*! Enters PM1 or PM2 for the specified time.
+ *
+ * This function calls the clients' sleeping functions, programs the sleep
+ * timer, and enters the power mode.  The CPU wakes up when the sleep timer
+ * expires or when an enabled I/O interrupt occurs.  Then it restarts the
+ * crystal oscillator, adds the time spent sleeping and restarting the
+ * oscillator to getMs() and getUs(), and calls the clients' waking
+ * functions.
+ *
+ * The sleep timer is clocked by the CC2511's low-power RC oscillator,
+ * which is calibrated to 32 kHz, so the time is only as accurate as that
+ * oscillator (about 1%).
+ *
+ * \param milliseconds The time to sleep, from 1 to 65535 ms.
+ * \param mode #POWER_MODE_PM1 or #POWER_MODE_PM2.
+ * \return The number of milliseconds actually spent sleeping. */
+uint16 powerSleep(uint16 milliseconds, uint8 mode);
+
+/*! Registers a client that keeps the CPU in PM0 or higher while USB power
+ * is present, because the USB module needs the crystal oscillator.
+ * It is OK to call this more than once. */
+void powerRegisterUsb(void);
+
+/*! Registers a client that keeps the CPU in PM0 or higher while the radio is
+ * not idle (for example, while the radio libraries are listening for
+ * packets).  It is OK to call this more than once. */
+void powerRegisterRadio(void);
+
+#endif
@@ -0,0 +1,154 @@
+/*! \file pwm.h
+ * The <code>pwm.lib</code> library uses the CC2511's timers to generate
+ * pulse-width modulated (PWM) signals on the Wixel's pins entirely in
+ * hardware.  Once an output is started, it keeps running without any CPU
+ * time, which makes it suitable for LED dimming, motor drive, and (with a
+ * low-pass filter) analog outputs.
+ *
+ * Each timer runs in modulo mode: it counts from 0 up to the end of its
+ * period and starts over.  Channel 0 of the timer defines the period, so it
+ * cannot be used as an output.  The other channels are set high when the
+ * counter is 0 and cleared when the counter reaches their duty cycle.  These
+ * are the outputs available on the Wixel:
+ *
+ * <table>
+ * <caption>PWM outputs</caption>
+ * <tr><th>Timer</th><th>Pins</th><th>Frequency</th><th>Resolution</th></tr>
+ * <tr><td>1</td><td>P0_3 and P0_4, or P1_1 and P1_0</td><td>any</td><td>up to 65535</td></tr>
+ * <tr><td>3</td><td>P1_4 or P1_7</td><td>any</td><td>up to 255</td></tr>
+ * <tr><td>4</td><td>P1_1</td><td>1 kHz</td><td>189</td></tr>
+ * </table>
+ *
+ * The two Timer 1 outputs must both be on Port 0 or both be on Port 1,
+ * because the CC2511 moves all the Timer 1 channels together.  Timer 4 is
+ * also the timer that getMs() uses (see time.h), so its frequency cannot be
+ * changed.  Timer 1 on Port 1 and Timer 4 share pins P1_0 and P1_1, so only
+ * one of them can have outputs there at a time.
+ *
+ * The <em>resolution</em> of a timer is the number of timer ticks in one
+ * period.  pwmStart() chooses the finest resolution that gives the requested
+ * frequency and returns it.  A duty cycle of 0 to <em>resolution</em> sets
+ * the high time of the output in ticks; a duty cycle equal to or greater
+ * than the resolution keeps the output high.  You can also use
+ * pwmSetDutyFraction() to set the duty cycle without knowing the resolution.
+ *
+ * Changes to the duty cycle are glitch-free: the timer only loads a new
+ * compare value at the end of a period, so every period is either
+ * completely at the old duty cycle or completely at the new one.
+ *
+ * Example:
+ *
+\code
+void main()
+{
+    uint16 resolution;
+    systemInit();
+    resolution = pwmStart(1, 20000);        // 20 kHz on Timer 1: resolution is 1200.
+    pwmEnable(1, 3);                        // Output on P0_3.
+    pwmSetDutyCycle(3, resolution / 4);     // 25% duty cycle.
+    while(1)
+    {
+        boardService();
+    }
+}
+\endcode
+ *
+ * <b>Duty cycle sequences:</b> pwmSequenceStart() makes a DMA channel copy a
+ * new duty cycle from an array into the timer at the end of every period.
+ * This generates arbitrary waveforms (for example a sine wave after a
+ * low-pass filter, or an LED fading in and out) with no CPU load at all.
+ * Only one sequence can run at a time, and it uses DMA channel
+ * #DMA_CHANNEL_PWM, so <code>dma.lib</code> is needed if you use sequences.
+ * The apps/example_pwm_sequence app uses a sequence to fade an LED.
+ *
+ * <b>Conflicts:</b> Timer 1 is also used by servo.h and adc_stream.h, so
+ * this library cannot use Timer 1 while either of those is active.  Pins
+ * P0_3, P0_4, P1_4, and P1_7 can also be used by the UARTs (see uart0.h and
+ * uart1.h), so do not use a pin for PWM while a UART is using it.
+ */
+
+#ifndef _PWM_H
+#define _PWM_H
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+
+/*! Starts a timer in PWM mode.  The outputs of the timer stay disabled until
+ * you call pwmEnable().
+ *
+ * \param timer The timer to use: 1, 3, or 4.
+ * \param frequency The PWM frequency in Hz.  For Timer 1, this can be from
+ *   3 Hz to 12 MHz.  For Timer 3, this can be from 735 Hz to 12 MHz.  For
+ *   Timer 4, this parameter is ignored and the frequency is 1 kHz.
+ * \return The resolution: the number of timer ticks in one period, or 0 if
+ *   the timer is not supported.
+ *
+ * The actual frequency is 24 MHz divided by a power of two and the
+ * resolution, so it might be a little different from the one requested.
+ * Calling this function again changes the frequency; the duty cycles
+ * (in ticks) of the outputs are not changed. */
+uint16 pwmStart(uint8 timer, uint32 frequency);
+
+/*! Disables all the outputs of a timer and stops it.  Timer 4 keeps
+ * running because getMs() needs it. */
+void pwmStop(uint8 timer);
+
+/*! \return The resolution of the timer (see pwmStart()). */
+uint16 pwmResolution(uint8 timer);
+
+/*! Connects a pin to a timer output.  The pin is configured as an output and
+ * starts with a duty cycle of 0.
+ *
+ * \param timer The timer: 1, 3, or 4.
+ * \param pinNumber The pin, numbered as in gpio.h (e.g. 3 for P0_3).  See
+ *   the table at the top of this file for the pins of each timer.
+ * \return 1 if the pin was enabled, or 0 if the timer does not have an
+ *   output on that pin, if the other Timer 1 output is enabled on the other
+ *   port, or if the pin is P1_0 or P1_1 and the other one of Timer 1 and
+ *   Timer 4 has an output on those pins. */
+BIT pwmEnable(uint8 timer, uint8 pinNumber);
+
+/*! Disconnects a pin from its timer.  The pin becomes a general-purpose
+ * output driving low. */
+void pwmDisable(uint8 pinNumber);
+
+/*! Sets the duty cycle of a pin enabled by pwmEnable().  The new value takes
+ * effect at the start of the next period.
+ *
+ * \param pinNumber The pin.
+ * \param duty The number of ticks per period that the pin is high, from 0
+ *   to the resolution of the timer.
+ *
+ * A duty cycle of 0 might still give a very short pulse at the start of each
+ * period.  Use pwmDisable() if you need the pin to stay low. */
+void pwmSetDutyCycle(uint8 pinNumber, uint16 duty);
+
+/*! Sets the duty cycle of a pin as a fraction of the period, from 0 (0%)
+ * to 0xFFFF (100%), regardless of the resolution of its timer. */
+void pwmSetDutyFraction(uint8 pinNumber, uint16 fraction);
+
+/*! Starts changing the duty cycle of a pin automatically at the end of each
+ * period, using DMA.  Any sequence already running is stopped first.
+ *
+ * \param pinNumber A pin enabled by pwmEnable().
+ * \param sequence The duty cycles, in ticks.  For Timer 1, this must point
+ *   to an array of uint16 values; for Timers 3 and 4 it must point to an
+ *   array of uint8 values.  The array must stay allocated until the
+ *   sequence stops.
+ * \param length The number of duty cycles in the sequence (1 to 8191).
+ * \param repeat If this is 1, the sequence starts over after the last duty
+ *   cycle and runs until pwmSequenceStop() is called.  If it is 0, the pin
+ *   keeps the last duty cycle of the sequence.
+ *
+ * Each duty cycle lasts for one period.  To make each one last longer,
+ * repeat it in the array or lower the frequency of the timer. */
+void pwmSequenceStart(uint8 pinNumber, const void XDATA * sequence, uint16 length, BIT repeat);
+
+/*! Stops the duty cycle sequence.  The pin keeps the duty cycle that it has
+ * at the time of the call. */
+void pwmSequenceStop(void);
+
+/*! \return 1 if a duty cycle sequence is running, or 0 otherwise. */
+BIT pwmSequenceRunning(void);
+
+#endif
@@ -68,6 +68,33 @@ uint8 radioComRxAvailable(void);
  * radioComRxAvailable(). */
 uint8 radioComRxReceiveByte(void);
 
+/*! \return A pointer to the next byte in the RX buffer.
+ *
+ * This function, along with radioComRxAvailable() and radioComRxReadDone(),
+ * lets you process received bytes directly in the radio packet buffer
+ * instead of copying them one at a time with radioComRxReceiveByte().
+ * The bytes from the pointer up to the number returned by
+ * radioComRxAvailable() are all in the same packet, so they are contiguous.
+ *
+ * Example:
+\code
+uint8 count = radioComRxAvailable();
+if (count > usbComTxAvailable()){ count = usbComTxAvailable(); }
+usbComTxSend(radioComRxReadPointer(), count);
+radioComRxReadDone(count);
+\endcode
+ *
+ * You must call radioComRxAvailable() before calling this function, and it
+ * must have returned a non-zero value. */
+uint8 XDATA * radioComRxReadPointer(void);
+
+/*! Removes bytes from the RX buffer after you have read them using the
+ * pointer from radioComRxReadPointer().
+ *
+ * \param size The number of bytes to remove.  This should not exceed the
+ *   last value returned by radioComRxAvailable(). */
+void radioComRxReadDone(uint8 size);
+
 /*! This function must be called regularly if you want to send data
  * or control signals to the other Wixel. */
 void radioComTxService(void);
@@ -87,6 +114,40 @@ uint8 radioComTxAvailable(void);
  * If you call this function, you must also call radioComTxService() regularly. */
 void radioComTxSendByte(uint8 byte);
 
+/*! \return The number of bytes that can be written at the pointer returned
+ * by radioComTxWritePointer().
+ *
+ * This function, along with radioComTxWritePointer() and radioComTxWriteDone(),
+ * lets you put data directly into the radio packet buffer instead of adding it
+ * one byte at a time with radioComTxSendByte().  The space returned by this
+ * function is contiguous because it is all in the same packet, so it might be
+ * less than the value returned by radioComTxAvailable().
+ *
+ * Example:
+\code
+uint8 count = usbComRxAvailable();
+if (count > radioComTxWriteAvailable()){ count = radioComTxWriteAvailable(); }
+usbComRxReceive(radioComTxWritePointer(), count);
+radioComTxWriteDone(count);
+\endcode
+ *
+ * If you use this function, you must also call radioComTxService() regularly. */
+uint8 radioComTxWriteAvailable(void);
+
+/*! \return A pointer to the location where the next byte to be sent should
+ * be written.
+ *
+ * You must call radioComTxWriteAvailable() before calling this function, and
+ * it must have returned a non-zero value. */
+uint8 XDATA * radioComTxWritePointer(void);
+
+/*! Adds the bytes that you wrote at the pointer returned by
+ * radioComTxWritePointer() to the TX buffer.
+ *
+ * \param size The number of bytes written.  This should not exceed the last
+ *   value returned by radioComTxWriteAvailable(). */
+void radioComTxWriteDone(uint8 size);
+
 /*! \param controlSignals The state of the eight virtual TX control signals.
  *   Each bit represents a different control signal.
  *
@@ -20,6 +20,31 @@
  * For this library to work, you must write
  * <code>include <radio_link.h></code>
  * in the source file that contains your main() function.
+ *
+ * \section radio_link_depths Queue depths
+ *
+ * By default, this library has 16 TX packet buffers and 4 RX packet buffers.
+ * The numbers can be changed with the preprocessor symbols
+ * <code>RADIO_LINK_TX_PACKET_COUNT</code> and
+ * <code>RADIO_LINK_RX_PACKET_COUNT</code>.  Each count must be a power of
+ * two (and the RX count must be at least 4), and the buffers must fit in
+ * <code>RADIO_LINK_XDATA_BUDGET</code> bytes (1024 by default); otherwise
+ * the library does not compile.
+ *
+ * Since the libraries are shared by all apps, an app that needs different
+ * numbers should compile its own copy of the library instead of linking
+ * <code>radio_link.lib</code>.  For example, an app named
+ * <code>my_bridge</code> that needs a deep RX queue could have this in its
+ * <code>options.mk</code>:
+ *
+\code
+APP_LIBS := radio_mac.lib radio_registers.lib random.lib dma.lib usb.lib usb_cdc_acm.lib wixel.lib
+APP_RELS := $(sort $(APP_RELS) apps/my_bridge/radio_link_tuned.rel)
+apps/my_bridge/radio_link_tuned.rel : C_FLAGS += -DRADIO_LINK_RX_PACKET_COUNT=16 -DRADIO_LINK_TX_PACKET_COUNT=4
+apps/my_bridge/radio_link_tuned.c : libraries/src/radio_link/radio_link.c
+	$(CP) $< $@
+TARGETS += apps/my_bridge/radio_link_tuned.c
+\endcode
  */
 
 #ifndef _RADIO_LINK
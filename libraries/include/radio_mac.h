@@ -10,8 +10,8 @@
  * in an ISR.  The higher-level code can then decide what to do next by
  * calling radioMacTx() or radioMacRx() from the event handler.
  *
- * This library does not currently support any way of turning off the
- * radio to save power.
+ * To save power, you can turn off the radio with radioMacSleep() and turn
+ * it back on with radioMacResume().
  *
  * This library defines an ISR, so radio_mac.h must be included in the
  * file that defines main() in order for this library to work.
@@ -58,6 +58,27 @@ void radioMacInit(void);
  * code to so it can use the new data. */
 void radioMacStrobe(void);
 
+/*! Turns off the radio so that the CC2511 can go into PM1 or PM2.
+ *
+ * This function saves the state of the MAC, aborts any packet that is being
+ * sent or received, puts the radio in the IDLE state, and disables the radio
+ * interrupt, so radioMacEventHandler() will not be called until
+ * radioMacResume() is called.
+ *
+ * This function must not be called from radioMacEventHandler(). */
+void radioMacSleep(void);
+
+/*! Turns the radio back on after radioMacSleep().
+ *
+ * This function sets up the radio registers again (some of them are not
+ * retained in PM2), restores the RX timeout, and re-enables the radio
+ * interrupt.  If the MAC was transmitting a packet when it went to sleep,
+ * the packet is sent again from the beginning; if it was receiving, it
+ * starts listening again with the same buffer and RX timeout.  Otherwise it
+ * calls radioMacStrobe() so that radioMacEventHandler() will soon be called
+ * with #RADIO_MAC_EVENT_STROBE to decide what the radio should do next. */
+void radioMacResume(void);
+
 /*! Sets up the radio to transmit a packet.
  *
  * \param packet A pointer to the packet to transmit.
@@ -4,6 +4,22 @@
  * does not ensure reliability, nor does it specify a format for the packet
  * contents, other than requiring the first byte of the packet to contain its
  * length. This library depends on <code>radio_mac.lib</code>.
+ *
+ * By default, this library has 16 TX packet buffers and 4 RX packet buffers.
+ * An app can change these numbers with the preprocessor symbols
+ * <code>RADIO_QUEUE_TX_PACKET_COUNT</code> and
+ * <code>RADIO_QUEUE_RX_PACKET_COUNT</code> by compiling its own copy of
+ * <code>libraries/src/radio_queue/radio_queue.c</code>, as described for
+ * radio_link.h in \ref radio_link_depths.  The same rules apply: the
+ * counts must be powers of two, the RX count must be at least 4, and the
+ * buffers must fit in <code>RADIO_QUEUE_XDATA_BUDGET</code> bytes (1024 by
+ * default).
+ *
+ * <code>radio_queue_external_rx.lib</code> is the same library compiled with
+ * <code>RADIO_QUEUE_EXTERNAL_RX_BUFFERS</code>, which leaves out the RX packet
+ * buffers.  An app that links it instead of <code>radio_queue.lib</code> must
+ * give the queue every RX buffer with radioQueueRxSetBuffer() before calling
+ * radioQueueInit().
  */
 
 #ifndef _RADIO_QUEUE
@@ -16,6 +32,10 @@
  * match radio_link's 18-byte payload + 1-byte header.) */
 #define RADIO_QUEUE_PAYLOAD_SIZE 19
 
+/*! The size of each RX packet buffer: the length byte, the payload, and the
+ * two status bytes that the radio appends to each packet it receives. */
+#define RADIO_QUEUE_RX_BUFFER_SIZE  (1 + RADIO_QUEUE_PAYLOAD_SIZE + 2)
+
 /*! Defines the frequency to use.  Valid values are from
  * 0 to 255.  To avoid interference, the channel numbers of
  * different Wixel pairs operating in the should be at least
@@ -89,4 +109,36 @@ uint8 XDATA * radioQueueRxCurrentPacket(void);  // returns 0 if no packet is ava
  * the next one.  See the radioQueueRxCurrentPacket() documentation for details. */
 void radioQueueRxDoneWithPacket(void);
 
+/*! Takes the current RX packet out of the queue without copying it, and gives
+ * the queue another buffer to receive packets into in its place.  The
+ * packet's buffer belongs to you after this, so you can keep it for as long
+ * as you want (for example while it waits to be sent to USB) and reuse it
+ * later, for example as the replacement in another call to this function.
+ *
+ * This is meant to be used with buffers from packet_pool.h: give the library
+ * pool buffers with radioQueueRxSetBuffer() before radioQueueInit(), and
+ * pass a newly allocated pool buffer as the replacement, so every packet this
+ * function returns is a pool buffer that you can pass around by handle.
+ *
+ * \param replacement A buffer of at least #RADIO_QUEUE_RX_BUFFER_SIZE bytes
+ *   that the queue can receive a packet into.
+ * \return The buffer holding the current RX packet (the same pointer that
+ *   radioQueueRxCurrentPacket() would return), or 0 if there is no RX
+ *   packet.  If it returns 0, the replacement was not used. */
+uint8 XDATA * radioQueueRxTakePacket(uint8 XDATA * replacement);
+
+/*! \return The number of RX packet buffers in the queue (4 unless the app
+ * compiles its own copy of the library with a different
+ * <code>RADIO_QUEUE_RX_PACKET_COUNT</code>). */
+uint8 radioQueueRxBufferCount(void);
+
+/*! Makes the queue receive into a buffer that you provide instead of one of
+ * its own.  This must be called before radioQueueInit(), once for each index
+ * from 0 to radioQueueRxBufferCount() - 1 that you want to replace.
+ *
+ * \param index The number of the buffer to replace.
+ * \param buffer A buffer of at least #RADIO_QUEUE_RX_BUFFER_SIZE bytes.  The
+ *   library owns it until radioQueueRxTakePacket() returns it to you. */
+void radioQueueRxSetBuffer(uint8 index, uint8 XDATA * buffer);
+
 #endif
@@ -0,0 +1,110 @@
+/*! \file ring.h
+ * Macros for lock-free ring buffers (circular queues) that pass data from
+ * one producer to one consumer, for example from an interrupt to the main
+ * loop or from the main loop to an interrupt.
+ *
+ * A ring consists of an array with a power-of-two number of elements (at
+ * most 256) and two uint8 indices:
+ *
+ * - The <b>head</b> is the index of the next element the producer will
+ *   write.  Only the producer changes it.
+ * - The <b>tail</b> is the index of the next element the consumer will
+ *   read.  Only the consumer changes it.
+ *
+ * The ring is empty when head == tail.  One element is always left unused,
+ * so that a full ring can be told apart from an empty one, so a ring of
+ * <em>size</em> elements holds at most <em>size</em>-1 elements.
+ *
+ * Because each index is a single byte that is only written by one side, no
+ * interrupts need to be disabled: the producer writes an element first and
+ * then advances the head, and the consumer reads an element first and then
+ * advances the tail.  Both indices should be declared volatile.  For speed,
+ * put them in DATA memory.
+ *
+ * The element type does not matter to these macros, so the same macros work
+ * for rings of bytes and for rings of packet buffers.  Unlike the indices,
+ * the array can be anywhere.
+ *
+ * Example:
+\code
+#define RX_BUFFER_SIZE 64
+static volatile uint8 XDATA rxBuffer[RX_BUFFER_SIZE];
+static volatile uint8 DATA rxHead = 0;  // Written by the ISR.
+static volatile uint8 DATA rxTail = 0;  // Written by the main loop.
+RING_SIZE_CHECK(rxBuffer, RX_BUFFER_SIZE)
+
+ISR(URX1, 0)
+{
+    if (RING_FREE(rxHead, rxTail, RX_BUFFER_SIZE))
+    {
+        rxBuffer[rxHead] = U1DBUF;
+        rxHead = RING_NEXT(rxHead, RX_BUFFER_SIZE);
+    }
+}
+
+uint8 receiveByte()  // Assumption: RING_USED(rxHead, rxTail, RX_BUFFER_SIZE) > 0
+{
+    uint8 byte = rxBuffer[rxTail];
+    rxTail = RING_NEXT(rxTail, RX_BUFFER_SIZE);
+    return byte;
+}
+\endcode
+ *
+ * <b>Bulk and zero-copy transfers:</b> #RING_USED_SPAN and #RING_FREE_SPAN
+ * return the number of elements that can be read or written at one place in
+ * the array, starting at the tail or head, without wrapping around.  You can
+ * process that many elements in place (with a simple loop, or with a DMA
+ * transfer to or from <code>&buffer[index]</code>; see dma.h) and then commit
+ * them all at once with #RING_ADVANCE.  A full transfer takes at most two
+ * spans.  When you use DMA, only advance the index after the transfer has
+ * finished.
+ *
+ * The macros may evaluate their arguments more than once.  If the other side
+ * can change an index while you are using it (for example, the head while
+ * the main loop is reading), copy it to a local variable first.
+ */
+
+#ifndef _RING_H
+#define _RING_H
+
+#include <cc2511_types.h>
+
+/*! Evaluates to the index that comes after <em>index</em>. */
+#define RING_NEXT(index, size)  ((uint8)((index) + 1) & (uint8)((size) - 1))
+
+/*! Adds <em>count</em> to the index variable <em>index</em>, wrapping around
+ * at the end of the ring.  This commits <em>count</em> elements that were
+ * written (if <em>index</em> is the head) or read (if it is the tail). */
+#define RING_ADVANCE(index, count, size)  ((index) = (uint8)((index) + (count)) & (uint8)((size) - 1))
+
+/*! Evaluates to the number of elements in the ring (written by the producer
+ * but not yet read by the consumer). */
+#define RING_USED(head, tail, size)  ((uint8)((head) - (tail)) & (uint8)((size) - 1))
+
+/*! Evaluates to the number of elements the producer can write before the
+ * ring is full. */
+#define RING_FREE(head, tail, size)  ((uint8)((tail) - (head) - 1) & (uint8)((size) - 1))
+
+/*! Evaluates to 1 if the ring is empty. */
+#define RING_IS_EMPTY(head, tail)  ((head) == (tail))
+
+/*! Evaluates to 1 if the ring is full. */
+#define RING_IS_FULL(head, tail, size)  (RING_NEXT(head, size) == (tail))
+
+/*! Evaluates to the number of elements the consumer can read starting at
+ * the tail without wrapping around the end of the array. */
+#define RING_USED_SPAN(head, tail, size)  \
+    ((uint8)((head) >= (tail) ? (head) - (tail) : (size) - (tail)))
+
+/*! Evaluates to the number of elements the producer can write starting at
+ * the head without wrapping around the end of the array (and without
+ * filling the unused element). */
+#define RING_FREE_SPAN(head, tail, size)  \
+    ((uint8)((tail) > (head) ? (tail) - (head) - 1 : (size) - (head) - ((tail) == 0)))
+
+/*! Generates a compiler error if <em>size</em> is not a power of two from 2
+ * to 256.  <em>name</em> must be an identifier that is unique in the file. */
+#define RING_SIZE_CHECK(name, size)  \
+    STATIC_ASSERT(name##RingSize, (size) >= 2 && (size) <= 256 && ((size) & ((size) - 1)) == 0)
+
+#endif
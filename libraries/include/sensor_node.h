@@ -0,0 +1,127 @@
+/*! \file sensor_node.h
+ * The <code>sensor_node.lib</code> library is a framework for battery-powered
+ * Wixels that wake up periodically, send a report over the radio, and then
+ * sleep in PM2 until the next report is due.
+ *
+ * Each report cycle goes like this:
+ * -# The report is due: sensorNodeReportDue() returns 1.  Your app takes
+ *    its samples, queues one or more packets with radioQueueTxCurrentPacket()
+ *    and radioQueueTxSendPacket(), and then calls sensorNodeReportQueued().
+ * -# sensorNodeService() waits until radio_queue has transmitted all the
+ *    packets.
+ * -# If acknowledgments are enabled, sensorNodeService() waits for an
+ *    acknowledgment packet from the receiver.  If none arrives in time, the
+ *    report becomes due again, up to the maximum number of attempts.
+ * -# The node sleeps: sensorNodeMsUntilWake() returns the time until
+ *    shortly before the next report, and powerIdle() uses it to put the
+ *    CC2511 in PM2 with the radio turned off.
+ *
+ * Example:
+ *
+\code
+void main()
+{
+    systemInit();
+    usbInit();
+    sensorNodeInit(1000, 0, 1);  // Report every second, without acknowledgments.
+
+    while(1)
+    {
+        boardService();
+        usbComService();
+        sensorNodeService();
+
+        if (sensorNodeReportDue() && radioQueueTxCurrentPacket())
+        {
+            // ... fill in the packet ...
+            radioQueueTxSendPacket();
+            sensorNodeReportQueued();
+        }
+
+        powerIdle(sensorNodeMsUntilWake());
+    }
+}
+\endcode
+ *
+ * \section sensor_node_ack Acknowledgments
+ *
+ * An acknowledgment is a radio_queue packet whose payload is the 4-byte
+ * serial number of the node that sent the report (see sensor_node_ack.h).
+ * The receiver should send one back for each report it receives.
+ * While it is waiting for an acknowledgment, sensorNodeService() only looks
+ * at the first packet in the radio_queue RX queue, so your app should
+ * process or discard any other packets it receives (see sensorNodeIsAck()).
+ *
+ * \section sensor_node_timing Timing
+ *
+ * getMs() keeps counting while the node sleeps (see powerSleep()), so the
+ * reports stay on schedule.  The node wakes up #SENSOR_NODE_WAKE_MARGIN_MS
+ * milliseconds early to allow for restarting the crystal oscillator, and
+ * waits for the rest of the time in PM0.  While asleep, time is measured by
+ * the CC2511's low-power RC oscillator, so the report period is only
+ * accurate to about 1%.
+ *
+ * While USB power is present, the node never goes below PM0 so that it
+ * stays connected to the computer, and the radio stays on.
+ *
+ * This library depends on <code>power.lib</code>,
+ * <code>radio_queue.lib</code>, and <code>wixel.lib</code>.
+ */
+
+#ifndef _SENSOR_NODE_H
+#define _SENSOR_NODE_H
+
+#include <cc2511_types.h>
+#include <radio_queue.h>
+#include <power.h>
+#include <sensor_node_ack.h>
+
+/*! The node wakes up from PM2 this many milliseconds before the next report
+ * is due. */
+#define SENSOR_NODE_WAKE_MARGIN_MS  1
+
+/*! Initializes the radio_queue library and this library, and registers
+ * this library and the USB module (see powerRegisterUsb()) with the power
+ * manager.  The first report is due immediately.
+ *
+ * \param periodMs The time between the starts of consecutive reports,
+ *   from 1 to 32767 ms.
+ * \param ackTimeoutMs How long to wait for an acknowledgment after all the
+ *   packets of a report are sent, in milliseconds.  Pass 0 to not wait for
+ *   acknowledgments.
+ * \param maxAttempts The maximum number of times to send each report when
+ *   it is not acknowledged.  This must be at least 1. */
+void sensorNodeInit(uint16 periodMs, uint8 ackTimeoutMs, uint8 maxAttempts);
+
+/*! Takes care of waiting for the radio, for acknowledgments, and for the next
+ * report time.  This should be called regularly from your main loop. */
+void sensorNodeService(void);
+
+/*! \return 1 if your app should send a report now, or 0 otherwise. */
+BIT sensorNodeReportDue(void);
+
+/*! Tells the library that all the packets of the report are in the radio_queue
+ * TX queue. */
+void sensorNodeReportQueued(void);
+
+/*! \return The number of times the current report has been sent, including
+ * the current attempt.  Call this when sensorNodeReportDue() returns 1 to
+ * find out whether the report is a retry (2 or more). */
+uint8 sensorNodeAttempt(void);
+
+/*! \return 1 if the packet is an acknowledgment for this node, or 0
+ * otherwise.
+ * \param packet A packet from radioQueueRxCurrentPacket(). */
+BIT sensorNodeIsAck(uint8 XDATA * packet);
+
+/*! \return 1 if the current report cycle is over and the node is waiting for
+ * the next one, or 0 otherwise. */
+BIT sensorNodeSleeping(void);
+
+/*! \return The time the node can sleep before the next report, in
+ * milliseconds, or 1 if it is not sleeping (so powerIdle() can still halt
+ * the CPU in PM0 while the node waits for the radio).  Pass this to
+ * powerIdle(). */
+uint16 sensorNodeMsUntilWake(void);
+
+#endif
@@ -0,0 +1,20 @@
+/*! \file sensor_node_ack.h
+ * This file defines the format of the acknowledgment packets used by the
+ * <code>sensor_node.lib</code> library (see sensor_node.h).  A receiver
+ * that acknowledges reports from sensor nodes only needs to include this
+ * file; it does not need to link to <code>sensor_node.lib</code>.
+ *
+ * An acknowledgment is a radio_queue packet whose payload is the 4-byte
+ * serial number of the node that sent the report, in the same order as
+ * ::serialNumber.
+ */
+
+#ifndef _SENSOR_NODE_ACK_H
+#define _SENSOR_NODE_ACK_H
+
+/*! The payload length of an acknowledgment packet.  Byte 0 of the packet
+ * is the length and bytes 1-4 are the serial number of the node being
+ * acknowledged (the same order as ::serialNumber). */
+#define SENSOR_NODE_ACK_LENGTH  4
+
+#endif
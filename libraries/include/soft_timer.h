@@ -0,0 +1,105 @@
+/*! \file soft_timer.h
+ * The <code>soft_timer.lib</code> library lets you schedule functions to be
+ * called after a delay or periodically, without writing
+ * <code>(uint16)(getMs() - last) >= period</code> checks in your main loop.
+ *
+ * Each timer is a ::SOFT_TIMER struct that you allocate (usually as a global
+ * variable in XDATA).  Start a timer with softTimerStart(), and call
+ * softTimerService() regularly from your main loop.  When a timer expires,
+ * softTimerService() calls the timer's callback function from the main loop,
+ * so the callback can safely call any other function in the SDK.
+ *
+ * The running timers are kept in a list sorted by deadline.  The time base
+ * is the millisecond tick from the Timer 4 interrupt (see time.h).  When no
+ * timer has expired, softTimerService() returns after a single comparison.
+ * Starting or stopping a timer takes time proportional to the number of
+ * running timers, because it has to find the timer's place in the list.
+ *
+ * softTimerMsUntilNext() returns the time until the next deadline by looking
+ * only at the first timer in the list, so your main loop can sleep until
+ * then.
+ *
+ * Example:
+ *
+\code
+SOFT_TIMER XDATA blinkTimer;
+
+void blink()
+{
+    LED_YELLOW_TOGGLE();
+}
+
+void main()
+{
+    systemInit();
+    softTimerStart(&blinkTimer, 250, 250, blink);  // Blink every 250 ms.
+    while(1)
+    {
+        boardService();
+        softTimerService();
+    }
+}
+\endcode
+ *
+ * The delays and periods are 16-bit numbers of milliseconds, so the longest
+ * delay you can use is 32767 ms.
+ */
+
+#ifndef _SOFT_TIMER_H
+#define _SOFT_TIMER_H
+
+#include <cc2511_types.h>
+
+/*! The type of function called when a timer expires. */
+typedef void (SoftTimerCallback)(void);
+
+/*! Holds the state of one software timer.  The fields of this struct should
+ * only be modified by the functions in this library. */
+typedef struct SOFT_TIMER
+{
+    /*! The running timer with the next later deadline. */
+    struct SOFT_TIMER XDATA * next;
+
+    /*! The lower 16 bits of getMs() at which the timer expires. */
+    uint16 deadline;
+
+    /*! The period of the timer in milliseconds, or 0 for a one-shot timer. */
+    uint16 period;
+
+    /*! The function to call when the timer expires. */
+    SoftTimerCallback * callback;
+
+    /*! 1 if the timer is running, 0 otherwise. */
+    uint8 active;
+} SOFT_TIMER;
+
+/*! Starts (or restarts) a timer.
+ *
+ * \param timer A pointer to the timer.
+ * \param delayMs The number of milliseconds from now until the callback
+ *   is first called.  A delay of 0 is treated as 1.
+ * \param periodMs The period in milliseconds for a periodic timer,
+ *   or 0 for a one-shot timer.  A periodic timer keeps the same average
+ *   period even if the main loop calls softTimerService() a little late;
+ *   if it falls behind by a full period, the missed calls are skipped.
+ * \param callback The function to call when the timer expires. */
+void softTimerStart(SOFT_TIMER XDATA * timer, uint16 delayMs, uint16 periodMs, SoftTimerCallback * callback);
+
+/*! Stops a timer so that its callback will not be called.
+ * It is OK to stop a timer that is not running. */
+void softTimerStop(SOFT_TIMER XDATA * timer);
+
+/*! \return 1 if the timer is running, 0 otherwise.  A one-shot timer stops
+ * running just before its callback is called. */
+#define softTimerActive(timer)  ((timer)->active)
+
+/*! Calls the callbacks of all the timers that have expired.
+ * This should be called regularly from the main loop. */
+void softTimerService(void);
+
+/*! \return The number of milliseconds until the next timer expires,
+ * 0 if a timer has already expired but has not been serviced yet, or
+ * 0xFFFF if no timers are running. */
+uint16 softTimerMsUntilNext(void);
+
+#endif
@@ -0,0 +1,186 @@
+/*! \file task.h
+ * The <code>task.lib</code> library lets you write parts of your app as
+ * cooperative tasks: functions that look like sequential, blocking code but
+ * actually return to the main loop whenever they have to wait.
+ *
+ * The tasks are stackless coroutines in the style of Adam Dunkels'
+ * protothreads.  A task function remembers the line where it stopped in its
+ * ::TASK struct and jumps back there the next time it runs, so tasks need
+ * no stack of their own and work with SDCC's default (non-reentrant)
+ * calling convention.
+ *
+ * A task can wait for:
+ * - Time: #TASK_WAIT_MS puts the task in a list of sleeping tasks that is
+ *   sorted by wake-up time.
+ * - Events: #TASK_WAIT_EVENT waits until another task or an interrupt calls
+ *   #taskEventSignal on a ::TASK_EVENT.
+ * - Any other condition, such as buffer space becoming available:
+ *   #TASK_WAIT_UNTIL re-checks the condition once per call to taskService().
+ *
+ * Tasks that are sleeping or waiting for an event are not in the run queue,
+ * so they take no CPU time at all until they are woken up.
+ *
+ * Example:
+ *
+\code
+TASK XDATA blinkTask;
+
+TASK_FUNCTION(blink)
+{
+    TASK_BEGIN();
+    while(1)
+    {
+        LED_YELLOW(1);
+        TASK_WAIT_MS(100);
+        LED_YELLOW(0);
+        TASK_WAIT_UNTIL(usbComRxAvailable());   // Wait for a byte from USB.
+        usbComRxReceiveByte();
+    }
+    TASK_END();
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    taskStart(&blinkTask, blink);
+    while(1)
+    {
+        boardService();
+        usbComService();
+        taskService();
+    }
+}
+\endcode
+ *
+ * \section limitations Limitations
+ *
+ * - The values of local variables are not preserved while a task waits.
+ *   Use static or global variables for anything that needs to be remembered
+ *   across a wait.
+ * - The waiting macros can only be used directly in the task function, not
+ *   in functions that it calls.
+ * - Do not use a switch statement in the same function as a waiting
+ *   macro if the switch statement contains the wait.
+ * - The longest time a task can wait with #TASK_WAIT_MS is 32767 ms.
+ *
+ * This library depends on <code>wixel.lib</code> for getMs().
+ */
+
+#ifndef _TASK_H
+#define _TASK_H
+
+#include <cc2511_types.h>
+#include <time.h>
+
+/*! Returned by a task function when it wants to run again on the next pass. */
+#define TASK_STATUS_YIELDED   0
+/*! Returned by a task function when it is sleeping until ::TASK::wakeTime. */
+#define TASK_STATUS_SLEEPING  1
+/*! Returned by a task function when it is waiting for ::TASK::event. */
+#define TASK_STATUS_WAITING   2
+/*! Returned by a task function when it is finished. */
+#define TASK_STATUS_ENDED     3
+
+struct TASK;
+struct TASK_EVENT;
+
+/*! The type of a task function.  Use #TASK_FUNCTION to define one. */
+typedef uint8 (TaskFunction)(struct TASK XDATA * task);
+
+/*! Holds the state of one task.  The fields of this struct should only be
+ * modified by the macros and functions in this library. */
+typedef struct TASK
+{
+    /*! The next task in the run queue, the sleep list, or an event's wait list. */
+    struct TASK XDATA * next;
+
+    /*! The function that implements the task. */
+    TaskFunction * function;
+
+    /*! The line where the task function will continue when it runs again,
+     * or 0 to start from the beginning. */
+    uint16 line;
+
+    /*! The lower 16 bits of getMs() when a sleeping task should wake up. */
+    uint16 wakeTime;
+
+    /*! The event that the task is waiting for. */
+    struct TASK_EVENT XDATA * event;
+
+    /*! 1 if the task was started and has not ended yet. */
+    uint8 running;
+} TASK;
+
+/*! An event that tasks can wait for.  An event is either signaled or not.
+ * When it is signaled, the first task that finishes waiting for it clears
+ * it again, so each signal wakes up one waiting task (or lets the next
+ * task that waits for it continue immediately). */
+typedef struct TASK_EVENT
+{
+    /*! The next event in the list of events that have waiting tasks. */
+    struct TASK_EVENT XDATA * nextArmed;
+
+    /*! The tasks waiting for this event. */
+    struct TASK XDATA * waiters;
+
+    /*! 1 if the event is signaled. */
+    volatile uint8 signaled;
+} TASK_EVENT;
+
+/*! Signals an event.  This is a single byte write, so it can be done from an
+ * interrupt.  Waiting tasks will run on the next call to taskService(). */
+#define taskEventSignal(evt)  ((evt)->signaled = 1)
+
+/*! Defines (or declares) a task function with the given name. */
+#define TASK_FUNCTION(name)  uint8 name(TASK XDATA * task)
+
+/*! Must be the first statement of a task function. */
+#define TASK_BEGIN()  switch(task->line) { case 0:
+
+/*! Must be the last statement of a task function.  If the task gets here,
+ * it ends. */
+#define TASK_END()  } task->line = 0; return TASK_STATUS_ENDED
+
+/*! Lets the other tasks run.  The task continues on the next call to
+ * taskService(). */
+#define TASK_YIELD() \
+    do { task->line = __LINE__; return TASK_STATUS_YIELDED; case __LINE__:; } while(0)
+
+/*! Waits until the condition is true.  The condition is evaluated once each
+ * time taskService() is called, so while the task is waiting it costs one
+ * call to the task function per pass of the main loop. */
+#define TASK_WAIT_UNTIL(condition) \
+    do { task->line = __LINE__; case __LINE__: if (!(condition)) { return TASK_STATUS_YIELDED; } } while(0)
+
+/*! Waits for the specified number of milliseconds (0 to 32767).
+ * The task takes no CPU time while it is waiting. */
+#define TASK_WAIT_MS(ms) \
+    do { task->line = __LINE__; task->wakeTime = (uint16)getMs() + (ms); return TASK_STATUS_SLEEPING; case __LINE__:; } while(0)
+
+/*! Waits until the event is signaled, then clears it.  If the event is
+ * already signaled, the task does not wait.  The task takes no CPU time
+ * while it is waiting. */
+#define TASK_WAIT_EVENT(evt) \
+    do { task->line = __LINE__; case __LINE__: if (!(evt)->signaled) { task->event = (evt); return TASK_STATUS_WAITING; } (evt)->signaled = 0; } while(0)
+
+/*! Ends the task immediately. */
+#define TASK_EXIT()  do { task->line = 0; return TASK_STATUS_ENDED; } while(0)
+
+/*! Starts a task.  The task function will run for the first time the next
+ * time taskService() is called.  Do not call this for a task that is
+ * already running.
+ * \param task A pointer to the task's state.
+ * \param function The task function. */
+void taskStart(TASK XDATA * task, TaskFunction * function);
+
+/*! Wakes up the sleeping tasks whose time has come and the tasks whose
+ * events have been signaled, and then runs each task in the run queue once.
+ * This should be called regularly from the main loop.
+ *
+ * \return The number of tasks in the run queue after this call.
+ *   If it is zero, no task needs to run until the next sleeping task wakes up
+ *   or an event is signaled. */
+uint8 taskService(void);
+
+#endif
@@ -1,8 +1,10 @@
 /*! \file time.h
- * This module helps you keep track of time in milliseconds.
- * Calling timeInit() sets up a timer (Timer 4) to overflow every millisecond
- * (approximately).
- * You can read the time at any time by calling getMs().
+ * This module helps you keep track of time in milliseconds and microseconds.
+ * Calling timeInit() sets up a timer (Timer 4) to overflow every millisecond.
+ * The period alternates between 188 and 187 ticks of 5.33 microseconds each,
+ * so the interrupts occur precisely 1.000 ms apart on average.
+ * You can read the time at any time by calling getMs() or getUs().
+ * Neither of those functions disables interrupts.
  * For the interrupt to work, you must write
  * <pre>include <time.h></pre>
  * or
@@ -20,7 +22,7 @@
 
 #include <cc2511_map.h>
 
-/*! Initializes the library.  This sets up Timer 4 to tick (approximately)
+/*! Initializes the library.  This sets up Timer 4 to tick
  * every millisecond and enables the Timer 4 interrupt.  Note that you
  * will also have to call boardClockInit() or systemInit(), to get the system clock running
  * at the right speed, otherwise the millisecond timing will be off by a
@@ -33,10 +35,93 @@ void timeInit();
  * was called. */
 uint32 getMs();
 
-/*! This interrupt fires once per millisecond (approximately) and
+/*! Returns the number of microseconds that have elapsed since timeInit()
+ * was called.  The value is monotonic and has a resolution of 5.33 microseconds
+ * (one tick of Timer 4).  It overflows about every 71.6 minutes, so use
+ * unsigned subtraction to compute time differences.
+ *
+ * This function can be called from the main loop or from an interrupt.
+ * In an interrupt, #TIME_CAPTURE is cheaper. */
+uint32 getUs();
+
+/*! Adds the specified number of milliseconds to the time returned by getMs()
+ * and getUs().  This is used by <code>power.lib</code> after sleeping in a
+ * power mode where Timer 4 does not run, so that the time stays continuous.
+ * It should not be called from an interrupt. */
+void timeAdvance(uint16 milliseconds);
+
+/*! A raw timestamp captured by #TIME_CAPTURE.  Use #TIME_STAMP_TO_US to
+ * convert it to the same units as getUs(). */
+typedef struct TIME_STAMP
+{
+    /*! The value of ::timeUsBase at the time of the capture. */
+    uint32 usBase;
+
+    /*! The value of the Timer 4 counter at the time of the capture. */
+    uint8 ticks;
+} TIME_STAMP;
+
+/*! The time, in microseconds, at which the current millisecond started.
+ * This is updated by the T4 ISR; you should not write to it. */
+extern PDATA volatile uint32 timeUsBase;
+
+/*! Converts a number of Timer 4 ticks (0-187) to microseconds using only
+ * shifts and additions.  The result is accurate to within 1 microsecond. */
+#define TIME_TICKS_TO_US(ticks) (((uint16)(ticks) << 2) + (uint16)(ticks) + \
+    ((((uint16)(ticks) << 6) + ((uint16)(ticks) << 4) + ((uint16)(ticks) << 2) + (uint16)(ticks)) >> 8))
+
+/*! Captures the current time into a #TIME_STAMP.
+ *
+ * This macro is meant to be used in interrupt service routines that have the
+ * same or higher priority than the Timer 4 interrupt (this includes every ISR
+ * if you have not changed the interrupt priorities).  It takes only a few
+ * instructions and does not call any functions.
+ *
+ * \param stamp A #TIME_STAMP variable (not a pointer). */
+#define TIME_CAPTURE(stamp) \
+    { \
+        (stamp).ticks = T4CNT; \
+        if (T4IF) { (stamp).ticks = T4CNT; (stamp).usBase = timeUsBase + 1000; } \
+        else { (stamp).usBase = timeUsBase; } \
+    }
+
+/*! Converts a #TIME_STAMP captured by #TIME_CAPTURE to microseconds, in the
+ * same units as getUs(). */
+#define TIME_STAMP_TO_US(stamp) ((stamp).usBase + TIME_TICKS_TO_US((stamp).ticks))
+
+/*! This interrupt fires once per millisecond and
  * increments timeMs. */
 ISR(T4, 0);
 
+/*! Returns a deadline the specified number of microseconds in the future,
+ * for use with timeUsPassed().  The delay can be up to 2147483647 us.
+ *
+ * Deadlines let you wait for something without blocking.  For example:
+ *
+\code
+uint32 deadline = timeDeadlineUs(500);
+startConversion();
+doOtherWork();
+while(!timeUsPassed(deadline)){}   // Wait for the rest of the 500 us.
+\endcode
+ */
+#define timeDeadlineUs(microseconds)  (getUs() + (uint32)(microseconds))
+
+/*! Returns 1 if the specified deadline from timeDeadlineUs() has passed. */
+#define timeUsPassed(deadline)  ((int32)(getUs() - (deadline)) >= 0)
+
+/*! Returns a deadline the specified number of milliseconds in the future,
+ * for use with timeMsPassed(). */
+#define timeDeadlineMs(milliseconds)  (getMs() + (uint32)(milliseconds))
+
+/*! Returns 1 if the specified deadline from timeDeadlineMs() has passed. */
+#define timeMsPassed(deadline)  ((int32)(getMs() - (deadline)) >= 0)
+
+/*! delayUs() uses delayMicroseconds() for delays shorter than this, because
+ * reading the time with getUs() takes several microseconds and the resolution
+ * of Timer 4 is 5.33 microseconds. */
+#define DELAY_US_TIMER_THRESHOLD  100
+
 /*! \param microseconds  The number of microseconds delay; any value between 0 and 255.
  *
  *  This function delays for the specified number of microseconds using
@@ -44,11 +129,28 @@ ISR(T4, 0);
  *  will be longer than specified. */
 void delayMicroseconds(uint8 microseconds);
 
+/*! \param microseconds  The number of microseconds delay; any value between 0 and 65535.
+ *
+ *  Delays of #DELAY_US_TIMER_THRESHOLD microseconds or more are measured
+ *  with getUs(), so interrupts that occur during the delay do not make it
+ *  longer (unless an interrupt is still running when the time is up).
+ *  The delay will be up to about 10 microseconds longer than specified.
+ *
+ *  Shorter delays, and all delays while interrupts or Timer 4 are disabled,
+ *  use delayMicroseconds().
+ *
+ *  In an interrupt, the T4 ISR can not run, so the delay is measured by
+ *  counting Timer 4 ticks instead, and other interrupts that occur during
+ *  it make it longer. */
+void delayUs(uint16 microseconds);
+
 /*! \param milliseconds  The number of milliseconds delay; any value between 0 and 65535.
  *
- *  This function delays for the specified number of milliseconds using
- *  a simple loop.  If an interrupt occurs during this function, the delay
- *  will be slightly longer than specified. */
+ *  This function measures the delay with getUs(), so interrupts that occur
+ *  during the delay do not make it longer.  If interrupts or Timer 4 are
+ *  disabled, it uses a simple loop instead, and the delay will be slightly
+ *  longer than specified.  In an interrupt, the delay is measured by
+ *  counting Timer 4 ticks, so higher-priority interrupts make it longer. */
 void delayMs(uint16 milliseconds);
 
 #endif
@@ -21,6 +21,15 @@
  * For UART0, this library uses Alternative Location 1: P0_3 is TX, P0_2 is RX.
  * For UART1, this library uses Alternative Location 2: P1_6 is TX, P1_7 is RX.
  * This library does not yet allow you to choose which UART location to use.
+ *
+ * Each UART has a 256-byte TX buffer and a 256-byte RX buffer, which can
+ * hold up to 255 bytes each.  To use less RAM, or to trade TX buffer for RX
+ * buffer, an app can compile its own copy of
+ * <code>libraries/src/uart/core/uart.c</code> with the preprocessor symbol
+ * <code>UART0</code> or <code>UART1</code> and the symbols
+ * <code>UART_TX_BUFFER_SIZE</code> and <code>UART_RX_BUFFER_SIZE</code>,
+ * as described for radio_link.h in \ref radio_link_depths.  The sizes must
+ * be powers of two from 2 to 256.
  */
 
 #ifndef _UART0_H
@@ -22,6 +22,7 @@
 #define _USB_H
 
 #include <cc2511_types.h>
+#include <cc2511_map.h>
 
 /*! This is the Vendor ID assigned to Pololu Corporation by the USB
  * Implementers Forum (USB-IF).
@@ -215,6 +216,11 @@ typedef struct USB_DESCRIPTOR_ENDPOINT
 // USBCSIL register bit values
 #define USBCSIL_INPKT_RDY    0x01
 #define USBCSIL_PKT_PRESENT  0x02
+#define USBCSIL_UNDERRUN     0x04
+
+// USBCSIH register bit values
+#define USBCSIH_IN_DBL_BUF   0x01
+#define USBCSIH_ISO          0x40
 
 /* HELPERS ********************************************************************/
 
@@ -229,6 +235,12 @@ typedef struct USB_DESCRIPTOR_ENDPOINT
  * See the usb_cdc_acm.c for an example use. */
 #define DEFINE_STRING_DESCRIPTOR(name,char_count,...) static uint16 CODE name[] = { (2*(char_count+1)) | (USB_DESCRIPTOR_TYPE_STRING<<8), __VA_ARGS__ };
 
+/*! Expands to the FIFO register of the specified endpoint (e.g. USBF4).
+ * The argument must be a number, or a macro that expands to a number,
+ * so that libraries can choose their endpoints with preprocessor flags. */
+#define USB_FIFO(endpoint) USB_FIFO_(endpoint)
+#define USB_FIFO_(endpoint) USBF##endpoint
+
 /* PROTOTYPES DEFINED BY LIBUSB ***********************************************/
 
 /*! The current USB Device State of this device.
@@ -255,9 +267,35 @@ void usbInit(void);
  * This function calls the usbCallback* functions when needed.
  *
  * This function should be called regularly (more often than every 50&nbsp;ms).
+ *
+ * In interrupt mode (see usbEnableInterrupt()), this function only detects
+ * when the USB cable is connected and disconnected.
  */
 void usbPoll(void);
 
+/*! Switches the USB library to interrupt mode.  In interrupt mode, the USB
+ * interrupt handles control transfers on endpoint 0 and the Reset, Suspend,
+ * and Resume events as soon as they happen, so the computer does not have to
+ * wait for your main loop to call usbPoll().  This is useful if your main
+ * loop sometimes blocks for a long time (for example, while waiting for an
+ * I2C transaction to time out).
+ *
+ * This should be called once, right after usbInit().  You must still call
+ * usbPoll() (or the service function of your USB class library) regularly,
+ * because it detects when the USB cable is connected and it services the
+ * other endpoints; the API of the class libraries does not change.
+ *
+ * In interrupt mode, the usbCallback* functions run in the USB interrupt, so
+ * they must not call non-reentrant functions that the main loop might be
+ * running (such as getMs() or printf()).  The callbacks in the class
+ * libraries that come with the Wixel SDK follow this rule.
+ *
+ * For this to work, you must include usb.h in the file that defines main(). */
+void usbEnableInterrupt(void);
+
+/*! 1 if usbEnableInterrupt() has been called. */
+extern BIT usbInterruptMode;
+
 /*! Tells the USB library to start a Control Read
  * (Device-to-Host) transfer.
  *
@@ -315,6 +353,59 @@ void usbInitEndpointIn(uint8 endpointNumber, uint8 maxPacketSize);
  * This should only be called from usbCallbackInitEndpoints(). */
 void usbInitEndpointOut(uint8 endpointNumber, uint8 maxPacketSize);
 
+/*! Configures the specified endpoint to do double-buffered isochronous IN
+ * (device-to-host) transactions.
+ *
+ * The computer reads one packet from an isochronous endpoint in every USB
+ * frame (every 1&nbsp;ms).  The packet that is in the FIFO at that time is
+ * sent without any retries; if no packet is ready, the USB module sends an
+ * empty packet and sets the #USBCSIL_UNDERRUN bit.  To keep up, load a new
+ * packet whenever the #USBCSIL_INPKT_RDY bit is 0.
+ *
+ * Both buffers must fit in the IN half of the endpoint's FIFO, so
+ * <em>maxPacketSize</em> can be at most 8, 16, 32, 64, or 128 bytes for
+ * endpoints 1 through 5, respectively.
+ *
+ * This should only be called from usbCallbackInitEndpoints(). */
+void usbInitEndpointIsoIn(uint8 endpointNumber, uint16 maxPacketSize);
+
+/*! The maximum number of interfaces that can have alternate settings. */
+#define USB_MAX_INTERFACES 8
+
+/*! The type of function that handles Set Interface requests.  It should
+ * read the interface number from usbSetupPacket.wIndex and the alternate
+ * setting from usbSetupPacket.wValue, and return 1 if that alternate setting
+ * exists or 0 if it does not (the USB library will then respond with a
+ * STALL packet). */
+typedef uint8 (UsbSetInterfaceHandler)(void);
+
+/*! A pointer to a function that will be called when the host selects an
+ * alternate setting of an interface with a Set Interface request.  This is
+ * needed by devices that have interfaces with alternate settings, such as
+ * USB Audio devices, which use alternate setting 0 of their streaming
+ * interface to use no bandwidth and alternate setting 1 to stream.
+ *
+ * It is called by usbPoll() (or by the USB interrupt in interrupt mode).
+ * The default value is 0, which means that only alternate setting 0 is
+ * accepted. */
+extern UsbSetInterfaceHandler * usbSetInterfaceHandler;
+
+/*! The alternate setting that the host has selected for each interface.
+ * They are all reset to 0 when the device is reset or configured. */
+extern uint8 XDATA usbAlternateSetting[USB_MAX_INTERFACES];
+
+/*! Searches the configuration descriptor for a class-specific descriptor
+ * that belongs to an interface, such as the HID descriptor of a HID interface.
+ *
+ * \param interfaceNumber The bInterfaceNumber of the interface.
+ * \param descriptorType The bDescriptorType of the descriptor to find.
+ * \return A pointer to the first descriptor of that type between the
+ *   interface's Interface Descriptor and the next Interface Descriptor,
+ *   or 0 if there is none.
+ *
+ * This is useful in usbCallbackClassDescriptorHandler(). */
+uint8 CODE * usbFindClassDescriptor(uint8 interfaceNumber, uint8 descriptorType);
+
 /*! Writes the specified data to a USB FIFO.
  * This is equivalent to writing data to the FIFO register (e.g. USBF4)
  * one byte at a time.
@@ -329,6 +420,46 @@ void usbWriteFifo(uint8 endpointNumber, uint8 count, const uint8 XDATA * buffer)
  * can not read data from a USB FIFO. */
 void usbReadFifo(uint8 endpointNumber, uint8 count, uint8 XDATA * buffer);
 
+/*! The type of function called by the USB interrupt when packets arrive on
+ * OUT endpoints.  The argument is the value of the USBOIF register: bit N is 1
+ * if a packet was received on endpoint N. */
+typedef void (UsbOutInterruptHandler)(uint8 endpointFlags);
+
+/*! Enables the USB interrupt for packets received on the specified OUT
+ * endpoints, so that they can be read from the FIFO without waiting for
+ * the main loop.
+ *
+ * \param endpointMask Bit N should be 1 to enable the interrupt for OUT
+ *   endpoint N (1-5).
+ * \param handler The function to call from the USB ISR.  It runs in an
+ *   interrupt, so it must not call non-reentrant functions that the main
+ *   loop might be running (including usbReadFifo()).  The ISR saves and
+ *   restores USBINDEX around the call.
+ *
+ * The interrupt only handles the OUT endpoints.  The other USB events
+ * (such as control transfers on endpoint 0) are still handled by usbPoll(),
+ * unless usbEnableInterrupt() has been called.
+ *
+ * For this to work, you must include usb.h in the file that defines main(). */
+void usbEnableOutInterrupt(uint8 endpointMask, UsbOutInterruptHandler * handler);
+
+/*! Disables the USB interrupt so that main-loop code can safely access data
+ * shared with a #UsbOutInterruptHandler or with the usbCallback* functions
+ * in interrupt mode.  Call #USB_INTERRUPT_RESTORE afterwards. */
+#define USB_INTERRUPT_DISABLE()  (IEN2 &= ~(1<<1))
+
+/*! Re-enables the USB interrupt after #USB_INTERRUPT_DISABLE, if
+ * usbEnableOutInterrupt() or usbEnableInterrupt() has been called. */
+#define USB_INTERRUPT_RESTORE()  { if (usbOutInterruptMask || usbInterruptMode){ IEN2 |= (1<<1); } }
+
+/*! The endpoint mask passed to usbEnableOutInterrupt(), or 0 if the USB
+ * interrupt is not being used. */
+extern uint8 XDATA usbOutInterruptMask;
+
+/*! The USB interrupt.  It is only enabled if usbEnableOutInterrupt() or
+ * usbEnableInterrupt() is called. */
+ISR(USB, 0);
+
 /*! Returns 1 if we are connected to a USB bus that is suspended.
  * Returns 0 otherwise.
  *
@@ -436,7 +567,7 @@ extern uint8 CODE usbStringDescriptorCount;
  * See usb_cdc_acm.c for an example. */
 extern uint16 CODE * CODE usbStringDescriptors[];
 
-/*! This is called by usbPoll() whenever a new request (SETUP packet) is received
+/*! This is called by usbPoll() (or by the USB interrupt in interrupt mode) whenever a new request (SETUP packet) is received
  * from the host that can not be handled by the USB library.
  *
  * This function should read #usbSetupPacket.
@@ -449,7 +580,7 @@ extern uint16 CODE * CODE usbStringDescriptors[];
  * See usb_cdc_acm.c for an example. */
 void usbCallbackSetupHandler(void);
 
-/*! This is called by usbPoll() whenever a Get Descriptor request is received by
+/*! This is called by usbPoll() (or by the USB interrupt in interrupt mode) whenever a Get Descriptor request is received by
  * the host that can not be handled by the USB library.
  *
  * This function should read #usbSetupPacket.
@@ -461,7 +592,7 @@ void usbCallbackSetupHandler(void);
  * See usb_hid.c for an example. */
 void usbCallbackClassDescriptorHandler(void);
 
-/*! This is called by usbPoll() when the device enters the Configured state.
+/*! This is called by usbPoll() (or by the USB interrupt in interrupt mode) when the device enters the Configured state.
  * This function should call usbInitEndpointIn() and usbInitEndpointOut()
  * to initialize all the non-zero endpoints that it uses.
  *
@@ -469,7 +600,7 @@ void usbCallbackClassDescriptorHandler(void);
  * See usb_cdc_acm.c for an example. */
 void usbCallbackInitEndpoints(void);
 
-/*! This is called by usbPoll() when all the data for a Control Write
+/*! This is called by usbPoll() (or by the USB interrupt in interrupt mode) when all the data for a Control Write
  * request has been received.
  *
  * This function should look at the data, perform any actions necessary,
@@ -0,0 +1,106 @@
+/*! \file usb_bulk.h
+ * The <code>usb_bulk.lib</code> library implements a USB device with one
+ * vendor-specific interface that has a bulk IN endpoint and a bulk OUT
+ * endpoint.  It is an alternative to <code>usb_cdc_acm.lib</code> (usb_com.h)
+ * for apps that need to move a lot of raw data to or from the computer,
+ * such as data loggers: there are no control lines or line coding to worry
+ * about, and the computer talks to the device directly (for example with
+ * libusb, WinUSB, or Linux usbfs) instead of through a serial port driver.
+ *
+ * The data is sent and received in packets of up to #USB_BULK_PACKET_SIZE
+ * bytes.  Both endpoints are double buffered, so the USB module can transfer
+ * one packet while your main loop reads or writes the other one.
+ * The packets are copied between your buffers and the endpoint FIFOs by DMA
+ * channel #DMA_CHANNEL_USB, which is several times faster than copying them
+ * with the CPU.
+ *
+ * Example:
+ *
+\code
+uint8 XDATA buffer[USB_BULK_PACKET_SIZE];
+
+void main()
+{
+    systemInit();
+    usbInit();
+
+    while(1)
+    {
+        boardService();
+        usbBulkService();
+
+        // Echo every packet back to the computer.
+        if (usbBulkTxAvailable() && usbBulkRxAvailable())
+        {
+            usbBulkTxSend(buffer, usbBulkRxReceive(buffer));
+        }
+    }
+}
+\endcode
+ *
+ * To reach the maximum throughput of a full-speed USB device (about
+ * 1 MB/s), the computer should have several large transfers pending at
+ * the same time, and your main loop should call usbBulkService() and
+ * refill the IN endpoint as often as possible.
+ *
+ * The device uses product ID 0x2202.  Because it uses a vendor-specific
+ * interface class, no driver is loaded for it automatically: on Linux, the
+ * computer can access it through /dev/bus/usb (see the host program in
+ * apps/test_usb_bulk/host), and on Windows it needs a WinUSB driver.
+ *
+ * This library depends on <code>usb.lib</code>, <code>dma.lib</code>, and
+ * <code>wixel.lib</code>.
+ */
+
+#ifndef _USB_BULK_H
+#define _USB_BULK_H
+
+#include <cc2511_types.h>
+#include <usb.h>
+
+/*! The maximum size of the packets on the bulk endpoints, in bytes.
+ * This is the largest size allowed for full-speed bulk endpoints. */
+#define USB_BULK_PACKET_SIZE  64
+
+/*! The vendor-specific request (bmRequestType = 0x40) that makes the Wixel
+ * start its bootloader shortly after the request is acknowledged. */
+#define USB_BULK_REQUEST_START_BOOTLOADER  0xFF
+
+/*! Takes care of the USB module and of requests from the computer to start
+ * the bootloader.  This should be called regularly (more often than every
+ * 50&nbsp;ms), and as often as possible when you are streaming data. */
+void usbBulkService(void);
+
+/*! \return The number of bytes in the next packet received from the
+ * computer (1 to #USB_BULK_PACKET_SIZE), or 0 if no packet is available.
+ *
+ * Zero-length packets received from the computer are discarded. */
+uint8 usbBulkRxAvailable(void);
+
+/*! Copies the next packet received from the computer to the buffer and
+ * frees its space in the OUT endpoint so another packet can be received.
+ *
+ * \param buffer A buffer with room for #USB_BULK_PACKET_SIZE bytes.
+ * \return The number of bytes copied, or 0 if no packet was available. */
+uint8 usbBulkRxReceive(uint8 XDATA * buffer);
+
+/*! \return The number of bytes that can be passed to usbBulkTxSend() right
+ * now: 0, #USB_BULK_PACKET_SIZE, or twice that, depending on how many of the
+ * IN endpoint's buffers are free. */
+uint8 usbBulkTxAvailable(void);
+
+/*! Queues data to be sent to the computer.
+ *
+ * The data is divided into packets of #USB_BULK_PACKET_SIZE bytes.  If size
+ * is not a multiple of #USB_BULK_PACKET_SIZE, the last packet is a short
+ * packet, which ends the transfer that the computer is waiting for.  Pass
+ * a size of 0 to send a zero-length packet, which ends the transfer without
+ * sending any more data.
+ *
+ * \param buffer The data to send.
+ * \param size The number of bytes to send.  This must be less than or equal
+ *   to the last value returned by usbBulkTxAvailable(), and if it is 0, then
+ *   usbBulkTxAvailable() must have returned a non-zero value. */
+void usbBulkTxSend(const uint8 XDATA * buffer, uint8 size);
+
+#endif
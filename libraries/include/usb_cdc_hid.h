@@ -0,0 +1,28 @@
+/*! \file usb_cdc_hid.h
+ * The <code>usb_cdc_hid.lib</code> library implements a composite USB device
+ * with a virtual COM port (CDC ACM) and the keyboard, mouse, and joystick
+ * interfaces of <code>usb_hid.lib</code>.  This is useful for apps that want
+ * a low-latency HID channel for control and a COM port for bulk data and
+ * diagnostics at the same time.
+ *
+ * Use the functions and variables in usb_com.h and usb_hid.h as usual, and
+ * call both usbComService() and usbHidService() regularly.  Do not link
+ * this library together with <code>usb_cdc_acm.lib</code> or
+ * <code>usb_hid.lib</code>, because it contains its own copies of them.
+ *
+ * Interfaces 0 and 1 are the CDC ACM interfaces, grouped by an Interface
+ * Association Descriptor, and interfaces 2, 3, and 4 are the keyboard, mouse,
+ * and joystick.  The CDC ACM notification endpoint is endpoint 5 instead of
+ * endpoint 1.  The device uses product ID 0x2203.
+ *
+ * This library depends on <code>usb_composite.lib</code>,
+ * <code>usb.lib</code>, and <code>wixel.lib</code>.
+ */
+
+#ifndef _USB_CDC_HID_H
+#define _USB_CDC_HID_H
+
+#include <usb_com.h>
+#include <usb_hid.h>
+
+#endif
@@ -1,6 +1,13 @@
 /*! \file usb_com.h
  * The <code>usb_com.lib</code> library implements a virtual COM/serial port
  * over USB using the CDC ACM class.  See also com.h.
+ *
+ * By default, received data stays in the USB module's OUT FIFO until your
+ * main loop reads it, and the USB host has to wait (it receives NAKs) while
+ * your main loop is busy.  If you call usbComRxBufferInit(), the USB
+ * interrupt copies each packet into a ring buffer that you provide as soon as
+ * it arrives, so the host can keep sending while your main loop is doing
+ * something else.
  */
 
 #ifndef _USB_COM_H
@@ -8,6 +15,7 @@
 
 #include <time.h>
 #include <com.h>
+#include <usb.h>
 
 typedef void (HandlerFunction)(void);
 
@@ -90,7 +98,8 @@ void usbComTxControlSignalEvents(uint8 signalEvents);
 extern ACM_LINE_CODING XDATA usbComLineCoding;
 
 /*! A pointer to a function that will be called whenever #usbComLineCoding gets set
- * by the USB host. */
+ * by the USB host.  It is called from usbComService(), so it runs in your main
+ * loop even if usbEnableInterrupt() has been called. */
 extern HandlerFunction * usbComLineCodingChangeHandler;
 
 /*! This function should be called regularly (at least every 50&nbsp;ms) if you are
@@ -131,15 +140,133 @@ uint8 usbComRxReceiveByte(void);
  * usbComRxAvailable().
  *
  * See also usbComRxReceiveByte(). */
-void usbComRxReceive(const uint8 XDATA * buffer, uint8 size);
+void usbComRxReceive(uint8 XDATA * buffer, uint8 size);
+
+/*! Makes the library use a ring buffer to receive data from the USB host.
+ *
+ * After you call this function, the USB interrupt copies each packet of
+ * data into the buffer as soon as it is received.  usbComRxAvailable(),
+ * usbComRxReceiveByte(), usbComRxReceive(), and usbComRxRead() all read
+ * from the buffer.
+ *
+ * \param buffer The memory to use for the buffer.  It must not be used for
+ *   anything else after this function is called.
+ * \param size The size of the buffer in bytes.  This must be at least 64,
+ *   the size of one USB packet.
+ *
+ * This should be called once, before usbComService() is called for the first
+ * time.  The USB interrupt is defined in usb.lib, so usb.h (which usb_com.h
+ * includes) must be included in the file that defines main().
+ *
+ * Example:
+\code
+uint8 XDATA usbRxBuffer[512];
+
+void main()
+{
+    systemInit();
+    usbInit();
+    usbComRxBufferInit(usbRxBuffer, sizeof(usbRxBuffer));
+    ...
+}
+\endcode
+ */
+void usbComRxBufferInit(uint8 XDATA * buffer, uint16 size);
+
+/*! Sets the watermarks that control when the USB interrupt stops accepting
+ * data from the USB host.
+ *
+ * When accepting another packet would put more than \p high bytes in the
+ * buffer, the interrupt stops accepting packets and the host has to wait.
+ * It starts accepting packets again after your code reads enough data that
+ * there are \p low bytes or fewer left in the buffer.
+ *
+ * By default, \p high is the size of the buffer and \p low is 64 bytes less
+ * than that, so packets are accepted whenever there is room for them.
+ * A lower \p high value keeps some room in the buffer free, and a larger
+ * gap between the two values means that the host sends data in longer bursts.
+ * \p high is raised to 64 if it is lower than that (otherwise a full packet
+ * could never be accepted), and \p low is lowered to \p high if it is
+ * higher.
+ *
+ * This function should only be called after usbComRxBufferInit(). */
+void usbComRxSetWatermarks(uint16 low, uint16 high);
+
+/*! \return 1 if the USB interrupt has stopped accepting data because the
+ * buffer reached the high watermark (see usbComRxSetWatermarks()), or 0 otherwise. */
+BIT usbComRxThrottled(void);
+
+/*! \return The number of bytes that can be received immediately.
+ *
+ * Unlike usbComRxAvailable(), this can return values greater than 255 if you
+ * are using a ring buffer (see usbComRxBufferInit()). */
+uint16 usbComRxBufferCount(void);
+
+/*! Reads up to \p maxSize bytes from USB and stores them in memory.
+ *
+ * \param buffer The buffer to store the data in.
+ * \param maxSize The maximum number of bytes to read.
+ * \return The number of bytes read, which might be 0.
+ *
+ * Unlike usbComRxReceive(), you do not have to call usbComRxAvailable()
+ * before calling this function. */
+uint16 usbComRxRead(uint8 XDATA * buffer, uint16 maxSize);
 
 /*! \return The number of bytes available in the TX buffers.
  *
  * The <code>usb_cdc_acm.lib</code> library uses a double-buffered endpoint
  * with 64-byte buffers, so if the USB host keeps reading data from the device
- * then this function will eventually return 128. */
+ * then this function will eventually return 128.  If you are using a staging
+ * buffer (see usbComTxBufferInit()), it returns the free space in that buffer
+ * instead, up to 255. */
 uint8 usbComTxAvailable(void);
 
+/*! Sets the latency timer, which controls when partially-filled packets are
+ * sent to the USB host.
+ *
+ * Full 64-byte packets are always sent right away.  A packet with fewer bytes
+ * is only sent by usbComService() after its first byte has been waiting for
+ * the specified number of milliseconds, so bytes written one at a time (for
+ * example, by printf) get combined into fewer, larger packets.  The same
+ * delay applies to the empty packets that end a transfer of full packets.
+ *
+ * \param milliseconds The latency, from 0 to 255 ms.  The default is 0,
+ *   which means partial packets are sent on every call to usbComService().
+ *   Values of a few milliseconds usually give most of the benefit. */
+void usbComTxSetLatency(uint8 milliseconds);
+
+/*! Makes the library use a staging ring buffer for data to send to the USB
+ * host.
+ *
+ * Without this buffer, your code can only queue as much data as fits in the
+ * two packets of the endpoint's FIFO.  With it, data is copied from the buffer
+ * to the FIFO whenever there is room, and usbComTxAvailable() reports the free
+ * space in the buffer.
+ *
+ * \param buffer The memory to use for the buffer.  It must not be used for
+ *   anything else after this function is called.
+ * \param size The size of the buffer in bytes.
+ *
+ * This should be called once, before any data is sent. */
+void usbComTxBufferInit(uint8 XDATA * buffer, uint16 size);
+
+/*! \return The number of bytes that can be added to the TX buffers.
+ *
+ * Unlike usbComTxAvailable(), this can return values greater than 255 if you
+ * are using a staging buffer (see usbComTxBufferInit()). */
+uint16 usbComTxBufferSpace(void);
+
+/*! Adds up to \p size bytes to the TX buffers.
+ *
+ * \param buffer A pointer to the bytes to send.
+ * \param size The number of bytes to send.
+ * \return The number of bytes that were added, which might be less than
+ *   \p size if there is not enough room.
+ *
+ * Unlike usbComTxSend(), you do not have to call usbComTxAvailable() before
+ * calling this function. */
+uint16 usbComTxWrite(const uint8 XDATA * buffer, uint16 size);
+
 /*! Adds a byte to the TX buffer, which means it will be eventually
  * sent to the USB host.
  *
@@ -161,4 +288,19 @@ void usbComTxSendByte(uint8 byte);
  * The \p size parameter should not exceed the last value returned by usbComTxAvailable(). */
 void usbComTxSend(const uint8 XDATA * buffer, uint8 size);
 
+/*! Initializes the CDC ACM endpoints.  This is called from
+ * usbCallbackInitEndpoints(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbComInitEndpoints(void);
+
+/*! Handles the CDC ACM class requests.  This is called from
+ * usbCallbackSetupHandler(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbComSetupHandler(void);
+
+/*! Handles the data of the SetLineCoding request.  This is called from
+ * usbCallbackControlWriteHandler(), so you only need it if you are writing
+ * the descriptors of a composite device yourself (see usb_composite.h). */
+void usbComControlWriteHandler(void);
+
 #endif
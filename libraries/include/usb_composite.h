@@ -0,0 +1,74 @@
+/*! \file usb_composite.h
+ * The <code>usb_composite.lib</code> library lets one Wixel app implement
+ * several USB functions at once, for example a virtual COM port and a HID
+ * keyboard and mouse (see usb_cdc_hid.h).
+ *
+ * Normally, a USB class library such as <code>usb_cdc_acm.lib</code> or
+ * <code>usb_hid.lib</code> defines the descriptors and the callbacks
+ * required by usb.c (usbCallbackSetupHandler() etc.), so an app can only
+ * use one of them.  A composite device instead has:
+ * - One configuration descriptor that contains the interfaces of all the
+ *   functions.  A function with more than one interface (such as CDC ACM)
+ *   should be preceded by an Interface Association Descriptor, and the
+ *   device descriptor should then use class 0xEF, subclass 2, protocol 1.
+ * - A table of the functions (::usbCompositeFunctions), which tells this
+ *   library which interfaces belong to each function and which request
+ *   handlers to call for them.
+ *
+ * This library defines the usb.c callbacks.  Requests addressed to an
+ * interface are passed only to the function that owns the interface.
+ * Other requests (addressed to the device or to an endpoint) are passed to
+ * every function, so each handler must ignore requests that it does not
+ * recognize.
+ *
+ * The class libraries can be compiled for a composite device by defining
+ * USB_COMPOSITE, which removes their descriptors and callbacks, and by
+ * defining their interface and endpoint numbers with preprocessor flags.
+ * See libraries/src/usb_cdc_hid/lib_options.mk for an example.
+ *
+ * This library depends on <code>usb.lib</code>.
+ */
+
+#ifndef _USB_COMPOSITE_H
+#define _USB_COMPOSITE_H
+
+#include <cc2511_types.h>
+
+/*! The type of the request handlers in ::USB_COMPOSITE_FUNCTION. */
+typedef void (UsbCompositeHandler)(void);
+
+/*! Describes one function of a composite device.  Any of the handlers
+ * may be 0. */
+typedef struct USB_COMPOSITE_FUNCTION
+{
+    /*! The number of the first interface of this function. */
+    uint8 firstInterface;
+
+    /*! The number of consecutive interfaces that belong to this function. */
+    uint8 interfaceCount;
+
+    /*! Called from usbCallbackInitEndpoints(). */
+    UsbCompositeHandler * initEndpoints;
+
+    /*! Called from usbCallbackSetupHandler(). */
+    UsbCompositeHandler * setupHandler;
+
+    /*! Called from usbCallbackClassDescriptorHandler(). */
+    UsbCompositeHandler * classDescriptorHandler;
+
+    /*! Called from usbCallbackControlWriteHandler(). */
+    UsbCompositeHandler * controlWriteHandler;
+} USB_COMPOSITE_FUNCTION;
+
+/*! The functions of the composite device.
+ *
+ * This must be defined by higher-level code, along with the descriptors
+ * required by usb.c.  See usb_cdc_hid.c for an example. */
+extern USB_COMPOSITE_FUNCTION CODE usbCompositeFunctions[];
+
+/*! The number of entries in ::usbCompositeFunctions.
+ *
+ * This must be defined by higher-level code. */
+extern uint8 CODE usbCompositeFunctionCount;
+
+#endif
@@ -3,6 +3,12 @@
  * containing a keyboard interface and a mouse interface using the
  * Human Interface Device (HID) class.
  *
+ * The computer polls the interfaces every 10&nbsp;ms.  The
+ * <code>usb_hid_1ms.lib</code> library is the same except that the computer
+ * polls every 1&nbsp;ms, which lowers the latency and allows ten times as
+ * many reports per second, at the cost of more USB bandwidth.  Link one of
+ * the two libraries, not both.
+ *
  * You can find the specification of the USB HID device class in HID1_11.pdf,
  * available for download from USB Implementers Forum at this url:
  * http://www.usb.org/developers/hidpage
@@ -150,7 +156,15 @@ extern BIT usbHidKeyboardInputUpdated;
 
 /*! After writing data to #usbHidMouseInput, set this bit to 1 to trigger an HID
  * report to be sent from the mouse interface to the host. This bit is cleared by the
- * library once the report is sent. */
+ * library in usbHidService() once it has taken the data.
+ *
+ * The X, Y, and wheel movements are added to any movement that has not been
+ * sent yet, and then cleared in #usbHidMouseInput, so no movement is lost if
+ * you report movement more often than the computer polls the mouse.  If
+ * more than 127 counts have accumulated, they are sent in several reports.
+ * At most 1024 counts in each direction are kept, so movement reported
+ * while the computer is not polling (for example while it is suspended)
+ * does not pile up. */
 extern BIT usbHidMouseInputUpdated;
 
 /*! After writing data to #usbHidJoystickInput, set this bit to 1 to trigger an HID
@@ -161,6 +175,47 @@ extern BIT usbHidJoystickInputUpdated;
 /*! This must be called regularly if you are implementing an HID device. */
 void usbHidService(void);
 
+/*! The number of reports that fit in the keyboard report queue. */
+#define USB_HID_KEYBOARD_QUEUE_LENGTH 16
+
+/*! \return A pointer to a free report in the keyboard report queue, or 0 if
+ * the queue is full.
+ *
+ * The keyboard report queue lets you send a sequence of keyboard reports
+ * (for example, to type a string) without waiting for each one to be sent:
+ * the library sends one queued report each time the computer polls the
+ * keyboard.  Fill in all the fields of the report and then call
+ * usbHidKeyboardQueueSendReport().  Each report that is sent is also copied
+ * to #usbHidKeyboardInput, so it stays in effect until the next report. */
+HID_KEYBOARD_IN_REPORT XDATA * usbHidKeyboardQueueCurrentReport(void);
+
+/*! Adds the report returned by usbHidKeyboardQueueCurrentReport() to the
+ * keyboard report queue.  You must only call this if
+ * usbHidKeyboardQueueCurrentReport() returned a non-zero pointer. */
+void usbHidKeyboardQueueSendReport(void);
+
+/*! \return The number of free reports in the keyboard report queue. */
+uint8 usbHidKeyboardQueueFree(void);
+
+/*! Queues the two keyboard reports needed to type an ASCII character on a US
+ * keyboard: one that presses the key (with Shift if needed) and one that
+ * releases it.
+ *
+ * \return 1 if the reports were queued, or 0 if the character has no key
+ * code or there are fewer than 2 free reports in the queue.
+ *
+ * Example:
+\code
+char CODE message[] = "Hello, World!";
+static uint8 XDATA next = 0;
+
+if (next < sizeof(message) - 1 && usbHidKeyboardQueueChar(message[next]))
+{
+    next++;
+}
+\endcode */
+BIT usbHidKeyboardQueueChar(char asciiChar);
+
 /*! Converts an ASCII-encoded character into the corresponding HID Key Code,
  * suitable for the keyCodes array in HID_KEYBOARD_IN_REPORT.
  * Note that many pairs of ASCII characters map to the same key code because
@@ -170,4 +225,27 @@ void usbHidService(void);
  * modifiers byte in the HID_KEYBOARD_IN_REPORT. */
 uint8 usbHidKeyCodeFromAsciiChar(char asciiChar);
 
+/*! The sizes of the keyboard, mouse, and joystick report descriptors, in
+ * bytes.  These are needed for the wDescriptorLength fields of the HID
+ * descriptors if you are writing the descriptors of a composite device
+ * yourself (see usb_composite.h). */
+#define USB_HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE  58
+#define USB_HID_MOUSE_REPORT_DESCRIPTOR_SIZE     46
+#define USB_HID_JOYSTICK_REPORT_DESCRIPTOR_SIZE  50
+
+/*! Initializes the HID endpoints.  This is called from
+ * usbCallbackInitEndpoints(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidInitEndpoints(void);
+
+/*! Handles the HID class requests.  This is called from
+ * usbCallbackSetupHandler(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidSetupHandler(void);
+
+/*! Handles requests for HID and report descriptors.  This is called from
+ * usbCallbackClassDescriptorHandler(), so you only need it if you are writing
+ * the descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidClassDescriptorHandler(void);
+
 #endif
@@ -0,0 +1,122 @@
+/*! \file usb_hid_raw.h
+ * The <code>usb_hid_raw.lib</code> library implements a USB Human Interface
+ * Device (HID) with a vendor-defined 64-byte input report and a 64-byte
+ * output report.  Unlike the keyboard and mouse reports of usb_hid.h, these
+ * reports do not mean anything to the operating system, so they can carry
+ * any data your app wants.  The computer can send and receive them without
+ * installing a driver (for example with /dev/hidraw on Linux or the
+ * HidD_ and ReadFile/WriteFile functions on Windows).
+ *
+ * Both endpoints are interrupt endpoints with a bInterval of 1&nbsp;ms, so the
+ * computer polls them every USB frame.  This makes the library a good choice
+ * for a command channel that needs low and predictable latency: a command
+ * and its response can usually make a round trip in 2&nbsp;ms, without the
+ * latency timers that some serial port drivers add.
+ *
+ * Input reports (Wixel to computer) are queued: get a free report with
+ * usbHidRawTxCurrentReport(), fill in all #USB_HID_RAW_REPORT_SIZE bytes,
+ * and call usbHidRawTxSendReport().  Output reports (computer to Wixel) are
+ * passed to #usbHidRawRxReportHandler.
+ *
+ * Example:
+ *
+\code
+void reportReceived(uint8 XDATA * report)
+{
+    uint8 XDATA * response = usbHidRawTxCurrentReport();
+    if (response)
+    {
+        memcpy(response, report, USB_HID_RAW_REPORT_SIZE);   // Echo the report.
+        usbHidRawTxSendReport();
+    }
+}
+
+void main()
+{
+    systemInit();
+    usbInit();
+    usbHidRawRxReportHandler = reportReceived;
+
+    while(1)
+    {
+        boardService();
+        usbHidRawService();
+    }
+}
+\endcode
+ *
+ * The device uses product ID 0x2204.
+ *
+ * This library depends on <code>usb.lib</code> and <code>wixel.lib</code>.
+ */
+
+#ifndef _USB_HID_RAW_H
+#define _USB_HID_RAW_H
+
+#include <cc2511_types.h>
+
+/*! The size of the input and output reports, in bytes. */
+#define USB_HID_RAW_REPORT_SIZE  64
+
+/*! The number of input reports that can be queued. */
+#define USB_HID_RAW_TX_QUEUE_LENGTH  4
+
+/*! The size of the report descriptor, in bytes.  This is needed for the
+ * wDescriptorLength field of the HID descriptor if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+#define USB_HID_RAW_REPORT_DESCRIPTOR_SIZE  25
+
+/*! The type of function that receives output reports.  The argument points
+ * to the #USB_HID_RAW_REPORT_SIZE bytes of the report, which are only valid
+ * until the function returns. */
+typedef void (UsbHidRawReportHandler)(uint8 XDATA * report);
+
+/*! The function that is called when an output report is received from the
+ * computer.  It is called from usbHidRawService(), so it runs in your main
+ * loop, not in an interrupt.  The default value is 0, which means that
+ * output reports are discarded. */
+extern UsbHidRawReportHandler * usbHidRawRxReportHandler;
+
+/*! Sends queued input reports to the computer, receives output reports,
+ * and takes care of the USB module.  This should be called regularly (more
+ * often than every 50&nbsp;ms, and at least once per millisecond if you want
+ * the lowest latency). */
+void usbHidRawService(void);
+
+/*! \return A pointer to a free input report, or 0 if the queue is full.
+ *
+ * You can call this function several times before calling
+ * usbHidRawTxSendReport(); it returns the same report each time. */
+uint8 XDATA * usbHidRawTxCurrentReport(void);
+
+/*! Adds the report returned by usbHidRawTxCurrentReport() to the queue of
+ * reports to be sent.  You must only call this if usbHidRawTxCurrentReport()
+ * returned a non-zero pointer. */
+void usbHidRawTxSendReport(void);
+
+/*! \return The number of input reports that are in the queue and have not
+ * been loaded into the USB endpoint yet. */
+uint8 usbHidRawTxQueued(void);
+
+/*! Initializes the endpoints.  This is called from
+ * usbCallbackInitEndpoints(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidRawInitEndpoints(void);
+
+/*! Handles the HID class requests.  This is called from
+ * usbCallbackSetupHandler(), so you only need it if you are writing the
+ * descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidRawSetupHandler(void);
+
+/*! Handles requests for the HID and report descriptors.  This is called from
+ * usbCallbackClassDescriptorHandler(), so you only need it if you are writing
+ * the descriptors of a composite device yourself (see usb_composite.h). */
+void usbHidRawClassDescriptorHandler(void);
+
+/*! Handles output reports sent with the SET_REPORT request.  This is called
+ * from usbCallbackControlWriteHandler(), so you only need it if you are
+ * writing the descriptors of a composite device yourself (see
+ * usb_composite.h). */
+void usbHidRawControlWriteHandler(void);
+
+#endif
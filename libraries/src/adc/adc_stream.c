@@ -0,0 +1,196 @@
+/* adc_stream.c:  Continuous, timer-triggered ADC sampling into a ring of
+ * sample blocks in RAM.  See adc_stream.h for the public interface.
+ *
+ * Timer 1 runs in modulo mode and its channel 0 compare event starts an ADC
+ * sequence conversion (ADCCON1.STSEL = 10).  Every conversion in the sequence
+ * triggers DMA channel DMA_CHANNEL_ADC (trigger ADC_CHALL), which copies the
+ * 16-bit result from ADCL:ADCH into the block currently being filled.  The
+ * DMA channel is used in single mode with a length of one block, so it
+ * generates one DMA interrupt per block; the ISR hands the finished block to
+ * the main loop and re-arms the channel on the next free block.  That is the
+ * only CPU time spent while streaming.
+ */
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+#include <adc_stream.h>
+#include <dma.h>
+
+/* BLOCK_COUNT is the number of blocks in the ring.  At any time, one of them
+ * is being filled by the DMA, so the main loop can hold up to
+ * BLOCK_COUNT - 1 complete blocks. */
+#define BLOCK_COUNT 4
+
+static uint16 XDATA adcStreamBuffer[BLOCK_COUNT][ADC_STREAM_MAX_BLOCK_SIZE];
+
+/* The main loop owns the blocks from adcStreamMainLoopIndex up to (but not
+ * including) adcStreamInterruptIndex.  The DMA is filling the block at
+ * adcStreamInterruptIndex. */
+static volatile uint8 DATA adcStreamMainLoopIndex = 0;
+static volatile uint8 DATA adcStreamInterruptIndex = 0;
+
+static uint8 adcStreamBlockLength = ADC_STREAM_MAX_BLOCK_SIZE;
+
+static volatile uint16 XDATA adcStreamDropCount = 0;
+
+// Points the ADC DMA channel at the block indicated by adcStreamInterruptIndex and arms it.
+static void adcStreamArm()
+{
+    dmaConfig.adc.DESTADDRH = (uint16)adcStreamBuffer[adcStreamInterruptIndex] >> 8;
+    dmaConfig.adc.DESTADDRL = (uint16)adcStreamBuffer[adcStreamInterruptIndex];
+    DMAARM |= (1<<DMA_CHANNEL_ADC);
+}
+
+ISR(DMA, 0)
+{
+    DMAIF = 0;
+
+    if (DMAIRQ & (1<<DMA_CHANNEL_ADC))
+    {
+        uint8 nextIndex;
+
+        DMAIRQ &= ~(1<<DMA_CHANNEL_ADC);
+
+        if (adcStreamInterruptIndex == BLOCK_COUNT - 1)
+        {
+            nextIndex = 0;
+        }
+        else
+        {
+            nextIndex = adcStreamInterruptIndex + 1;
+        }
+
+        if (nextIndex == adcStreamMainLoopIndex)
+        {
+            // The main loop still owns every other block, so there is no place to
+            // put new samples.  Overwrite the block we just filled.
+            adcStreamDropCount += adcStreamBlockLength;
+        }
+        else
+        {
+            // Give the block we just filled to the main loop.
+            adcStreamInterruptIndex = nextIndex;
+        }
+
+        adcStreamArm();
+    }
+}
+
+void adcStreamStop()
+{
+    T1CTL = 0;                    // Suspend Timer 1.
+    ADCCON1 = 0b00110011;         // STSEL = 11: Only start sequences when ADCCON1.ST is set (i.e. never).
+    DMAARM = 0x80 | (1<<DMA_CHANNEL_ADC);  // Abort any transfer in progress.
+    DMAIE = 0;
+    DMAIRQ &= ~(1<<DMA_CHANNEL_ADC);
+}
+
+void adcStreamStart(uint8 channelCount, uint16 sequenceRate, uint8 options)
+{
+    // Shift amounts corresponding to the Timer 1 prescaler settings: 1, 8, 32, and 128.
+    static uint8 CODE prescalerShift[] = {0, 3, 5, 7};
+    uint32 period;
+    uint8 div;
+
+    adcStreamStop();
+
+    if (channelCount < 1){ channelCount = 1; }
+    if (channelCount > 6){ channelCount = 6; }
+    if (sequenceRate < 3){ sequenceRate = 3; }
+
+    adcStreamBlockLength = (ADC_STREAM_MAX_BLOCK_SIZE / channelCount) * channelCount;
+    adcStreamMainLoopIndex = 0;
+    adcStreamInterruptIndex = 0;
+    adcStreamDropCount = 0;
+
+    // Sequence conversions skip any channel that is not enabled in ADCCFG.
+    ADCCFG |= (1 << channelCount) - 1;
+
+    // Configure the DMA channel to copy each 16-bit result from ADCL:ADCH to the current block.
+    dmaConfig.adc.SRCADDRH = XDATA_SFR_ADDRESS(ADCL) >> 8;
+    dmaConfig.adc.SRCADDRL = XDATA_SFR_ADDRESS(ADCL);
+    dmaConfig.adc.VLEN_LENH = 0;                // Transfer a fixed number of words: one block.
+    dmaConfig.adc.LENL = adcStreamBlockLength;
+    dmaConfig.adc.DC6 = 0b10010100;             // WORDSIZE = 1 (16-bit), TMODE = 00 (Single), TRIG = 20 (ADC_CHALL)
+    dmaConfig.adc.DC7 = 0b00011000;             // SRCINC = 0, DESTINC = 1 (+1 word), IRQMASK = 1, M8 = 0, PRIORITY = 0
+    adcStreamArm();
+    DMAIE = 1;
+
+    // Choose the smallest Timer 1 prescaler that lets the period fit in 16 bits.
+    div = 0;
+    while(1)
+    {
+        period = 24000000 / ((uint32)sequenceRate << prescalerShift[div]);
+        if (period <= 0x10000 || div == 3)
+        {
+            break;
+        }
+        div++;
+    }
+    period -= 1;
+
+    T1CCTL0 = 0b00000100;   // Channel 0 in compare mode so that it generates compare events.
+    T1CC0L = (uint8)period;
+    T1CC0H = (uint8)(period >> 8);
+
+    // SREF and SDIV are set the same way that adcRead() sets EREF and EDIV.
+    // SCH = channelCount - 1: Each sequence converts AIN0 through AIN<SCH>.
+    ADCCON2 = (0b10110000 ^ (options & 0xF0)) | (channelCount - 1);
+
+    ADCCON1 = 0b00100011;   // STSEL = 10: Start a sequence on each Timer 1 channel 0 compare event.
+
+    T1CNTL = 0;             // Reset the counter.
+    T1CTL = (div << 2) | 0b10;  // Start Timer 1 in modulo mode with the chosen prescaler.
+}
+
+uint8 adcStreamBlockSize()
+{
+    return adcStreamBlockLength;
+}
+
+uint8 adcStreamRxAvailable()
+{
+    uint8 interruptIndex = adcStreamInterruptIndex;
+    if (interruptIndex >= adcStreamMainLoopIndex)
+    {
+        return interruptIndex - adcStreamMainLoopIndex;
+    }
+    else
+    {
+        return interruptIndex + BLOCK_COUNT - adcStreamMainLoopIndex;
+    }
+}
+
+uint16 XDATA * adcStreamRxCurrentBlock()
+{
+    if (adcStreamMainLoopIndex == adcStreamInterruptIndex)
+    {
+        return 0;
+    }
+    return adcStreamBuffer[adcStreamMainLoopIndex];
+}
+
+void adcStreamRxDoneWithBlock()
+{
+    if (adcStreamMainLoopIndex == BLOCK_COUNT - 1)
+    {
+        adcStreamMainLoopIndex = 0;
+    }
+    else
+    {
+        adcStreamMainLoopIndex++;
+    }
+}
+
+uint16 adcStreamSamplesDropped()
+{
+    uint16 count;
+
+    // The count is modified by the ISR, so read it until we get the same value twice.
+    do
+    {
+        count = adcStreamDropCount;
+    } while(count != adcStreamDropCount);
+
+    return count;
+}
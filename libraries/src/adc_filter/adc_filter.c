@@ -0,0 +1,103 @@
+#include <cc2511_map.h>
+#include <adc_filter.h>
+#include <adc.h>
+#include <adc_stream.h>
+
+uint16 adcReadOversampled(uint8 channel, uint8 extraBits)
+{
+    uint32 sum = 0;
+    uint16 count;
+
+    if (extraBits > 4){ extraBits = 4; }
+
+    for (count = (uint16)1 << (extraBits << 1); count; count--)
+    {
+        sum += adcRead(channel);
+    }
+
+    return sum >> extraBits;
+}
+
+void adcAverageFilterInit(ADC_AVERAGE_FILTER XDATA * filter, uint16 XDATA * history,
+    uint8 windowShift, uint16 initialValue)
+{
+    uint8 i;
+
+    if (windowShift > 5){ windowShift = 5; }
+
+    filter->history = history;
+    filter->windowShift = windowShift;
+    filter->index = 0;
+    filter->sum = initialValue << windowShift;
+    for (i = 0; i < (uint8)(1 << windowShift); i++)
+    {
+        history[i] = initialValue;
+    }
+}
+
+uint16 adcAverageFilterUpdate(ADC_AVERAGE_FILTER XDATA * filter, uint16 reading) __reentrant
+{
+    uint16 XDATA * slot = filter->history + filter->index;
+
+    filter->sum += reading - *slot;
+    *slot = reading;
+
+    filter->index = (filter->index + 1) & ((1 << filter->windowShift) - 1);
+
+    return filter->sum >> filter->windowShift;
+}
+
+void adcIirFilterInit(ADC_IIR_FILTER XDATA * filter, uint8 shift, uint16 initialValue)
+{
+    if (shift > 5){ shift = 5; }
+
+    filter->shift = shift;
+    filter->state = initialValue << shift;
+}
+
+uint16 adcIirFilterUpdate(ADC_IIR_FILTER XDATA * filter, uint16 reading) __reentrant
+{
+    // state/2^shift is the output, so this is output += (reading - output)/2^shift.
+    // The subtraction happens first so the state never goes negative.
+    filter->state = filter->state - (filter->state >> filter->shift) + reading;
+    return filter->state >> filter->shift;
+}
+
+uint16 adcFilterBlockDecimate(const uint16 XDATA * samples, uint8 stride, uint8 extraBits)
+{
+    uint16 sum = 0;
+    uint8 count;
+
+    if (extraBits > 2){ extraBits = 2; }
+
+    for (count = 1 << (extraBits << 1); count; count--)
+    {
+        sum += ADC_STREAM_SAMPLE(*samples);
+        samples += stride;
+    }
+
+    return sum >> extraBits;
+}
+
+uint16 adcAverageFilterBlock(ADC_AVERAGE_FILTER XDATA * filter, const uint16 XDATA * samples,
+    uint8 count, uint8 stride)
+{
+    uint16 output = filter->sum >> filter->windowShift;
+    while(count--)
+    {
+        output = adcAverageFilterUpdate(filter, ADC_STREAM_SAMPLE(*samples));
+        samples += stride;
+    }
+    return output;
+}
+
+uint16 adcIirFilterBlock(ADC_IIR_FILTER XDATA * filter, const uint16 XDATA * samples,
+    uint8 count, uint8 stride)
+{
+    while(count--)
+    {
+        adcIirFilterUpdate(filter, ADC_STREAM_SAMPLE(*samples));
+        samples += stride;
+    }
+    return adcIirFilterOutput(filter);
+}
@@ -0,0 +1,84 @@
+/* packet_pool.c: A pool of fixed-size packet buffers with reference counts.
+ * See packet_pool.h for the public interface.
+ *
+ * The free buffers are kept on a stack of handles, so allocating and
+ * releasing a buffer each take constant time.  The reference counts and the
+ * free stack are stored after the buffers in the app's storage array, so
+ * they take one byte each per buffer the app actually uses.  The functions are reentrant
+ * and run with interrupts disabled: a non-reentrant function keeps its
+ * parameters in static memory, which an interrupt calling the same function
+ * could overwrite before the main loop's call had disabled interrupts.
+ */
+
+#include <cc2511_map.h>
+#include <packet_pool.h>
+
+uint8 XDATA * DATA packetPoolStorage;
+
+static uint8 XDATA * XDATA packetPoolRefCount;   // blockCount bytes after the buffers.
+static uint8 XDATA * XDATA packetPoolFreeStack;  // blockCount bytes after the reference counts.
+static volatile uint8 DATA packetPoolFreeCount = 0;
+
+void packetPoolInit(uint8 XDATA * storage, uint8 blockCount)
+{
+    uint8 i;
+
+    if (blockCount > PACKET_POOL_MAX_BLOCKS)
+    {
+        blockCount = PACKET_POOL_MAX_BLOCKS;
+    }
+
+    packetPoolStorage = storage;
+    packetPoolRefCount = storage + (uint16)blockCount * PACKET_POOL_BLOCK_SIZE;
+    packetPoolFreeStack = packetPoolRefCount + blockCount;
+    for (i = 0; i < blockCount; i++)
+    {
+        packetPoolRefCount[i] = 0;
+
+        // Push the buffers in reverse order so buffer 0 is allocated first.
+        packetPoolFreeStack[i] = blockCount - 1 - i;
+    }
+    packetPoolFreeCount = blockCount;
+}
+
+uint8 packetPoolAlloc(void) __reentrant
+{
+    uint8 handle = PACKET_POOL_NONE;
+    uint8 savedEA = EA;
+
+    EA = 0;
+    if (packetPoolFreeCount)
+    {
+        handle = packetPoolFreeStack[--packetPoolFreeCount];
+        packetPoolRefCount[handle] = 1;
+    }
+    EA = savedEA;
+
+    return handle;
+}
+
+void packetPoolRetain(uint8 handle) __reentrant
+{
+    uint8 savedEA = EA;
+
+    EA = 0;
+    packetPoolRefCount[handle]++;
+    EA = savedEA;
+}
+
+void packetPoolRelease(uint8 handle) __reentrant
+{
+    uint8 savedEA = EA;
+
+    EA = 0;
+    if (packetPoolRefCount[handle] && --packetPoolRefCount[handle] == 0)
+    {
+        packetPoolFreeStack[packetPoolFreeCount++] = handle;
+    }
+    EA = savedEA;
+}
+
+uint8 packetPoolAvailable(void)
+{
+    return packetPoolFreeCount;
+}
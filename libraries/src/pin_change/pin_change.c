@@ -0,0 +1,303 @@
+/* pin_change.c: Captures changes on Port 0 and Port 1 pins with the port
+ * interrupts, and debounces them in the main loop.
+ * See pin_change.h for the public interface.
+ *
+ * Each enabled pin has an index from 0 to 15: port * 8 + bit.  The ISRs
+ * record when each pin first changed and when it last changed, and mark it
+ * as settling.  pinChangeService() reports a settling pin once it has not
+ * changed for pinChangeDebounceMs, if its level is different from its
+ * debounced level by then.
+ */
+
+#include <pin_change.h>
+#include <time.h>
+
+PinChangeHandler * pinChangeHandler = 0;
+uint8 pinChangeDebounceMs = 5;
+
+// Bit masks of pins, indexed by port.
+static volatile uint8 DATA pinChangeEnabled[2];
+static volatile uint8 DATA pinChangeSettling[2];
+static uint8 pinChangeStable[2];       // The debounced levels.
+static uint8 pinChangeRising[2];       // Pins that report rising edges.
+static uint8 pinChangeFalling[2];      // Pins that report falling edges.
+static uint8 pinChangeFlags[2];        // Pins with unread changes.
+
+// Times in getUs() units, indexed by pin index.
+static volatile uint32 XDATA pinChangeFirstUs[16];  // First change while settling.
+static volatile uint32 XDATA pinChangeLastUs[16];   // Last change while settling.
+static uint32 XDATA pinChangeReportedUs[16];        // Time of the last reported change.
+
+static PIN_CHANGE_EVENT XDATA pinChangeEvent;
+
+// Results of pinChangeLookup().
+static uint8 pinChangePort;
+static uint8 pinChangeMask;
+static uint8 pinChangeIndex;
+
+#define PORT_INTERRUPT_DISABLE(port)  { if (port) { IEN2 &= ~0x10; } else { P0IE = 0; } }
+#define PORT_INTERRUPT_ENABLE(port)   { if (port) { IEN2 |= 0x10; } else { P0IE = 1; } }
+
+// Makes the port interrupt watch for the edge that takes the enabled pins
+// away from their current level.  If they are at different levels, the edge
+// is left alone and pinChangeService() catches the changes it misses.
+#define UPDATE_EDGE(port, portRegister, iconBit)  { \
+    uint8 portLevel = (portRegister) & pinChangeEnabled[port]; \
+    if (portLevel == pinChangeEnabled[port]) { PICTL |= (iconBit); } \
+    else if (portLevel == 0) { PICTL &= ~(iconBit); } }
+
+// Records the time of the changes on the pins in flags.  This is a macro
+// so that the two ISRs do not share a non-reentrant function.
+#define CAPTURE_CHANGES(port, flags)  if (flags) { \
+    TIME_STAMP stamp; \
+    uint32 us; \
+    uint8 mask, index; \
+    TIME_CAPTURE(stamp); \
+    us = TIME_STAMP_TO_US(stamp); \
+    index = (port) << 3; \
+    for (mask = 1; mask; mask <<= 1, index++) \
+    { \
+        if ((flags) & mask) \
+        { \
+            pinChangeLastUs[index] = us; \
+            if (!(pinChangeSettling[port] & mask)) { pinChangeFirstUs[index] = us; } \
+        } \
+    } \
+    pinChangeSettling[port] |= (flags); }
+
+// Writing a 1 to a bit of P0IFG or P1IFG leaves that flag alone, so the
+// ISRs only clear the flags of the enabled pins.  Bit 7 of P0IFG is the USB
+// resume flag, which usbSleep() needs to see, so the P0 ISR leaves it set
+// and masks the P0 interrupt until pinChangeService() clears it (otherwise
+// the flag would keep triggering the interrupt).
+ISR(P0INT, 0)
+{
+    uint8 flags = P0IFG & pinChangeEnabled[0];
+    P0IFG = ~flags;     // The port flags must be cleared before P0IF.
+    P0IF = 0;
+    if (P0IFG & 0x80)
+    {
+        P0IE = 0;
+    }
+    CAPTURE_CHANGES(0, flags);
+    UPDATE_EDGE(0, P0, 0x01);
+}
+
+ISR(P1INT, 0)
+{
+    uint8 flags = P1IFG & pinChangeEnabled[1];
+    P1IFG = ~flags;     // The port flags must be cleared before P1IF.
+    P1IF = 0;
+    CAPTURE_CHANGES(1, flags);
+    UPDATE_EDGE(1, P1, 0x02);
+}
+
+// Computes pinChangePort, pinChangeMask, and pinChangeIndex for a pin.
+// Returns 0 if the pin is not supported.
+static BIT pinChangeLookup(uint8 pinNumber)
+{
+    if (pinNumber <= 5)
+    {
+        pinChangePort = 0;
+        pinChangeIndex = pinNumber;
+    }
+    else if (pinNumber >= 10 && pinNumber <= 17)
+    {
+        pinChangePort = 1;
+        pinChangeIndex = pinNumber - 2;
+    }
+    else
+    {
+        return 0;
+    }
+    pinChangeMask = 1 << (pinChangeIndex & 7);
+    return 1;
+}
+
+void pinChangeEnable(uint8 pinNumber, uint8 edges)
+{
+    uint8 port, mask;
+
+    if (!pinChangeLookup(pinNumber))
+    {
+        return;
+    }
+    port = pinChangePort;
+    mask = pinChangeMask;
+
+    PORT_INTERRUPT_DISABLE(port);
+
+    if (edges & PIN_CHANGE_RISING) { pinChangeRising[port] |= mask; }
+    else { pinChangeRising[port] &= ~mask; }
+
+    if (edges & PIN_CHANGE_FALLING) { pinChangeFalling[port] |= mask; }
+    else { pinChangeFalling[port] &= ~mask; }
+
+    if ((port ? P1 : P0) & mask) { pinChangeStable[port] |= mask; }
+    else { pinChangeStable[port] &= ~mask; }
+
+    pinChangeSettling[port] &= ~mask;
+    pinChangeFlags[port] &= ~mask;
+    pinChangeEnabled[port] |= mask;
+
+    if (port)
+    {
+        P1IFG = ~mask;
+        P1IEN |= mask;
+        UPDATE_EDGE(1, P1, 0x02);
+    }
+    else
+    {
+        P0IFG = ~mask;  // Clears only this pin's flag, not the USB resume flag.
+        PICTL |= (mask & 0x0F) ? 0x08 : 0x10;  // P0IENL or P0IENH
+        UPDATE_EDGE(0, P0, 0x01);
+    }
+
+    PORT_INTERRUPT_ENABLE(port);
+}
+
+void pinChangeDisable(uint8 pinNumber)
+{
+    uint8 port, mask;
+
+    if (!pinChangeLookup(pinNumber))
+    {
+        return;
+    }
+    port = pinChangePort;
+    mask = pinChangeMask;
+
+    PORT_INTERRUPT_DISABLE(port);
+
+    pinChangeEnabled[port] &= ~mask;
+    pinChangeSettling[port] &= ~mask;
+    pinChangeFlags[port] &= ~mask;
+
+    if (port)
+    {
+        P1IEN &= ~mask;
+    }
+    else
+    {
+        if (!(pinChangeEnabled[0] & 0x0F)) { PICTL &= ~0x08; }
+        if (!(pinChangeEnabled[0] & 0xF0)) { PICTL &= ~0x10; }
+    }
+
+    if (pinChangeEnabled[port])
+    {
+        PORT_INTERRUPT_ENABLE(port);
+    }
+}
+
+void pinChangeService()
+{
+    uint32 now = getUs();
+    int32 debounceUs = (int32)pinChangeDebounceMs * 1000;
+    uint32 firstUs;
+    uint8 port, mask, index, level;
+
+    // usbSleep() has returned (or was not running), so a USB resume flag
+    // that the P0 ISR left set is stale: clear it and unmask the interrupt.
+    if (pinChangeEnabled[0] && (P0IFG & 0x80))
+    {
+        P0IFG = (uint8)~0x80;
+        P0IE = 1;
+    }
+
+    for (port = 0; port < 2; port++)
+    {
+        index = port << 3;
+        for (mask = 1; mask; mask <<= 1, index++)
+        {
+            if (!(pinChangeEnabled[port] & mask))
+            {
+                continue;
+            }
+
+            PORT_INTERRUPT_DISABLE(port);
+            level = (port ? P1 : P0) & mask;
+
+            if (!(pinChangeSettling[port] & mask))
+            {
+                if (level != (pinChangeStable[port] & mask))
+                {
+                    // The port interrupt was watching for the other edge,
+                    // so start debouncing this change now.
+                    pinChangeFirstUs[index] = now;
+                    pinChangeLastUs[index] = now;
+                    pinChangeSettling[port] |= mask;
+                    if (port) { UPDATE_EDGE(1, P1, 0x02); }
+                    else { UPDATE_EDGE(0, P0, 0x01); }
+                }
+                PORT_INTERRUPT_ENABLE(port);
+                continue;
+            }
+
+            // The ISR might have recorded a change after we read the time,
+            // so this difference can be negative.
+            if ((int32)(now - pinChangeLastUs[index]) < debounceUs)
+            {
+                // The pin changed recently, so it might still be bouncing.
+                PORT_INTERRUPT_ENABLE(port);
+                continue;
+            }
+
+            firstUs = pinChangeFirstUs[index];
+            pinChangeSettling[port] &= ~mask;
+            PORT_INTERRUPT_ENABLE(port);
+
+            if (level == (pinChangeStable[port] & mask))
+            {
+                continue;   // The pin bounced back to its debounced level.
+            }
+            pinChangeStable[port] ^= mask;
+
+            if (!((level ? pinChangeRising[port] : pinChangeFalling[port]) & mask))
+            {
+                continue;
+            }
+
+            pinChangeFlags[port] |= mask;
+            pinChangeReportedUs[index] = firstUs;
+
+            if (pinChangeHandler)
+            {
+                pinChangeEvent.pinNumber = port ? index + 2 : index;
+                pinChangeEvent.level = level ? 1 : 0;
+                pinChangeEvent.timeUs = firstUs;
+                pinChangeHandler(&pinChangeEvent);
+            }
+        }
+    }
+}
+
+BIT pinChangeOccurred(uint8 pinNumber)
+{
+    uint8 flag;
+
+    if (!pinChangeLookup(pinNumber))
+    {
+        return 0;
+    }
+    flag = pinChangeFlags[pinChangePort] & pinChangeMask;
+    pinChangeFlags[pinChangePort] &= ~pinChangeMask;
+    return flag ? 1 : 0;
+}
+
+BIT pinChangeLevel(uint8 pinNumber)
+{
+    if (!pinChangeLookup(pinNumber))
+    {
+        return 0;
+    }
+    return (pinChangeStable[pinChangePort] & pinChangeMask) ? 1 : 0;
+}
+
+uint32 pinChangeTimeUs(uint8 pinNumber)
+{
+    if (!pinChangeLookup(pinNumber))
+    {
+        return 0;
+    }
+    return pinChangeReportedUs[pinChangeIndex];
+}
@@ -0,0 +1,154 @@
+/* power.c: Puts the CC2511 into low-power modes when the main loop is idle.
+ * See power.h for the public interface.
+ *
+ * The clients are kept in a doubly-linked list so that the waking functions
+ * can be called in the opposite order from the sleeping functions.
+ */
+
+#include <cc2511_map.h>
+#include <power.h>
+#include <board.h>
+#include <time.h>
+
+static POWER_CLIENT XDATA * XDATA powerFirstClient = 0;
+static POWER_CLIENT XDATA * XDATA powerLastClient = 0;
+
+void powerRegister(POWER_CLIENT XDATA * client)
+{
+    client->next = 0;
+    client->previous = powerLastClient;
+    if (powerLastClient)
+    {
+        powerLastClient->next = client;
+    }
+    else
+    {
+        powerFirstClient = client;
+    }
+    powerLastClient = client;
+}
+
+// Waits for a positive edge of the 32 kHz clock that drives the sleep timer.
+static void powerWait32kEdge()
+{
+    uint8 time = WORTIME0;
+    while(time == WORTIME0){};
+}
+
+uint16 powerSleep(uint16 milliseconds, uint8 mode)
+{
+    POWER_CLIENT XDATA * client;
+    uint16 slept, elapsed;
+    BIT savedStie = STIE;
+
+    if (milliseconds == 0)
+    {
+        return 0;
+    }
+
+    for (client = powerFirstClient; client; client = client->next)
+    {
+        if (client->sleeping){ client->sleeping(mode); }
+    }
+
+    // WOR_RES = 01: Each sleep timer period is 2^5 periods of the 32 kHz clock (1 ms).
+    // WOR_RESET = 1: Reset the sleep timer.
+    WORCTRL = (WORCTRL & ~0x03) | 0x04 | 0x01;
+
+    // The reset takes effect on the 32 kHz clock, so wait for two edges.
+    powerWait32kEdge();
+    powerWait32kEdge();
+
+    WOREVT1 = milliseconds >> 8;
+    WOREVT0 = milliseconds;
+
+    WORIRQ = (1<<4);  // EVENT0_MASK = 1: The sleep timer interrupt happens on Event 0.  Clear EVENT0_FLAG.
+    STIF = 0;
+    STIE = 1;         // Enable the sleep timer interrupt so it can wake us up.
+
+    // Follow the recommended procedure from the datasheet (section 12.1.3):
+    // enter the power mode right after a positive edge of the 32 kHz clock.
+    powerWait32kEdge();
+    SLEEP = (SLEEP & ~3) | (mode == POWER_MODE_PM1 ? 1 : 2);  // SLEEP.MODE: Select PM1 or PM2.
+    __asm nop __endasm; __asm nop __endasm; __asm nop __endasm;
+    if (SLEEP & 3)
+    {
+        PCON |= 1;    // PCON.IDLE = 1 : Actually go to sleep.
+    }
+
+    // We are awake again.  Disable the sleep timer interrupt; if there is no ISR
+    // for it, the flag would keep causing (empty) interrupts.
+    STIE = savedStie;
+
+    // Restart the crystal oscillator and switch the system clock back to it.
+    boardClockInit();
+
+    // Timer 4 was not running while we were asleep or while the crystal
+    // oscillator was starting, but the sleep timer was.  It restarts from 0
+    // at Event 0, so if the sleep timer woke us up, WORTIME only counts the
+    // time since then.
+    elapsed = WORTIME0;
+    elapsed |= (uint16)WORTIME1 << 8;
+    if (WORIRQ & 1)
+    {
+        // The sleep timer woke us up, so we slept for the whole time.
+        slept = milliseconds;
+        elapsed += milliseconds;
+    }
+    else
+    {
+        // Something else (e.g. an I/O interrupt) woke us up.  The crystal
+        // oscillator takes less than a millisecond to start, so this is
+        // close enough to the time we were asleep.
+        slept = elapsed;
+    }
+    WORIRQ = 0;
+    STIF = 0;
+
+    timeAdvance(elapsed);
+
+    for (client = powerLastClient; client; client = client->previous)
+    {
+        if (client->waking){ client->waking(mode); }
+    }
+
+    return slept;
+}
+
+void powerIdle(uint16 maxSleepMs)
+{
+    POWER_CLIENT XDATA * client;
+    uint8 mode = POWER_MODE_PM2;
+
+    if (maxSleepMs == 0)
+    {
+        return;
+    }
+
+    for (client = powerFirstClient; client; client = client->next)
+    {
+        if (client->deepestMode)
+        {
+            uint8 clientMode = client->deepestMode();
+            if (clientMode < mode)
+            {
+                mode = clientMode;
+                if (mode == POWER_MODE_ACTIVE)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    if (mode >= POWER_MODE_PM1 && maxSleepMs >= POWER_MIN_DEEP_SLEEP_MS)
+    {
+        powerSleep(maxSleepMs, mode);
+    }
+    else
+    {
+        // Enter PM0 (Idle mode) until the next interrupt.
+        SLEEP &= ~3;  // SLEEP.MODE = 0 : Selects Power Mode 0 (PM0).
+        PCON |= 1;    // PCON.IDLE = 1 : Halt the CPU.
+    }
+}
@@ -0,0 +1,29 @@
+/* power_radio.c: A power manager client for the radio.
+ * It is in a separate file so that apps that do not call powerRegisterRadio()
+ * do not link it. */
+
+#include <cc2511_map.h>
+#include <power.h>
+
+static POWER_CLIENT XDATA powerRadioClient;
+static BIT powerRadioRegistered = 0;
+
+static uint8 powerRadioDeepestMode()
+{
+    // MARCSTATE values 0 and 1 are SLEEP and IDLE.  In any other state the
+    // radio is calibrating, listening, or transmitting, and needs the crystal
+    // oscillator and its interrupts.
+    return (MARCSTATE & 0x1F) <= 1 ? POWER_MODE_PM2 : POWER_MODE_IDLE;
+}
+
+void powerRegisterRadio()
+{
+    if (!powerRadioRegistered)
+    {
+        powerRadioClient.deepestMode = powerRadioDeepestMode;
+        powerRadioClient.sleeping = 0;
+        powerRadioClient.waking = 0;
+        powerRegister(&powerRadioClient);
+        powerRadioRegistered = 1;
+    }
+}
@@ -0,0 +1,28 @@
+/* power_usb.c: A power manager client for the USB module.
+ * It is in a separate file so that apps that do not call powerRegisterUsb()
+ * do not link it. */
+
+#include <cc2511_map.h>
+#include <power.h>
+#include <board.h>
+
+static POWER_CLIENT XDATA powerUsbClient;
+static BIT powerUsbRegistered = 0;
+
+static uint8 powerUsbDeepestMode()
+{
+    // The USB module needs the crystal oscillator whenever we are connected.
+    return usbPowerPresent() ? POWER_MODE_IDLE : POWER_MODE_PM2;
+}
+
+void powerRegisterUsb()
+{
+    if (!powerUsbRegistered)
+    {
+        powerUsbClient.deepestMode = powerUsbDeepestMode;
+        powerUsbClient.sleeping = 0;
+        powerUsbClient.waking = 0;
+        powerRegister(&powerUsbClient);
+        powerUsbRegistered = 1;
+    }
+}
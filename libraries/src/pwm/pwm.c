@@ -0,0 +1,427 @@
+/* pwm.c: Hardware PWM outputs on Timers 1, 3, and 4.
+ * See pwm.h for the public interface.
+ *
+ * Each timer runs in modulo mode with its channel 0 compare value defining
+ * the period.  Every output channel is in compare mode with CMP = 100, which
+ * sets the output when the counter is 0 and clears it when the counter
+ * reaches the channel's compare value.  The timers only load a new compare
+ * value at the end of a period, which is what makes duty cycle changes
+ * glitch-free.
+ *
+ * The outputs are kept in four slots: Timer 1 channels 1 and 2, Timer 3
+ * channel 1, and Timer 4 channel 1.  A pin number alone is not enough to find
+ * the channel because P1_1 can be driven by Timer 1 or Timer 4.
+ *
+ * Duty cycle sequences use DMA channel DMA_CHANNEL_PWM, triggered by the
+ * timer's channel 0 compare event (the end of each period), to copy the next
+ * duty cycle into the channel's compare register.
+ */
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+#include <pwm.h>
+#include <dma.h>
+
+#define PWM_NO_PIN  0xFF
+
+#define SLOT_T1_CH1  0
+#define SLOT_T1_CH2  1
+#define SLOT_T3_CH1  2
+#define SLOT_T4_CH1  3
+#define SLOT_COUNT   4
+
+// Channel control value for the outputs: MODE = 1 (compare), CMP = 100
+// (set on 0, clear on compare), IM = 0 (no interrupt).
+#define PWM_CCTL_OUTPUT  0b00100100
+
+// Timer 4 counts from 0 to T4CC0, which time.c alternates between 187 and 188.
+#define TIMER4_RESOLUTION  189
+
+static uint8 CODE pwmSlotTimer[SLOT_COUNT] = {1, 1, 3, 4};
+static uint8 pwmSlotPin[SLOT_COUNT] = {PWM_NO_PIN, PWM_NO_PIN, PWM_NO_PIN, PWM_NO_PIN};
+static uint8 pwmSequencePin = PWM_NO_PIN;
+
+static uint16 pwmTimer1Resolution = 0;
+static uint8 pwmTimer3Resolution = 0;
+
+// Returns the slot that drives the pin, or SLOT_COUNT if there is none.
+static uint8 pwmFindSlot(uint8 pinNumber)
+{
+    uint8 slot;
+    for (slot = 0; slot < SLOT_COUNT; slot++)
+    {
+        if (pwmSlotPin[slot] == pinNumber)
+        {
+            break;
+        }
+    }
+    return slot;
+}
+
+// Makes the pin an output driving low, and connects it to its timer if
+// peripheral is 1.
+static void pwmConfigurePin(uint8 pinNumber, BIT peripheral)
+{
+    uint8 mask;
+    if (pinNumber < 10)
+    {
+        mask = 1 << pinNumber;
+        P0 &= ~mask;
+        P0DIR |= mask;
+        if (peripheral){ P0SEL |= mask; }
+        else { P0SEL &= ~mask; }
+    }
+    else
+    {
+        mask = 1 << (pinNumber - 10);
+        P1 &= ~mask;
+        P1DIR |= mask;
+        if (peripheral){ P1SEL |= mask; }
+        else { P1SEL &= ~mask; }
+    }
+}
+
+uint16 pwmStart(uint8 timer, uint32 frequency)
+{
+    // Shift amounts corresponding to the Timer 1 prescaler settings: 1, 8, 32, and 128.
+    static uint8 CODE timer1PrescalerShift[] = {0, 3, 5, 7};
+    uint32 period;
+    uint8 div;
+
+    if (frequency == 0){ frequency = 1; }
+
+    switch(timer)
+    {
+    case 1:
+        // Choose the smallest Timer 1 prescaler that lets the period fit in 16 bits.
+        // A period of 0xFFFF leaves room for a compare value that is never reached (100%).
+        div = 0;
+        while(1)
+        {
+            period = 24000000 / (frequency << timer1PrescalerShift[div]);
+            if (period <= 0xFFFF || div == 3)
+            {
+                break;
+            }
+            div++;
+        }
+        if (period > 0xFFFF){ period = 0xFFFF; }
+        if (period < 2){ period = 2; }
+        pwmTimer1Resolution = period;
+
+        period -= 1;
+        T1CCTL0 = 0b00000100;   // Channel 0 in compare mode so that it generates compare events.
+        T1CC0L = (uint8)period;
+        T1CC0H = (uint8)(period >> 8);
+        T1CNTL = 0;             // Reset the counter.
+        T1CTL = (div << 2) | 0b10;  // Start Timer 1 in modulo mode with the chosen prescaler.
+        return pwmTimer1Resolution;
+
+    case 3:
+        // Timer 3's prescaler can divide by any power of two from 1 to 128.
+        div = 0;
+        while(1)
+        {
+            period = 24000000 / (frequency << div);
+            if (period <= 0xFF || div == 7)
+            {
+                break;
+            }
+            div++;
+        }
+        if (period > 0xFF){ period = 0xFF; }
+        if (period < 2){ period = 2; }
+        pwmTimer3Resolution = period;
+
+        T3CCTL0 = 0b00000100;   // Channel 0 in compare mode so that it generates compare events.
+        T3CC0 = period - 1;
+        T3CTL = (div << 5) | 0b00010110;  // DIV, START = 1, CLR = 1 (reset the counter), MODE = 10 (modulo).
+        return pwmTimer3Resolution;
+
+    case 4:
+        // Timer 4 is already running for time.c; its settings must not change.
+        return TIMER4_RESOLUTION;
+
+    default:
+        return 0;
+    }
+}
+
+void pwmStop(uint8 timer)
+{
+    uint8 slot;
+    for (slot = 0; slot < SLOT_COUNT; slot++)
+    {
+        if (pwmSlotTimer[slot] == timer && pwmSlotPin[slot] != PWM_NO_PIN)
+        {
+            pwmDisable(pwmSlotPin[slot]);
+        }
+    }
+
+    switch(timer)
+    {
+    case 1:
+        T1CTL = 0;
+        pwmTimer1Resolution = 0;
+        break;
+    case 3:
+        T3CTL = 0;
+        pwmTimer3Resolution = 0;
+        break;
+    }
+}
+
+uint16 pwmResolution(uint8 timer)
+{
+    switch(timer)
+    {
+    case 1: return pwmTimer1Resolution;
+    case 3: return pwmTimer3Resolution;
+    case 4: return TIMER4_RESOLUTION;
+    default: return 0;
+    }
+}
+
+BIT pwmEnable(uint8 timer, uint8 pinNumber)
+{
+    uint8 slot;
+    BIT alternate = 0;   // 1 if the pin is in the timer's Alternative 2 location.
+
+    switch(timer)
+    {
+    case 1:
+        switch(pinNumber)
+        {
+        case 3:  slot = SLOT_T1_CH1; break;
+        case 4:  slot = SLOT_T1_CH2; break;
+        case 11: slot = SLOT_T1_CH1; alternate = 1; break;
+        case 10: slot = SLOT_T1_CH2; alternate = 1; break;
+        default: return 0;
+        }
+
+        // Both Timer 1 outputs have to be in the same location.
+        if (pwmSlotPin[slot ^ 1] != PWM_NO_PIN && alternate != ((PERCFG & 0x40) ? 1 : 0))
+        {
+            return 0;
+        }
+
+        // In Alternative 2, Timer 1 shares P1_0 and P1_1 with Timer 4.
+        if (alternate && pwmSlotPin[SLOT_T4_CH1] != PWM_NO_PIN)
+        {
+            return 0;
+        }
+        break;
+
+    case 3:
+        switch(pinNumber)
+        {
+        case 14: slot = SLOT_T3_CH1; break;
+        case 17: slot = SLOT_T3_CH1; alternate = 1; break;
+        default: return 0;
+        }
+        break;
+
+    case 4:
+        if (pinNumber != 11)
+        {
+            return 0;
+        }
+        slot = SLOT_T4_CH1;
+
+        // Timer 4 cannot have P1_0 and P1_1 while Timer 1 is using them.
+        if ((PERCFG & 0x40) && (pwmSlotPin[SLOT_T1_CH1] != PWM_NO_PIN || pwmSlotPin[SLOT_T1_CH2] != PWM_NO_PIN))
+        {
+            return 0;
+        }
+        break;
+
+    default:
+        return 0;
+    }
+
+    // Release the pin from any other timer, and the channel from any other pin.
+    pwmDisable(pinNumber);
+    if (pwmSlotPin[slot] != PWM_NO_PIN)
+    {
+        pwmDisable(pwmSlotPin[slot]);
+    }
+
+    switch(slot)
+    {
+    case SLOT_T1_CH1:
+    case SLOT_T1_CH2:
+        if (alternate)
+        {
+            PERCFG |= 0x40;     // T1CFG = 1: Timer 1 on P1_2, P1_1, P1_0.
+            P2SEL &= ~0x10;     // PRI1P1 = 0: Timer 1 has priority over Timer 4 on P1_0 and P1_1.
+        }
+        else
+        {
+            PERCFG &= ~0x40;    // T1CFG = 0: Timer 1 on P0_2, P0_3, P0_4.
+        }
+
+        if (slot == SLOT_T1_CH1)
+        {
+            T1CC1L = 0;
+            T1CC1H = 0;
+            T1CCTL1 = PWM_CCTL_OUTPUT;
+        }
+        else
+        {
+            T1CC2L = 0;
+            T1CC2H = 0;
+            T1CCTL2 = PWM_CCTL_OUTPUT;
+        }
+        break;
+
+    case SLOT_T3_CH1:
+        if (alternate)
+        {
+            PERCFG |= 0x20;     // T3CFG = 1: Timer 3 on P1_6, P1_7.
+        }
+        else
+        {
+            PERCFG &= ~0x20;    // T3CFG = 0: Timer 3 on P1_3, P1_4.
+        }
+        P2SEL |= 0x20;          // PRI2P1 = 1: Timer 3 has priority over USART1.
+        T3CC1 = 0;
+        T3CCTL1 = PWM_CCTL_OUTPUT;
+        break;
+
+    case SLOT_T4_CH1:
+        PERCFG &= ~0x10;        // T4CFG = 0: Timer 4 on P1_0, P1_1.
+        P2SEL |= 0x10;          // PRI1P1 = 1: Timer 4 has priority over Timer 1 on P1_0 and P1_1.
+        T4CC1 = 0;
+        T4CCTL1 = PWM_CCTL_OUTPUT;
+        break;
+    }
+
+    pwmSlotPin[slot] = pinNumber;
+    pwmConfigurePin(pinNumber, 1);
+    return 1;
+}
+
+void pwmDisable(uint8 pinNumber)
+{
+    uint8 slot = pwmFindSlot(pinNumber);
+    if (slot == SLOT_COUNT)
+    {
+        return;
+    }
+
+    if (pwmSequencePin == pinNumber)
+    {
+        pwmSequenceStop();
+    }
+
+    switch(slot)
+    {
+    case SLOT_T1_CH1: T1CCTL1 = 0; break;
+    case SLOT_T1_CH2: T1CCTL2 = 0; break;
+    case SLOT_T3_CH1: T3CCTL1 = 0; break;
+    case SLOT_T4_CH1: T4CCTL1 = 0; break;
+    }
+
+    pwmConfigurePin(pinNumber, 0);
+    pwmSlotPin[slot] = PWM_NO_PIN;
+}
+
+void pwmSetDutyCycle(uint8 pinNumber, uint16 duty)
+{
+    switch(pwmFindSlot(pinNumber))
+    {
+    case SLOT_T1_CH1:
+        T1CC1L = (uint8)duty;
+        T1CC1H = (uint8)(duty >> 8);
+        break;
+    case SLOT_T1_CH2:
+        T1CC2L = (uint8)duty;
+        T1CC2H = (uint8)(duty >> 8);
+        break;
+    case SLOT_T3_CH1:
+        T3CC1 = duty > 0xFF ? 0xFF : duty;
+        break;
+    case SLOT_T4_CH1:
+        T4CC1 = duty > 0xFF ? 0xFF : duty;
+        break;
+    }
+}
+
+void pwmSetDutyFraction(uint8 pinNumber, uint16 fraction)
+{
+    uint8 slot = pwmFindSlot(pinNumber);
+    uint16 resolution;
+
+    if (slot == SLOT_COUNT)
+    {
+        return;
+    }
+
+    // 0xFFFF gives a duty cycle equal to the resolution, which is 100%.
+    resolution = pwmResolution(pwmSlotTimer[slot]);
+    pwmSetDutyCycle(pinNumber, ((uint32)fraction * ((uint32)resolution + 1)) >> 16);
+}
+
+void pwmSequenceStart(uint8 pinNumber, const void XDATA * sequence, uint16 length, BIT repeat)
+{
+    uint8 slot;
+    uint16 destination;
+    uint8 dc6;
+
+    pwmSequenceStop();
+
+    slot = pwmFindSlot(pinNumber);
+    if (slot == SLOT_COUNT || length == 0)
+    {
+        return;
+    }
+    if (length > 8191){ length = 8191; }
+
+    switch(slot)
+    {
+    case SLOT_T1_CH1:
+        destination = XDATA_SFR_ADDRESS(T1CC1L);
+        dc6 = 0b10000010;       // WORDSIZE = 1 (16-bit), TRIG = 2 (T1_CH0)
+        break;
+    case SLOT_T1_CH2:
+        destination = XDATA_SFR_ADDRESS(T1CC2L);
+        dc6 = 0b10000010;       // WORDSIZE = 1 (16-bit), TRIG = 2 (T1_CH0)
+        break;
+    case SLOT_T3_CH1:
+        destination = XDATA_SFR_ADDRESS(T3CC1);
+        dc6 = 0b00000111;       // WORDSIZE = 0 (8-bit), TRIG = 7 (T3_CH0)
+        break;
+    default:
+        T4CCTL0 = 0b00000100;   // Channel 0 in compare mode so that it generates compare events (IM = 0).
+        destination = XDATA_SFR_ADDRESS(T4CC1);
+        dc6 = 0b00001001;       // WORDSIZE = 0 (8-bit), TRIG = 9 (T4_CH0)
+        break;
+    }
+    if (repeat)
+    {
+        dc6 |= 0b01000000;      // TMODE = 10 (Repeated single)
+    }
+
+    dmaConfig.pwm.SRCADDRH = (uint16)sequence >> 8;
+    dmaConfig.pwm.SRCADDRL = (uint16)sequence;
+    dmaConfig.pwm.DESTADDRH = destination >> 8;
+    dmaConfig.pwm.DESTADDRL = destination;
+    dmaConfig.pwm.VLEN_LENH = length >> 8;  // VLEN = 000: Transfer a fixed number of words.
+    dmaConfig.pwm.LENL = length;
+    dmaConfig.pwm.DC6 = dc6;
+    dmaConfig.pwm.DC7 = 0b01000000;         // SRCINC = 1 (+1 word), DESTINC = 0, IRQMASK = 0, M8 = 0, PRIORITY = 0
+
+    pwmSequencePin = pinNumber;
+    DMAARM |= (1<<DMA_CHANNEL_PWM);
+}
+
+void pwmSequenceStop()
+{
+    DMAARM = 0x80 | (1<<DMA_CHANNEL_PWM);  // Abort any transfer in progress.
+    pwmSequencePin = PWM_NO_PIN;
+}
+
+BIT pwmSequenceRunning()
+{
+    return (DMAARM & (1<<DMA_CHANNEL_PWM)) ? 1 : 0;
+}
@@ -122,6 +122,26 @@ uint8 radioComRxReceiveByte(void)
     return tmp;
 }
 
+// Assumption: The user recently called radioComRxAvailable and it returned
+// a non-zero value.
+uint8 XDATA * radioComRxReadPointer(void)
+{
+    return rxPointer;
+}
+
+// Assumption: The user recently called radioComRxAvailable and it returned
+// a value greater than or equal to size.
+void radioComRxReadDone(uint8 size)
+{
+    rxPointer += size;
+    rxBytesLeft -= size;
+
+    if (rxBytesLeft == 0)
+    {
+        radioLinkRxDoneWithPacket();
+    }
+}
+
 uint8 radioComRxControlSignals(void)
 {
     receiveMorePackets();
@@ -231,6 +251,49 @@ void radioComTxSendByte(uint8 byte)
     }
 }
 
+uint8 radioComTxWriteAvailable(void)
+{
+    if (sendSignalsSoon)
+    {
+        // See the comment in radioComTxAvailable.
+        return 0;
+    }
+
+    if (txBytesLoaded == 0)
+    {
+        // We would have to start a new packet.
+        return radioLinkTxAvailable() ? RADIO_LINK_PAYLOAD_SIZE : 0;
+    }
+
+    return RADIO_LINK_PAYLOAD_SIZE - txBytesLoaded;
+}
+
+// Assumption: The user recently called radioComTxWriteAvailable and it returned
+// a non-zero value.
+uint8 XDATA * radioComTxWritePointer(void)
+{
+    if (txBytesLoaded == 0)
+    {
+        txPointer = packetPointer = radioLinkTxCurrentPacket();
+    }
+
+    // txPointer points to the last byte written, so the next byte goes after it.
+    return txPointer + 1;
+}
+
+// Assumption: The user called radioComTxWritePointer and then wrote size bytes
+// there, and size does not exceed the last value returned by radioComTxWriteAvailable.
+void radioComTxWriteDone(uint8 size)
+{
+    txPointer += size;
+    txBytesLoaded += size;
+
+    if (txBytesLoaded == RADIO_LINK_PAYLOAD_SIZE)
+    {
+        radioComSendDataNow();
+    }
+}
+
 // If we are in the middle of building a packet, send it.
 void radioComTxControlSignals(uint8 controlSignals)
 {
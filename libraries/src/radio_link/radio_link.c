@@ -14,6 +14,7 @@
 #include <radio_link.h>
 #include <radio_registers.h>
 #include <random.h>
+#include <ring.h>
 
 /* PARAMETERS *****************************************************************/
 
@@ -43,9 +44,10 @@ int32 CODE param_radio_channel = 128;
  *  We need to be prepared at all times to receive a full packet from the other party,
  *  even if all we can do is NAK it.  Therefore, we need (at least) THREE buffers, so
  *  that two can be owned by the main loop while another is owned by the ISR and ready
- *  to receive the next packet.
+ *  to receive the next packet.  The buffers form a ring (see ring.h), so the count
+ *  must be a power of two, which makes the minimum (and the default) four.
  *
- *  If a packet is received and the main loop still owns the other two buffers,
+ *  If a packet is received and the main loop still owns all the other buffers,
  *  we respond with a NAK to the other device.
  *
  *  Ownership of the RX packet buffers is determined from radioLinkRxMainLoopIndex and radioLinkRxInterruptIndex.
@@ -57,17 +59,33 @@ int32 CODE param_radio_channel = 128;
  *                0 |                1 | rxBuffer[0]
  *                0 |                2 | rxBuffer[0 and 1]
  */
-#define RX_PACKET_COUNT  3
+#ifndef RADIO_LINK_RX_PACKET_COUNT
+#define RADIO_LINK_RX_PACKET_COUNT  4
+#endif
+#define RX_PACKET_COUNT  RADIO_LINK_RX_PACKET_COUNT
 static volatile uint8 XDATA radioLinkRxPacket[RX_PACKET_COUNT][1 + RADIO_MAX_PACKET_SIZE + 2];  // The first byte is the length, 2nd byte is link header.
 volatile uint8 DATA radioLinkRxMainLoopIndex = 0;   // The index of the next rxBuffer to read from the main loop.
 volatile uint8 DATA radioLinkRxInterruptIndex = 0;  // The index of the next rxBuffer to write to when a packet comes from the radio.
 
 /* txPackets are handled similarly */
-#define TX_PACKET_COUNT 16
+#ifndef RADIO_LINK_TX_PACKET_COUNT
+#define RADIO_LINK_TX_PACKET_COUNT  16
+#endif
+#define TX_PACKET_COUNT RADIO_LINK_TX_PACKET_COUNT
 static volatile uint8 XDATA radioLinkTxPacket[TX_PACKET_COUNT][1 + RADIO_MAX_PACKET_SIZE];  // The first byte is the length, 2nd byte is link header.
 volatile uint8 DATA radioLinkTxMainLoopIndex = 0;   // The index of the next txPacket to write to in the main loop.
 volatile uint8 DATA radioLinkTxInterruptIndex = 0;  // The index of the current txPacket we are trying to send on the radio.
 
+RING_SIZE_CHECK(radioLinkRxPacket, RX_PACKET_COUNT)
+RING_SIZE_CHECK(radioLinkTxPacket, TX_PACKET_COUNT)
+STATIC_ASSERT(radioLinkRxPacketCount, RX_PACKET_COUNT >= 4)   // See the rxPackets comment above.
+
+// The most XDATA the packet buffers may use; the CC2511 only has 3840 bytes.
+#ifndef RADIO_LINK_XDATA_BUDGET
+#define RADIO_LINK_XDATA_BUDGET  1024
+#endif
+STATIC_ASSERT(radioLinkXdataBudget, sizeof(radioLinkRxPacket) + sizeof(radioLinkTxPacket) <= RADIO_LINK_XDATA_BUDGET)
+
 uint8 XDATA shortTxPacket[2];
 
 // The number of times the current TX packet has been transmitted.
@@ -144,13 +162,12 @@ BIT radioLinkConnected()
 
 uint8 radioLinkTxAvailable(void)
 {
-    // Assumption: TX_PACKET_COUNT is a power of 2
-    return (radioLinkTxInterruptIndex - radioLinkTxMainLoopIndex - 1) & (TX_PACKET_COUNT - 1);
+    return RING_FREE(radioLinkTxMainLoopIndex, radioLinkTxInterruptIndex, TX_PACKET_COUNT);
 }
 
 uint8 radioLinkTxQueued(void)
 {
-    return (radioLinkTxMainLoopIndex - radioLinkTxInterruptIndex) & (TX_PACKET_COUNT - 1);
+    return RING_USED(radioLinkTxMainLoopIndex, radioLinkTxInterruptIndex, TX_PACKET_COUNT);
 }
 
 uint8 XDATA * radioLinkTxCurrentPacket()
@@ -172,14 +189,7 @@ void radioLinkTxSendPacket(uint8 payloadType)
     radioLinkTxPacket[radioLinkTxMainLoopIndex][RADIO_LINK_PACKET_TYPE_OFFSET] = payloadType << RADIO_LINK_PAYLOAD_TYPE_BIT_OFFSET;
 
     // Update our index of which packet to populate in the main loop.
-    if (radioLinkTxMainLoopIndex == TX_PACKET_COUNT - 1)
-    {
-        radioLinkTxMainLoopIndex = 0;
-    }
-    else
-    {
-        radioLinkTxMainLoopIndex++;
-    }
+    radioLinkTxMainLoopIndex = RING_NEXT(radioLinkTxMainLoopIndex, TX_PACKET_COUNT);
 
     // Make sure that radioMacEventHandler runs soon so it can see this new data and send it.
     // This must be done LAST.
@@ -190,7 +200,7 @@ void radioLinkTxSendPacket(uint8 payloadType)
 
 uint8 XDATA * radioLinkRxCurrentPacket(void)
 {
-    if (radioLinkRxMainLoopIndex == radioLinkRxInterruptIndex)
+    if (RING_IS_EMPTY(radioLinkRxInterruptIndex, radioLinkRxMainLoopIndex))
     {
         return 0;
     }
@@ -205,14 +215,7 @@ uint8 radioLinkRxCurrentPayloadType(void)
 
 void radioLinkRxDoneWithPacket(void)
 {
-    if (radioLinkRxMainLoopIndex == RX_PACKET_COUNT - 1)
-    {
-        radioLinkRxMainLoopIndex = 0;
-    }
-    else
-    {
-        radioLinkRxMainLoopIndex++;
-    }
+    radioLinkRxMainLoopIndex = RING_NEXT(radioLinkRxMainLoopIndex, RX_PACKET_COUNT);
 }
 
 /* FUNCTIONS CALLED IN RF_ISR *************************************************/
@@ -330,14 +333,7 @@ void radioMacEventHandler(uint8 event) // called by the MAC in an ISR
                 // on the other Wixel.
 
                 // Give ownership of the current TX packet back to the main loop by updated radioLinkTxInterruptIndex.
-                if (radioLinkTxInterruptIndex == TX_PACKET_COUNT - 1)
-                {
-                    radioLinkTxInterruptIndex = 0;
-                }
-                else
-                {
-                    radioLinkTxInterruptIndex++;
-                }
+                radioLinkTxInterruptIndex = RING_NEXT(radioLinkTxInterruptIndex, TX_PACKET_COUNT);
 
                 // Reset the transmission counter.
                 radioLinkTxCurrentPacketTries = 0;
@@ -357,19 +353,8 @@ void radioMacEventHandler(uint8 event) // called by the MAC in an ISR
             {
                 // This packet is NOT a retransmission of the last packet we received.
 
-                uint8 nextradioLinkRxInterruptIndex;
-
                 // See if we can give the data to the main loop.
-                if (radioLinkRxInterruptIndex == RX_PACKET_COUNT - 1)
-                {
-                    nextradioLinkRxInterruptIndex = 0;
-                }
-                else
-                {
-                    nextradioLinkRxInterruptIndex = radioLinkRxInterruptIndex + 1;
-                }
-
-                if (nextradioLinkRxInterruptIndex != radioLinkRxMainLoopIndex)
+                if (!RING_IS_FULL(radioLinkRxInterruptIndex, radioLinkRxMainLoopIndex, RX_PACKET_COUNT))
                 {
                     // We can accept this packet and send an ACK!
 
@@ -390,7 +375,7 @@ void radioMacEventHandler(uint8 event) // called by the MAC in an ISR
                     // (This overrides the 1-byte RF packet length.)
                     currentRxPacket[0] = payloadType;
 
-                    radioLinkRxInterruptIndex = nextradioLinkRxInterruptIndex;
+                    radioLinkRxInterruptIndex = RING_NEXT(radioLinkRxInterruptIndex, RX_PACKET_COUNT);
                 }
                 else
                 {
@@ -54,6 +54,15 @@ volatile BIT radioTxUnderflowOccurred = 0;
 #define RADIO_MAC_STATE_TX       3
 volatile uint8 DATA radioMacState = RADIO_MAC_STATE_OFF;
 
+// The state of the MAC saved by radioMacSleep() so radioMacResume() can
+// continue where it left off.  The sleep timer registers are saved because
+// powerSleep() uses them, and radioMacRx() uses them for the RX timeout.
+static uint8 radioMacSavedState;
+static uint8 radioMacSavedMcsm2;
+static uint8 radioMacSavedWorctrl;
+static uint8 radioMacSavedWorevt1;
+static uint8 radioMacSavedWorevt0;
+
 ISR(RF, 0)
 {
     S1CON = 0; // Clear the general RFIF interrupt registers
@@ -204,23 +213,89 @@ void radioMacStrobe()
     S1CON |= 3;
 }
 
+// Sets the registers that the MAC needs, other than the ones set by
+// radioRegistersInit().
+static void radioMacConfigure()
+{
+    // MCSM.FS_AUTOCAL = 1: Calibrate freq when going from IDLE to RX or TX (or FSTXON).
+    MCSM0 = 0x14;    // Main Radio Control State Machine Configuration
+    MCSM1 = 0x05;    // Disable CCA.  After RX, go to FSTXON.  After TX, go to FSTXON.
+
+    RFIM = 0xF0;     // Enable these interrupts: DONE, RXOVF, TXUNF, TIMEOUT
+
+    dmaConfig.radio.DC6 = 19; // WORDSIZE = 0, TMODE = 0, TRIG = 19
+}
+
+void radioMacSleep()
+{
+    IEN2 &= ~0x01;                          // Disable RF general interrupt.
+
+    radioMacSavedState = radioMacState;
+    radioMacSavedMcsm2 = MCSM2;
+    radioMacSavedWorctrl = WORCTRL & ~0x04; // Do not save WOR_RESET.
+    radioMacSavedWorevt1 = WOREVT1;
+    radioMacSavedWorevt0 = WOREVT0;
+
+    RFST = SIDLE;
+    while(MARCSTATE != 0x01){};             // Wait for the radio to reach the IDLE state.
+
+    DMAARM = 0x80 | (1<<DMA_CHANNEL_RADIO); // Abort any ongoing radio DMA transfer.
+    DMAIRQ &= ~(1<<DMA_CHANNEL_RADIO);      // Clear any pending radio DMA interrupt
+
+    RFIF = 0;                               // Clear all the radio interrupt flags.
+    S1CON = 0;
+    strobe = 0;
+
+    radioMacState = RADIO_MAC_STATE_OFF;
+}
+
+void radioMacResume()
+{
+    radioRegistersInit();
+    radioMacConfigure();
+
+    MCSM2 = radioMacSavedMcsm2;
+    WORCTRL = radioMacSavedWorctrl;
+    WOREVT1 = radioMacSavedWorevt1;
+    WOREVT0 = radioMacSavedWorevt0;
+
+    // The DMA configuration is in XDATA, which is retained in PM2, so the
+    // packet that was being sent or received is still set up.  Start it again.
+    radioMacState = radioMacSavedState;
+    switch(radioMacState)
+    {
+    case RADIO_MAC_STATE_RX:
+        DMAARM |= (1<<DMA_CHANNEL_RADIO);   // Arm DMA channel.
+        RFST = SRX;                         // Switch radio to RX.
+        break;
+    case RADIO_MAC_STATE_TX:
+        DMAARM |= (1<<DMA_CHANNEL_RADIO);   // Arm DMA channel.
+        RFST = STX;                         // Switch radio to TX.
+        break;
+    }
+
+    IEN2 |= 0x01;    // Enable RF general interrupt
+
+    if (radioMacState != RADIO_MAC_STATE_RX && radioMacState != RADIO_MAC_STATE_TX)
+    {
+        // The MAC was not doing anything, so let radioMacEventHandler()
+        // decide what to do next.
+        radioMacStrobe();
+    }
+}
+
 /** Initializes the radio_mac library.
  *  NOTE: The CHANNR register does not get configured here. **/
 void radioMacInit()
 {
     radioRegistersInit();
+    radioMacConfigure();
 
-    // MCSM.FS_AUTOCAL = 1: Calibrate freq when going from IDLE to RX or TX (or FSTXON).
-    MCSM0 = 0x14;    // Main Radio Control State Machine Configuration
-    MCSM1 = 0x05;    // Disable CCA.  After RX, go to FSTXON.  After TX, go to FSTXON.
     MCSM2 = 0x07;    // NOTE: MCSM2 also gets set every time we go into RX mode.
 
     IEN2 |= 0x01;    // Enable RF general interrupt
-    RFIM = 0xF0;     // Enable these interrupts: DONE, RXOVF, TXUNF, TIMEOUT
 
     EA = 1;          // Enable interrupts in general
-
-    dmaConfig.radio.DC6 = 19; // WORDSIZE = 0, TMODE = 0, TRIG = 19
 }
 
 void radioMacRx(uint8 XDATA * packet, uint8 timeout)
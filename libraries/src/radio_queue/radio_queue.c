@@ -19,6 +19,7 @@
 #include <radio_queue.h>
 #include <radio_registers.h>
 #include <random.h>
+#include <ring.h>
 
 /* PARAMETERS *****************************************************************/
 
@@ -35,9 +36,11 @@ int32 CODE param_radio_channel = 128;
  *  We need to be prepared at all times to receive a full packet from another
  *  party, even if we cannot give it to the main loop.  Therefore, we need (at
  *  least) THREE buffers, so that two can be owned by the main loop while
- *  another is owned by the ISR and ready to receive the next packet.
+ *  another is owned by the ISR and ready to receive the next packet.  The
+ *  buffers form a ring (see ring.h), so the count must be a power of two,
+ *  which makes the minimum (and the default) four.
  *
- *  If a packet is received and the main loop still owns the other two buffers,
+ *  If a packet is received and the main loop still owns all the other buffers,
  *  we discard it.
  *
  *  Ownership of the RX packet buffers is determined from radioQueueRxMainLoopIndex and radioQueueRxInterruptIndex.
@@ -48,24 +51,66 @@ int32 CODE param_radio_channel = 128;
  *                0 |                0 | None
  *                0 |                1 | rxBuffer[0]
  *                0 |                2 | rxBuffer[0 and 1]
+ *
+ *  The ring holds pointers to the buffers, so radioQueueRxTakePacket() can give
+ *  a buffer owned by the main loop to the app and put another one in its place.
+ *  The pointers start out pointing to radioQueueRxPacket, unless the app
+ *  provided its own buffers with radioQueueRxSetBuffer().
+ *
+ *  If RADIO_QUEUE_EXTERNAL_RX_BUFFERS is defined (radio_queue_external_rx.lib),
+ *  radioQueueRxPacket is not allocated and the app must provide every buffer.
  */
-#define RX_PACKET_COUNT  3
-static volatile uint8 XDATA radioQueueRxPacket[RX_PACKET_COUNT][1 + RADIO_MAX_PACKET_SIZE + 2];  // The first byte is the length.
+#ifndef RADIO_QUEUE_RX_PACKET_COUNT
+#define RADIO_QUEUE_RX_PACKET_COUNT  4
+#endif
+#define RX_PACKET_COUNT  RADIO_QUEUE_RX_PACKET_COUNT
+#ifndef RADIO_QUEUE_EXTERNAL_RX_BUFFERS
+static volatile uint8 XDATA radioQueueRxPacket[RX_PACKET_COUNT][RADIO_QUEUE_RX_BUFFER_SIZE];  // The first byte is the length.
+#define RX_PACKET_XDATA  sizeof(radioQueueRxPacket)
+#else
+#define RX_PACKET_XDATA  0
+#endif
+static uint8 XDATA * XDATA radioQueueRxBuffer[RX_PACKET_COUNT] = {0};
 static volatile uint8 DATA radioQueueRxMainLoopIndex = 0;   // The index of the next rxBuffer to read from the main loop.
 static volatile uint8 DATA radioQueueRxInterruptIndex = 0;  // The index of the next rxBuffer to write to when a packet comes from the radio.
 
 /* txPackets are handled similarly */
-#define TX_PACKET_COUNT 16
+#ifndef RADIO_QUEUE_TX_PACKET_COUNT
+#define RADIO_QUEUE_TX_PACKET_COUNT  16
+#endif
+#define TX_PACKET_COUNT RADIO_QUEUE_TX_PACKET_COUNT
 static volatile uint8 XDATA radioQueueTxPacket[TX_PACKET_COUNT][1 + RADIO_MAX_PACKET_SIZE];  // The first byte is the length.
 static volatile uint8 DATA radioQueueTxMainLoopIndex = 0;   // The index of the next txPacket to write to in the main loop.
 static volatile uint8 DATA radioQueueTxInterruptIndex = 0;  // The index of the current txPacket we are trying to send on the radio.
 
+RING_SIZE_CHECK(radioQueueRxPacket, RX_PACKET_COUNT)
+RING_SIZE_CHECK(radioQueueTxPacket, TX_PACKET_COUNT)
+STATIC_ASSERT(radioQueueRxPacketCount, RX_PACKET_COUNT >= 4)   // See the rxPackets comment above.
+
+// The most XDATA the packet buffers may use; the CC2511 only has 3840 bytes.
+#ifndef RADIO_QUEUE_XDATA_BUDGET
+#define RADIO_QUEUE_XDATA_BUDGET  1024
+#endif
+STATIC_ASSERT(radioQueueXdataBudget, RX_PACKET_XDATA + sizeof(radioQueueTxPacket) <= RADIO_QUEUE_XDATA_BUDGET)
+
 BIT radioQueueAllowCrcErrors = 0;
 
 /* GENERAL FUNCTIONS **********************************************************/
 
 void radioQueueInit()
 {
+#ifndef RADIO_QUEUE_EXTERNAL_RX_BUFFERS
+    uint8 i;
+
+    for (i = 0; i < RX_PACKET_COUNT; i++)
+    {
+        if (radioQueueRxBuffer[i] == 0)
+        {
+            radioQueueRxBuffer[i] = radioQueueRxPacket[i];
+        }
+    }
+#endif
+
     randomSeedFromSerialNumber();
 
     PKTLEN = RADIO_MAX_PACKET_SIZE;
@@ -86,13 +131,12 @@ static uint8 randomTxDelay()
 
 uint8 radioQueueTxAvailable(void)
 {
-    // Assumption: TX_PACKET_COUNT is a power of 2
-    return (radioQueueTxInterruptIndex - radioQueueTxMainLoopIndex - 1) & (TX_PACKET_COUNT - 1);
+    return RING_FREE(radioQueueTxMainLoopIndex, radioQueueTxInterruptIndex, TX_PACKET_COUNT);
 }
 
 uint8 radioQueueTxQueued(void)
 {
-    return (radioQueueTxMainLoopIndex - radioQueueTxInterruptIndex) & (TX_PACKET_COUNT - 1);
+    return RING_USED(radioQueueTxMainLoopIndex, radioQueueTxInterruptIndex, TX_PACKET_COUNT);
 }
 
 uint8 XDATA * radioQueueTxCurrentPacket()
@@ -108,14 +152,7 @@ uint8 XDATA * radioQueueTxCurrentPacket()
 void radioQueueTxSendPacket(void)
 {
     // Update our index of which packet to populate in the main loop.
-    if (radioQueueTxMainLoopIndex == TX_PACKET_COUNT - 1)
-    {
-        radioQueueTxMainLoopIndex = 0;
-    }
-    else
-    {
-        radioQueueTxMainLoopIndex++;
-    }
+    radioQueueTxMainLoopIndex = RING_NEXT(radioQueueTxMainLoopIndex, TX_PACKET_COUNT);
 
     // Make sure that radioMacEventHandler runs soon so it can see this new data and send it.
     // This must be done LAST.
@@ -126,22 +163,42 @@ void radioQueueTxSendPacket(void)
 
 uint8 XDATA * radioQueueRxCurrentPacket(void)
 {
-    if (radioQueueRxMainLoopIndex == radioQueueRxInterruptIndex)
+    if (RING_IS_EMPTY(radioQueueRxInterruptIndex, radioQueueRxMainLoopIndex))
     {
         return 0;
     }
-    return radioQueueRxPacket[radioQueueRxMainLoopIndex];
+    return radioQueueRxBuffer[radioQueueRxMainLoopIndex];
 }
 
 void radioQueueRxDoneWithPacket(void)
 {
-    if (radioQueueRxMainLoopIndex == RX_PACKET_COUNT - 1)
+    radioQueueRxMainLoopIndex = RING_NEXT(radioQueueRxMainLoopIndex, RX_PACKET_COUNT);
+}
+
+uint8 XDATA * radioQueueRxTakePacket(uint8 XDATA * replacement)
+{
+    uint8 XDATA * packet = radioQueueRxCurrentPacket();
+    if (packet == 0)
     {
-        radioQueueRxMainLoopIndex = 0;
+        return 0;
     }
-    else
+
+    // The main loop owns this buffer, so the ISR is not using its pointer.
+    radioQueueRxBuffer[radioQueueRxMainLoopIndex] = replacement;
+    radioQueueRxDoneWithPacket();
+    return packet;
+}
+
+uint8 radioQueueRxBufferCount(void)
+{
+    return RX_PACKET_COUNT;
+}
+
+void radioQueueRxSetBuffer(uint8 index, uint8 XDATA * buffer)
+{
+    if (index < RX_PACKET_COUNT)
     {
-        radioQueueRxMainLoopIndex++;
+        radioQueueRxBuffer[index] = buffer;
     }
 }
 
@@ -156,7 +213,7 @@ static void takeInitiative()
     }
     else
     {
-        radioMacRx(radioQueueRxPacket[radioQueueRxInterruptIndex], 0);
+        radioMacRx(radioQueueRxBuffer[radioQueueRxInterruptIndex], 0);
     }
 }
 
@@ -170,22 +227,15 @@ void radioMacEventHandler(uint8 event) // called by the MAC in an ISR
     else if (event == RADIO_MAC_EVENT_TX)
     {
         // Give ownership of the current TX packet back to the main loop by updated radioQueueTxInterruptIndex.
-        if (radioQueueTxInterruptIndex == TX_PACKET_COUNT - 1)
-        {
-            radioQueueTxInterruptIndex = 0;
-        }
-        else
-        {
-            radioQueueTxInterruptIndex++;
-        }
+        radioQueueTxInterruptIndex = RING_NEXT(radioQueueTxInterruptIndex, TX_PACKET_COUNT);
 
         // We sent a packet, so now let's give another party a chance to talk.
-        radioMacRx(radioQueueRxPacket[radioQueueRxInterruptIndex], randomTxDelay());
+        radioMacRx(radioQueueRxBuffer[radioQueueRxInterruptIndex], randomTxDelay());
         return;
     }
     else if (event == RADIO_MAC_EVENT_RX)
     {
-        uint8 XDATA * currentRxPacket = radioQueueRxPacket[radioQueueRxInterruptIndex];
+        uint8 XDATA * currentRxPacket = radioQueueRxBuffer[radioQueueRxInterruptIndex];
 
         if (!radioQueueAllowCrcErrors && !radioCrcPassed())
         {
@@ -204,22 +254,11 @@ void radioMacEventHandler(uint8 event) // called by the MAC in an ISR
         {
             // We received a packet that contains actual data.
 
-            uint8 nextradioQueueRxInterruptIndex;
-
             // See if we can give the data to the main loop.
-            if (radioQueueRxInterruptIndex == RX_PACKET_COUNT - 1)
-            {
-                nextradioQueueRxInterruptIndex = 0;
-            }
-            else
-            {
-                nextradioQueueRxInterruptIndex = radioQueueRxInterruptIndex + 1;
-            }
-
-            if (nextradioQueueRxInterruptIndex != radioQueueRxMainLoopIndex)
+            if (!RING_IS_FULL(radioQueueRxInterruptIndex, radioQueueRxMainLoopIndex, RX_PACKET_COUNT))
             {
                 // We can accept this packet!
-                radioQueueRxInterruptIndex = nextradioQueueRxInterruptIndex;
+                radioQueueRxInterruptIndex = RING_NEXT(radioQueueRxInterruptIndex, RX_PACKET_COUNT);
             }
         }
 
@@ -0,0 +1,12 @@
+# This library will be made by linking radio_queue_external_rx.rel, which is
+# compiled from a copy of the radio_queue library without its own RX packet
+# buffers.  Apps that use it must give the queue every RX buffer with
+# radioQueueRxSetBuffer() before calling radioQueueInit().
+LIB_RELS := libraries/src/radio_queue_external_rx/radio_queue_external_rx.rel
+
+libraries/src/radio_queue_external_rx/radio_queue_external_rx.rel : C_FLAGS += -DRADIO_QUEUE_EXTERNAL_RX_BUFFERS
+
+libraries/src/radio_queue_external_rx/radio_queue_external_rx.c : libraries/src/radio_queue/radio_queue.c
+	$(CP) $< $@
+
+TARGETS += libraries/src/radio_queue_external_rx/radio_queue_external_rx.c
@@ -0,0 +1,185 @@
+/* sensor_node.c: A framework for nodes that wake up, send a report over
+ * the radio, and sleep in PM2 until the next report.
+ * See sensor_node.h for the public interface.
+ */
+
+#include <cc2511_map.h>
+#include <sensor_node.h>
+#include <board.h>
+#include <time.h>
+
+#define SENSOR_NODE_STATE_REPORT    0   // The app should send a report.
+#define SENSOR_NODE_STATE_SENDING   1   // Waiting for radio_queue to send the report.
+#define SENSOR_NODE_STATE_WAIT_ACK  2   // Waiting for an acknowledgment.
+#define SENSOR_NODE_STATE_SLEEP     3   // Waiting for the next report.
+
+static uint8 DATA sensorNodeState;
+static uint8 sensorNodeAttemptCount;
+
+static uint16 sensorNodePeriod;
+static uint8 sensorNodeAckTimeout;
+static uint8 sensorNodeMaxAttempts;
+
+// The value of getMs() when the next report is due.
+static uint32 sensorNodeNextReport;
+
+// The lower 16 bits of getMs() when we started waiting for an acknowledgment.
+static uint16 sensorNodeAckStart;
+
+static POWER_CLIENT XDATA sensorNodePowerClient;
+
+static uint8 sensorNodeDeepestMode()
+{
+    switch(sensorNodeState)
+    {
+    case SENSOR_NODE_STATE_REPORT:  return POWER_MODE_ACTIVE;
+    case SENSOR_NODE_STATE_SLEEP:   return POWER_MODE_PM2;
+    default:                        return POWER_MODE_IDLE;  // The radio interrupt will wake us up.
+    }
+}
+
+static void sensorNodeRadioSleeping(uint8 mode)
+{
+    radioMacSleep();
+}
+
+static void sensorNodeRadioWaking(uint8 mode)
+{
+    radioMacResume();
+}
+
+void sensorNodeInit(uint16 periodMs, uint8 ackTimeoutMs, uint8 maxAttempts)
+{
+    radioQueueInit();
+
+    sensorNodePeriod = periodMs;
+    sensorNodeAckTimeout = ackTimeoutMs;
+    sensorNodeMaxAttempts = maxAttempts;
+
+    sensorNodeState = SENSOR_NODE_STATE_REPORT;
+    sensorNodeAttemptCount = 1;
+    sensorNodeNextReport = getMs() + periodMs;
+
+    // Stay in PM0 while USB is connected so the node can still be configured.
+    powerRegisterUsb();
+    sensorNodePowerClient.deepestMode = sensorNodeDeepestMode;
+    sensorNodePowerClient.sleeping = sensorNodeRadioSleeping;
+    sensorNodePowerClient.waking = sensorNodeRadioWaking;
+    powerRegister(&sensorNodePowerClient);
+}
+
+BIT sensorNodeIsAck(uint8 XDATA * packet)
+{
+    return packet[0] == SENSOR_NODE_ACK_LENGTH &&
+        packet[1] == serialNumber[0] && packet[2] == serialNumber[1] &&
+        packet[3] == serialNumber[2] && packet[4] == serialNumber[3];
+}
+
+void sensorNodeService()
+{
+    uint8 XDATA * packet;
+
+    // Acknowledgments that arrive late are discarded here too.
+    if ((packet = radioQueueRxCurrentPacket()) && sensorNodeIsAck(packet))
+    {
+        radioQueueRxDoneWithPacket();
+        if (sensorNodeState == SENSOR_NODE_STATE_WAIT_ACK)
+        {
+            sensorNodeState = SENSOR_NODE_STATE_SLEEP;
+        }
+    }
+
+    switch(sensorNodeState)
+    {
+    case SENSOR_NODE_STATE_SENDING:
+        if (radioQueueTxQueued() == 0)
+        {
+            // All the packets of the report have been transmitted.
+            if (sensorNodeAckTimeout)
+            {
+                sensorNodeAckStart = (uint16)getMs();
+                sensorNodeState = SENSOR_NODE_STATE_WAIT_ACK;
+            }
+            else
+            {
+                sensorNodeState = SENSOR_NODE_STATE_SLEEP;
+            }
+        }
+        break;
+
+    case SENSOR_NODE_STATE_WAIT_ACK:
+        if ((uint16)((uint16)getMs() - sensorNodeAckStart) >= sensorNodeAckTimeout)
+        {
+            if (sensorNodeAttemptCount < sensorNodeMaxAttempts)
+            {
+                sensorNodeAttemptCount++;
+                sensorNodeState = SENSOR_NODE_STATE_REPORT;
+            }
+            else
+            {
+                // Give up on this report.
+                sensorNodeState = SENSOR_NODE_STATE_SLEEP;
+            }
+        }
+        break;
+
+    case SENSOR_NODE_STATE_SLEEP:
+    {
+        uint32 now = getMs();
+        if ((int32)(now - sensorNodeNextReport) >= 0)
+        {
+            sensorNodeNextReport += sensorNodePeriod;
+            if ((int32)(now - sensorNodeNextReport) >= 0)
+            {
+                // We missed at least one whole period; skip the missed reports.
+                sensorNodeNextReport = now + sensorNodePeriod;
+            }
+            sensorNodeAttemptCount = 1;
+            sensorNodeState = SENSOR_NODE_STATE_REPORT;
+        }
+        break;
+    }
+    }
+}
+
+BIT sensorNodeReportDue()
+{
+    return sensorNodeState == SENSOR_NODE_STATE_REPORT;
+}
+
+void sensorNodeReportQueued()
+{
+    sensorNodeState = SENSOR_NODE_STATE_SENDING;
+}
+
+uint8 sensorNodeAttempt()
+{
+    return sensorNodeAttemptCount;
+}
+
+BIT sensorNodeSleeping()
+{
+    return sensorNodeState == SENSOR_NODE_STATE_SLEEP;
+}
+
+uint16 sensorNodeMsUntilWake()
+{
+    int32 remaining;
+
+    if (sensorNodeState != SENSOR_NODE_STATE_SLEEP)
+    {
+        // powerIdle() returns at once if we return 0, so return 1 to let it
+        // ask sensorNodeDeepestMode(): PM0 while waiting for the radio, or
+        // no sleep at all while a report is due.  The millisecond tick and
+        // the radio interrupt wake the CPU from PM0.
+        return 1;
+    }
+
+    remaining = sensorNodeNextReport - getMs() - SENSOR_NODE_WAKE_MARGIN_MS;
+    if (remaining < 1)
+    {
+        // Wait in PM0 until the next millisecond tick.
+        return 1;
+    }
+    return remaining;
+}
@@ -0,0 +1,114 @@
+/* soft_timer.c: A sorted list of timers with main-loop callbacks.
+ * See soft_timer.h for the public interface.
+ *
+ * The running timers are kept in a singly linked list sorted by deadline,
+ * so the earliest deadline is always at the head.  softTimerService() and
+ * softTimerMsUntilNext() only look at the head, and starting or stopping a
+ * timer walks the list to find its place.  Deadlines are compared with
+ * signed 16-bit differences, which is valid because every deadline is less
+ * than 32768 ms away from the current time.
+ */
+
+#include <cc2511_map.h>
+#include <soft_timer.h>
+#include <time.h>
+
+static SOFT_TIMER XDATA * XDATA softTimerHead = 0;
+
+static void softTimerInsert(SOFT_TIMER XDATA * timer)
+{
+    SOFT_TIMER XDATA * XDATA * link = &softTimerHead;
+
+    // Timers with equal deadlines fire in the order they were inserted.
+    while (*link && (int16)((*link)->deadline - timer->deadline) <= 0)
+    {
+        link = &(*link)->next;
+    }
+
+    timer->next = *link;
+    *link = timer;
+    timer->active = 1;
+}
+
+static void softTimerRemove(SOFT_TIMER XDATA * timer)
+{
+    SOFT_TIMER XDATA * XDATA * link = &softTimerHead;
+
+    while (*link)
+    {
+        if (*link == timer)
+        {
+            *link = timer->next;
+            break;
+        }
+        link = &(*link)->next;
+    }
+
+    timer->active = 0;
+}
+
+void softTimerStart(SOFT_TIMER XDATA * timer, uint16 delayMs, uint16 periodMs, SoftTimerCallback * callback)
+{
+    if (timer->active)
+    {
+        softTimerRemove(timer);
+    }
+
+    if (delayMs == 0)
+    {
+        delayMs = 1;
+    }
+
+    timer->deadline = (uint16)getMs() + delayMs;
+    timer->period = periodMs;
+    timer->callback = callback;
+    softTimerInsert(timer);
+}
+
+void softTimerStop(SOFT_TIMER XDATA * timer)
+{
+    if (timer->active)
+    {
+        softTimerRemove(timer);
+    }
+}
+
+void softTimerService()
+{
+    uint16 now = (uint16)getMs();
+    SOFT_TIMER XDATA * timer;
+
+    while ((timer = softTimerHead) != 0 && (int16)(now - timer->deadline) >= 0)
+    {
+        softTimerHead = timer->next;
+        timer->active = 0;
+
+        if (timer->period)
+        {
+            timer->deadline += timer->period;
+            if ((int16)(timer->deadline - now) <= 0)
+            {
+                // We missed at least one whole period; skip the missed calls.
+                timer->deadline = now + timer->period;
+            }
+            softTimerInsert(timer);
+        }
+
+        // The callback might start or stop other timers, so the head is
+        // read again after it returns.
+        timer->callback();
+    }
+}
+
+uint16 softTimerMsUntilNext()
+{
+    int16 remaining;
+
+    if (softTimerHead == 0)
+    {
+        return 0xFFFF;
+    }
+
+    remaining = softTimerHead->deadline - (uint16)getMs();
+    return remaining < 0 ? 0 : remaining;
+}
@@ -0,0 +1,147 @@
+/* task.c: A run queue for cooperative tasks.  See task.h for the public
+ * interface.
+ *
+ * Every started task is in exactly one place:
+ * - the run queue (a FIFO),
+ * - the sleep list (sorted by wake time, so only its head needs checking),
+ * - the wait list of an event (events with waiters are in the armed list), or
+ * - nowhere, if it has ended.
+ */
+
+#include <cc2511_map.h>
+#include <task.h>
+
+static TASK XDATA * XDATA taskRunHead = 0;
+static TASK XDATA * XDATA taskRunTail = 0;
+static uint8 taskRunCount = 0;
+
+static TASK XDATA * XDATA taskSleepHead = 0;
+
+static TASK_EVENT XDATA * XDATA taskArmedHead = 0;
+
+static void taskEnqueue(TASK XDATA * task)
+{
+    task->next = 0;
+    if (taskRunTail)
+    {
+        taskRunTail->next = task;
+    }
+    else
+    {
+        taskRunHead = task;
+    }
+    taskRunTail = task;
+    taskRunCount++;
+}
+
+static TASK XDATA * taskDequeue()
+{
+    TASK XDATA * task = taskRunHead;
+    taskRunHead = task->next;
+    if (taskRunHead == 0)
+    {
+        taskRunTail = 0;
+    }
+    taskRunCount--;
+    return task;
+}
+
+static void taskSleep(TASK XDATA * task)
+{
+    TASK XDATA * XDATA * link = &taskSleepHead;
+
+    // Insert the task after all the tasks that wake up at the same time or earlier.
+    while (*link && (int16)(task->wakeTime - (*link)->wakeTime) >= 0)
+    {
+        link = &(*link)->next;
+    }
+    task->next = *link;
+    *link = task;
+}
+
+static void taskWait(TASK XDATA * task)
+{
+    TASK_EVENT XDATA * event = task->event;
+
+    if (event->waiters == 0)
+    {
+        // This is the first waiter, so add the event to the armed list.
+        event->nextArmed = taskArmedHead;
+        taskArmedHead = event;
+    }
+    task->next = event->waiters;
+    event->waiters = task;
+}
+
+void taskStart(TASK XDATA * task, TaskFunction * function)
+{
+    task->function = function;
+    task->line = 0;
+    task->running = 1;
+    taskEnqueue(task);
+}
+
+uint8 taskService()
+{
+    uint16 now = (uint16)getMs();
+    TASK_EVENT XDATA * XDATA * link;
+    TASK_EVENT XDATA * event;
+    TASK XDATA * task;
+    uint8 count;
+
+    // Wake up the tasks whose sleep time is over.
+    while (taskSleepHead && (int16)(now - taskSleepHead->wakeTime) >= 0)
+    {
+        task = taskSleepHead;
+        taskSleepHead = task->next;
+        taskEnqueue(task);
+    }
+
+    // Wake up the tasks waiting for events that have been signaled.
+    link = &taskArmedHead;
+    while ((event = *link) != 0)
+    {
+        if (event->signaled)
+        {
+            *link = event->nextArmed;
+            while (event->waiters)
+            {
+                task = event->waiters;
+                event->waiters = task->next;
+                taskEnqueue(task);
+            }
+        }
+        else
+        {
+            link = &event->nextArmed;
+        }
+    }
+
+    // Run each task that is in the run queue now.  Tasks that yield go to the
+    // back of the queue and run again on the next call.
+    count = taskRunCount;
+    while (count--)
+    {
+        task = taskDequeue();
+        switch (task->function(task))
+        {
+        case TASK_STATUS_YIELDED:
+            taskEnqueue(task);
+            break;
+
+        case TASK_STATUS_SLEEPING:
+            taskSleep(task);
+            break;
+
+        case TASK_STATUS_WAITING:
+            taskWait(task);
+            break;
+
+        default:
+            task->running = 0;
+            break;
+        }
+    }
+
+    return taskRunCount;
+}
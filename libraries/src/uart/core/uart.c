@@ -5,6 +5,7 @@
 
 #include <cc2511_map.h>
 #include <cc2511_types.h>
+#include <ring.h>
 
 #if defined(__CDT_PARSER__)
 #define UART0
@@ -67,18 +68,28 @@
 #define uartNTxSendByte             uart1TxSendByte
 #endif
 
-static volatile uint8 XDATA uartTxBuffer[256];         // sizeof(uartTxBuffer) must be a power of two
-static volatile uint8 DATA uartTxBufferMainLoopIndex;  // Index of next byte main loop will write.
-static volatile uint8 DATA uartTxBufferInterruptIndex; // Index of next byte interrupt will read.
+// The TX and RX buffers are rings (see ring.h), so their sizes must be
+// powers of two no larger than 256.
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 256
+#endif
+static volatile uint8 XDATA uartTxBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint8 DATA uartTxBufferMainLoopIndex;  // Index of next byte main loop will write (head).
+static volatile uint8 DATA uartTxBufferInterruptIndex; // Index of next byte interrupt will read (tail).
+RING_SIZE_CHECK(uartTxBuffer, UART_TX_BUFFER_SIZE)
 
-#define UART_TX_BUFFER_FREE_BYTES() ((uartTxBufferInterruptIndex - uartTxBufferMainLoopIndex - 1) & (sizeof(uartTxBuffer) - 1))
+#define UART_TX_BUFFER_FREE_BYTES() RING_FREE(uartTxBufferMainLoopIndex, uartTxBufferInterruptIndex, UART_TX_BUFFER_SIZE)
 
-static volatile uint8 XDATA uartRxBuffer[256];     // sizeof(uartRxBuffer) must be a power of two
-static volatile uint8 DATA uartRxBufferMainLoopIndex;  // Index of next byte main loop will read.
-static volatile uint8 DATA uartRxBufferInterruptIndex; // Index of next byte interrupt will write.
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 256
+#endif
+static volatile uint8 XDATA uartRxBuffer[UART_RX_BUFFER_SIZE];
+static volatile uint8 DATA uartRxBufferMainLoopIndex;  // Index of next byte main loop will read (tail).
+static volatile uint8 DATA uartRxBufferInterruptIndex; // Index of next byte interrupt will write (head).
+RING_SIZE_CHECK(uartRxBuffer, UART_RX_BUFFER_SIZE)
 
-#define UART_RX_BUFFER_FREE_BYTES() ((uartRxBufferMainLoopIndex - uartRxBufferInterruptIndex - 1) & (sizeof(uartRxBuffer) - 1))
-#define UART_RX_BUFFER_USED_BYTES() ((uartRxBufferInterruptIndex - uartRxBufferMainLoopIndex) & (sizeof(uartRxBuffer) - 1))
+#define UART_RX_BUFFER_FREE_BYTES() RING_FREE(uartRxBufferInterruptIndex, uartRxBufferMainLoopIndex, UART_RX_BUFFER_SIZE)
+#define UART_RX_BUFFER_USED_BYTES() RING_USED(uartRxBufferInterruptIndex, uartRxBufferMainLoopIndex, UART_RX_BUFFER_SIZE)
 
 volatile BIT uartNRxParityErrorOccurred;
 volatile BIT uartNRxFramingErrorOccurred;
@@ -213,15 +224,32 @@ uint8 uartNTxAvailable(void)
 void uartNTxSend(const uint8 XDATA * buffer, uint8 size)
 {
     // Assumption: uartNTxAvailable() was recently called and it returned a number at least as big as 'size'.
-    // TODO: after DMA memcpy is implemented, use it to make this function faster
 
+    // Copy the data in at most two contiguous spans, so we only update the
+    // index (which the ISR reads) once per span.
     while (size)
     {
-        uartTxBuffer[uartTxBufferMainLoopIndex] = *buffer;
+        uint8 XDATA * dest = (uint8 XDATA *)&uartTxBuffer[uartTxBufferMainLoopIndex];
+        uint8 span = RING_FREE_SPAN(uartTxBufferMainLoopIndex, uartTxBufferInterruptIndex, UART_TX_BUFFER_SIZE);
+        uint8 count;
+
+        if (span == 0)
+        {
+            // The assumption above was violated, so drop the rest of the data.
+            break;
+        }
+        if (span > size)
+        {
+            span = size;
+        }
+
+        for (count = span; count; count--)
+        {
+            *(dest++) = *(buffer++);
+        }
 
-        buffer++;
-        uartTxBufferMainLoopIndex = (uartTxBufferMainLoopIndex + 1) & (sizeof(uartTxBuffer) - 1);
-        size--;
+        RING_ADVANCE(uartTxBufferMainLoopIndex, span, UART_TX_BUFFER_SIZE);
+        size -= span;
 
         IEN2 |= BV_UTXNIE; // Enable TX interrupt
     }
@@ -232,7 +260,7 @@ void uartNTxSendByte(uint8 byte)
     // Assumption: uartNTxAvailable() was recently called and it returned a non-zero number.
 
     uartTxBuffer[uartTxBufferMainLoopIndex] = byte;
-    uartTxBufferMainLoopIndex = (uartTxBufferMainLoopIndex + 1) & (sizeof(uartTxBuffer) - 1);
+    uartTxBufferMainLoopIndex = RING_NEXT(uartTxBufferMainLoopIndex, UART_TX_BUFFER_SIZE);
 
     IEN2 |= BV_UTXNIE; // Enable TX interrupt
 }
@@ -247,7 +275,7 @@ uint8 uartNRxReceiveByte(void)
     // Assumption: uartNRxAvailable was recently called and it returned a non-zero value.
 
     uint8 byte = uartRxBuffer[uartRxBufferMainLoopIndex];
-    uartRxBufferMainLoopIndex = (uartRxBufferMainLoopIndex + 1) & (sizeof(uartRxBuffer) - 1);
+    uartRxBufferMainLoopIndex = RING_NEXT(uartRxBufferMainLoopIndex, UART_RX_BUFFER_SIZE);
     return byte;
 }
 
@@ -256,7 +284,7 @@ ISR_UTX()
     // A byte has just started transmitting on TX and there is room in
     // the UART's hardware buffer for us to add another byte.
 
-    if (uartTxBufferInterruptIndex != uartTxBufferMainLoopIndex)
+    if (!RING_IS_EMPTY(uartTxBufferMainLoopIndex, uartTxBufferInterruptIndex))
     {
         // There more bytes available in our software buffer, so send
         // the next byte.
@@ -264,7 +292,7 @@ ISR_UTX()
         UTXNIF = 0;
 
         UNDBUF = uartTxBuffer[uartTxBufferInterruptIndex];
-        uartTxBufferInterruptIndex = (uartTxBufferInterruptIndex + 1) & (sizeof(uartTxBuffer) - 1);
+        uartTxBufferInterruptIndex = RING_NEXT(uartTxBufferInterruptIndex, UART_TX_BUFFER_SIZE);
     }
     else
     {
@@ -293,7 +321,7 @@ ISR_URX()
         {
             // The software RX buffer has space, so add this new byte to the buffer.
             uartRxBuffer[uartRxBufferInterruptIndex] = UNDBUF;
-            uartRxBufferInterruptIndex = (uartRxBufferInterruptIndex + 1) & (sizeof(uartRxBuffer) - 1);
+            uartRxBufferInterruptIndex = RING_NEXT(uartRxBufferInterruptIndex, UART_RX_BUFFER_SIZE);
         }
         else
         {
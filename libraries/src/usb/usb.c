@@ -23,13 +23,107 @@ XDATA uint8 * controlTransferPointer;
 
 volatile BIT usbSuspendMode = 0;
 
-// TODO: eventually: Enable the USB interrupt and only set usbActivityFlag in the ISR
 volatile BIT usbActivityFlag = 0;
 
+uint8 XDATA usbOutInterruptMask = 0;
+static UsbOutInterruptHandler * XDATA usbOutInterruptHandler = 0;
+
+BIT usbInterruptMode = 0;
+
+UsbSetInterfaceHandler * usbSetInterfaceHandler = 0;
+uint8 XDATA usbAlternateSetting[USB_MAX_INTERFACES];
+
+// Reading USBCIF and USBIIF clears them, so when the USB ISR is only enabled
+// for OUT endpoints it saves the flags it reads here for usbPoll() to process.
+static volatile uint8 DATA usbPendingCif = 0;
+static volatile uint8 DATA usbPendingIif = 0;
+
+static void usbHandleEvents(uint8 usbcif, uint8 usbiif);
+
+ISR(USB, 0)
+{
+    uint8 savedIndex = USBINDEX;
+    uint8 usbcif, usbiif, usboif;
+
+    usbcif = USBCIF;
+    usbiif = USBIIF;
+    usboif = USBOIF;
+
+    // Clear the CPU interrupt flag after clearing the USB module's flags.
+    USBIF = 0;
+
+    if (usbInterruptMode)
+    {
+        usbHandleEvents(usbcif, usbiif);
+    }
+    else
+    {
+        usbPendingCif |= usbcif;
+        usbPendingIif |= usbiif;
+    }
+
+    if (usboif && usbOutInterruptHandler)
+    {
+        usbOutInterruptHandler(usboif);
+    }
+
+    USBINDEX = savedIndex;
+}
+
+void usbEnableOutInterrupt(uint8 endpointMask, UsbOutInterruptHandler * handler)
+{
+    USB_INTERRUPT_DISABLE();
+    usbOutInterruptHandler = handler;
+    usbOutInterruptMask = endpointMask;
+    if (usbDeviceState != USB_STATE_DETACHED)
+    {
+        USBOIE = endpointMask;
+    }
+    USBIF = 0;
+    USB_INTERRUPT_RESTORE();
+}
+
 void usbInit()
 {
 }
 
+void usbEnableInterrupt()
+{
+    USB_INTERRUPT_DISABLE();
+    if (!usbInterruptMode && usbDeviceState != USB_STATE_DETACHED)
+    {
+        // Handle the events that usbPoll() has not handled yet.
+        usbHandleEvents(USBCIF | usbPendingCif, USBIIF | usbPendingIif);
+        usbPendingCif = 0;
+        usbPendingIif = 0;
+    }
+    usbInterruptMode = 1;
+    USBIF = 0;
+    USB_INTERRUPT_RESTORE();
+}
+
+// These copies of usbReadFifo() and usbWriteFifo() are only used for
+// endpoint 0.  In interrupt mode they run in the USB ISR, and SDCC functions
+// are not reentrant, so the ISR must not use the functions that the main loop
+// uses for the other endpoints.
+static void usbEp0ReadFifo(uint8 count, uint8 XDATA * buffer)
+{
+    while(count > 0)
+    {
+        count--;
+        *(buffer++) = USBF0;
+    }
+}
+
+static void usbEp0WriteFifo(uint8 count, const uint8 XDATA * buffer)
+{
+    while(count > 0)
+    {
+        count--;
+        USBF0 = *(buffer++);
+    }
+}
+
 // TODO: try using DMA in usbReadFifo and usbWriteFifo and see how that affects the speed of usbComTxSend(x, 128).
 void usbReadFifo(uint8 endpointNumber, uint8 count, uint8 XDATA * buffer)
 {
@@ -56,11 +150,21 @@ void usbWriteFifo(uint8 endpointNumber, uint8 count, const uint8 XDATA * buffer)
     // actually sent.
 }
 
+static void usbResetAlternateSettings()
+{
+    uint8 i;
+    for (i = 0; i < USB_MAX_INTERFACES; i++)
+    {
+        usbAlternateSetting[i] = 0;
+    }
+}
+
 // Performs some basic tasks that should be done after USB is connected and after every
 // Reset interrupt.
 static void basicUsbInit()
 {
     usbSuspendMode = 0;
+    usbResetAlternateSettings();
 
     // Enable suspend detection and disable any other weird features.
     USBPOW = 1;
@@ -68,29 +172,38 @@ static void basicUsbInit()
     // Enable the USB common interrupts we care about: Reset, Resume, Suspend.
     // Without this, we USBCIF.SUSPENDIF will not get set (the datasheet is incomplete).
     USBCIE = 0b0111;
+
+    // Of the IN endpoint interrupts, we only need the one for endpoint 0.
+    // The others would just make the USB ISR run after every IN packet.
+    USBIIE = 1;
+
+    // Enable the OUT endpoint interrupts requested with usbEnableOutInterrupt().
+    USBOIE = usbOutInterruptMask;
 }
 
 void usbPoll()
 {
     uint8 usbcif;
     uint8 usbiif;
-    //uint8 usboif = USBOIF;
 
     if (!usbPowerPresent())
     {
         // The VBUS line is low.  This usually means that the USB cable has been
         // disconnected or the computer has been turned off.
 
+        USB_INTERRUPT_DISABLE();
         SLEEP &= ~(1<<7); // Disable the USB module (SLEEP.USB_EN = 0).
 
         disableUsbPullup();
         usbDeviceState = USB_STATE_DETACHED;
         usbSuspendMode = 0;
+        USB_INTERRUPT_RESTORE();
         return;
     }
 
     if (usbDeviceState == USB_STATE_DETACHED)
     {
+        USB_INTERRUPT_DISABLE();
         enableUsbPullup();
         SLEEP |= (1<<7);            // Enable the USB module (SLEEP.USB_EN = 1).
         __asm nop __endasm;         // Datasheet doesn't say so, but David suspects we need some NOPs here before writing to USB registers.
@@ -100,11 +213,30 @@ void usbPoll()
         usbDeviceState = USB_STATE_POWERED;
 
         basicUsbInit();
+        USB_INTERRUPT_RESTORE();
     }
 
-    usbcif = USBCIF;
-    usbiif = USBIIF;
+    if (usbInterruptMode)
+    {
+        // The USB ISR handles all the other events.
+        return;
+    }
+
+    // Combine the flags with the ones that the USB ISR already read.
+    USB_INTERRUPT_DISABLE();
+    usbcif = USBCIF | usbPendingCif;
+    usbiif = USBIIF | usbPendingIif;
+    usbPendingCif = 0;
+    usbPendingIif = 0;
+    USB_INTERRUPT_RESTORE();
 
+    usbHandleEvents(usbcif, usbiif);
+}
+
+// Handles the USB common interrupt flags (USBCIF) and endpoint 0.
+// This is called from usbPoll(), or from the USB ISR in interrupt mode.
+static void usbHandleEvents(uint8 usbcif, uint8 usbiif)
+{
     if (usbcif & (1<<0)) // Check SUSPENDIF
     {
         // The bus has been idle for 3 ms, so we are now in Suspend mode.
@@ -163,7 +295,7 @@ void usbPoll()
                 {
                     bytesReceived = controlTransferBytesLeft;
                 }
-                usbReadFifo(0, bytesReceived, controlTransferPointer);
+                usbEp0ReadFifo(bytesReceived, controlTransferPointer);
                 controlTransferPointer += bytesReceived;
                 controlTransferBytesLeft -= bytesReceived;
 
@@ -201,7 +333,7 @@ void usbPoll()
                 // A SETUP packet has been received from the computer, starting a new
                 // control transfer.
 
-                usbReadFifo(0, 8, (uint8 XDATA *)&usbSetupPacket); // Store the data in usbSetupPacket.
+                usbEp0ReadFifo(8, (uint8 XDATA *)&usbSetupPacket); // Store the data in usbSetupPacket.
 
                 // Wipe out the information about the last control transfer.
                 controlTransferState = CONTROL_TRANSFER_STATE_NONE;
@@ -273,7 +405,7 @@ void usbPoll()
             }
 
             // Arm endpoint 0 to send the next packet.
-            usbWriteFifo(0, bytesToSend, controlTransferPointer);
+            usbEp0WriteFifo(bytesToSend, controlTransferPointer);
             USBCS0 = usbcs0;
 
             // Update the control transfer state.
@@ -406,6 +538,7 @@ static void usbStandardDeviceRequestHandler()
                     // state of a USB device.  We can now start using non-zero
                     // endpoints.
                     usbDeviceState = USB_STATE_CONFIGURED;
+                    usbResetAlternateSettings();
                     usbCallbackInitEndpoints();
                     break;
                 }
@@ -429,8 +562,6 @@ static void usbStandardDeviceRequestHandler()
         }
         case USB_REQUEST_GET_INTERFACE: // USB Spec 9.4.4 Get Interface
         {
-            // Assumption: the "alternate setting number" of each interface
-            //   is zero and there are no alternate settings.
             // Assumption: interface numbers go from 0 to
             //   config->interface_count-1, with no gaps.
 
@@ -446,11 +577,46 @@ static void usbStandardDeviceRequestHandler()
                 return;
             }
 
-            // Send a single-byte response of "0".
-            // Assumption: response[0] == 0
+            if (usbSetupPacket.wIndex < USB_MAX_INTERFACES)
+            {
+                response[0] = usbAlternateSetting[usbSetupPacket.wIndex];
+            }
             usbControlRead(1, response);
             return;
         }
+        case USB_REQUEST_SET_INTERFACE: // USB Spec 9.4.10 Set Interface
+        {
+            if (usbDeviceState < USB_STATE_CONFIGURED)
+            {
+                // Invalid request because we have not reached the configured state.
+                return;
+            }
+
+            if (usbSetupPacket.wIndex >= ((USB_DESCRIPTOR_CONFIGURATION *)&usbConfigurationDescriptor)->bNumInterfaces ||
+                usbSetupPacket.wIndex >= USB_MAX_INTERFACES)
+            {
+                // Invalid index: there is no such interface.
+                return;
+            }
+
+            if (usbSetInterfaceHandler)
+            {
+                if (!usbSetInterfaceHandler())
+                {
+                    // The higher-level code does not have that alternate setting.
+                    return;
+                }
+            }
+            else if (usbSetupPacket.wValue != 0)
+            {
+                // Without a handler, there are no alternate settings besides 0.
+                return;
+            }
+
+            usbAlternateSetting[usbSetupPacket.wIndex] = (uint8)usbSetupPacket.wValue;
+            usbControlAcknowledge();
+            return;
+        }
         case USB_REQUEST_GET_STATUS: // USB Spec 9.4.5 Get Status
         {
             switch(usbSetupPacket.recipient)
@@ -630,6 +796,27 @@ void usbControlStall()
     controlTransferState = CONTROL_TRANSFER_STATE_NONE;
 }
 
+uint8 CODE * usbFindClassDescriptor(uint8 interfaceNumber, uint8 descriptorType)
+{
+    uint8 CODE * descriptor = usbConfigurationDescriptor;
+    uint8 CODE * end = descriptor + *(uint16 *)&usbConfigurationDescriptor[2];
+    BIT inInterface = 0;
+
+    while (descriptor < end && descriptor[0] != 0)
+    {
+        if (descriptor[1] == USB_DESCRIPTOR_TYPE_INTERFACE)
+        {
+            inInterface = (descriptor[2] == interfaceNumber);
+        }
+        else if (inInterface && descriptor[1] == descriptorType)
+        {
+            return descriptor;
+        }
+        descriptor += descriptor[0];
+    }
+    return 0;
+}
+
 void usbInitEndpointIn(uint8 endpointNumber, uint8 maxPacketSize)
 {
     USBINDEX = endpointNumber;
@@ -637,6 +824,13 @@ void usbInitEndpointIn(uint8 endpointNumber, uint8 maxPacketSize)
     USBCSIH = 1;                    // Enable Double buffering
 }
 
+void usbInitEndpointIsoIn(uint8 endpointNumber, uint16 maxPacketSize)
+{
+    USBINDEX = endpointNumber;
+    USBMAXI = (maxPacketSize + 7) >> 3;
+    USBCSIH = USBCSIH_ISO | USBCSIH_IN_DBL_BUF;
+}
+
 void usbInitEndpointOut(uint8 endpointNumber, uint8 maxPacketSize)
 {
     USBINDEX = endpointNumber;
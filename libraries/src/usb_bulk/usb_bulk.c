@@ -0,0 +1,300 @@
+/* usb_bulk.c: A USB device with one vendor-specific interface that has a
+ * pair of bulk endpoints.  See usb_bulk.h for the public interface.
+ */
+
+#include <cc2511_map.h>
+#include <cc2511_types.h>
+#include <usb.h>
+#include <usb_bulk.h>
+#include <dma.h>
+#include <board.h>           // just for boardStartBootloader() and serialNumberString
+#include <time.h>            // just for timing the start of the bootloader
+
+/* Bulk Library Configuration *************************************************/
+// We picked endpoint 4 for the data because it has a 256-byte FIFO memory area,
+// which is exactly enough for us to have two 64-byte IN buffers and two 64-byte
+// OUT buffers.  Endpoint 5 would not help because full-speed bulk packets can
+// not be larger than 64 bytes.
+
+#define BULK_INTERFACE_NUMBER  0
+
+#define BULK_DATA_ENDPOINT     4
+#define BULK_DATA_FIFO         USBF4   // This must match BULK_DATA_ENDPOINT!
+
+#define VENDOR_SPECIFIC_CLASS  0xFF
+
+/* Bulk Variables *************************************************************/
+
+// True iff we have received a command from the user to enter bootloader mode.
+// It is set by the setup handler, which might run in the USB interrupt, so
+// usbBulkService() records the time of the request.
+static BIT startBootloaderRequested = 0;
+
+// True iff startBootloaderRequestTime is valid.
+static BIT startBootloaderSoon = 0;
+
+// The lower 8-bits of the time (in ms) when the request to enter bootloader mode
+// was received.  This variable is only valid when startBootloaderSoon == 1.
+static uint8 XDATA startBootloaderRequestTime;
+
+/* Bulk USB Descriptors *******************************************************/
+
+USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
+{
+    sizeof(USB_DESCRIPTOR_DEVICE),
+    USB_DESCRIPTOR_TYPE_DEVICE,
+    0x0200,                 // USB Spec Release Number in BCD format
+    0,                      // Class Code: defined by the interface
+    0,                      // Subclass code
+    0,                      // Protocol code
+    USB_EP0_PACKET_SIZE,    // Max packet size for Endpoint 0
+    USB_VENDOR_ID_POLOLU,   // Vendor ID
+    0x2202,                 // Product ID (Generic Wixel with one vendor-specific bulk interface)
+    0x0000,                 // Device release number in BCD format
+    1,                      // Index of Manufacturer String Descriptor
+    2,                      // Index of Product String Descriptor
+    3,                      // Index of Serial Number String Descriptor
+    1                       // Number of possible configurations.
+};
+
+CODE struct CONFIG1 {
+    USB_DESCRIPTOR_CONFIGURATION configuration;
+    USB_DESCRIPTOR_INTERFACE data_interface;
+    USB_DESCRIPTOR_ENDPOINT data_out;
+    USB_DESCRIPTOR_ENDPOINT data_in;
+} usbConfigurationDescriptor
+=
+{
+    {                                                    // Configuration Descriptor
+        sizeof(USB_DESCRIPTOR_CONFIGURATION),
+        USB_DESCRIPTOR_TYPE_CONFIGURATION,
+        sizeof(struct CONFIG1),                          // wTotalLength
+        1,                                               // bNumInterfaces
+        1,                                               // bConfigurationValue
+        0,                                               // iConfiguration
+        0xC0,                                            // bmAttributes: self powered (but may use bus power)
+        50,                                              // bMaxPower
+    },
+    {                                                    // Data Interface: used for RX and TX data.
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        BULK_INTERFACE_NUMBER,                           // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        2,                                               // bNumEndpoints
+        VENDOR_SPECIFIC_CLASS,                           // bInterfaceClass
+        0,                                               // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {                                                    // OUT Endpoint: Sends data out to Wixel.
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_OUT | BULK_DATA_ENDPOINT,   // bEndpointAddress
+        USB_TRANSFER_TYPE_BULK,                          // bmAttributes
+        USB_BULK_PACKET_SIZE,                            // wMaxPacketSize
+        0,                                               // bInterval
+    },
+    {                                                    // IN Endpoint: Sends data in to the computer.
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | BULK_DATA_ENDPOINT,    // bEndpointAddress
+        USB_TRANSFER_TYPE_BULK,                          // bmAttributes
+        USB_BULK_PACKET_SIZE,                            // wMaxPacketSize
+        0,                                               // bInterval
+    },
+};
+
+uint8 CODE usbStringDescriptorCount = 4;
+DEFINE_STRING_DESCRIPTOR(languages, 1, USB_LANGUAGE_EN_US)
+DEFINE_STRING_DESCRIPTOR(manufacturer, 18, 'P','o','l','o','l','u',' ','C','o','r','p','o','r','a','t','i','o','n')
+DEFINE_STRING_DESCRIPTOR(product, 5, 'W','i','x','e','l')
+uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product, serialNumberStringDescriptor };
+
+/* Bulk USB callbacks *********************************************************/
+// These functions are called by the low-level USB module (usb.c) when a USB
+// event happens that requires higher-level code to make a decision.
+
+void usbCallbackInitEndpoints()
+{
+    usbInitEndpointOut(BULK_DATA_ENDPOINT, USB_BULK_PACKET_SIZE);
+    usbInitEndpointIn(BULK_DATA_ENDPOINT, USB_BULK_PACKET_SIZE);
+}
+
+void usbCallbackSetupHandler()
+{
+    // Require Type==Vendor, Recipient==Device, and Direction==OUT.
+    if (usbSetupPacket.bmRequestType != 0x40)
+    {
+        return;
+    }
+
+    switch(usbSetupPacket.bRequest)
+    {
+        case USB_BULK_REQUEST_START_BOOTLOADER:
+            startBootloaderRequested = 1;
+            usbControlAcknowledge();
+            break;
+    }
+}
+
+void usbCallbackClassDescriptorHandler(void)
+{
+    // Not used by this library.
+}
+
+void usbCallbackControlWriteHandler()
+{
+    // Not used by this library.
+}
+
+/* Bulk FIFO Copying **********************************************************/
+
+// DMA configuration bytes for copying a block when DMAREQ is written:
+// WORDSIZE = 0 (8-bit), TMODE = 01 (Block), TRIG = 0 (Manual).
+#define BULK_DMA_DC6           0b00100000
+
+// SRCINC = 1, DESTINC = 0, IRQMASK = 0, M8 = 0, PRIORITY = 0 (Low).
+#define BULK_DMA_DC7_TO_FIFO   0b01000000
+
+// SRCINC = 0, DESTINC = 1, IRQMASK = 0, M8 = 0, PRIORITY = 0 (Low).
+#define BULK_DMA_DC7_FROM_FIFO 0b00010000
+
+// Copies a block of bytes with the USB DMA channel and waits for it to finish.
+// Assumption: count is not zero.
+static void usbBulkDmaCopy(uint16 source, uint16 destination, uint8 count, uint8 dc7)
+{
+    dmaConfig.usb.SRCADDRH = source >> 8;
+    dmaConfig.usb.SRCADDRL = source;
+    dmaConfig.usb.DESTADDRH = destination >> 8;
+    dmaConfig.usb.DESTADDRL = destination;
+    dmaConfig.usb.VLEN_LENH = 0;       // Transfer a fixed number of bytes.
+    dmaConfig.usb.LENL = count;
+    dmaConfig.usb.DC6 = BULK_DMA_DC6;
+    dmaConfig.usb.DC7 = dc7;
+
+    DMAARM |= (1<<DMA_CHANNEL_USB);    // Arm DMA channel.
+
+    // The channel needs a few clock cycles to load its configuration before it
+    // can be triggered.
+    __asm nop __endasm; __asm nop __endasm; __asm nop __endasm;
+    __asm nop __endasm; __asm nop __endasm; __asm nop __endasm;
+    __asm nop __endasm; __asm nop __endasm; __asm nop __endasm;
+
+    DMAREQ |= (1<<DMA_CHANNEL_USB);    // Start the transfer.
+
+    // The channel is disarmed automatically when the transfer is done.
+    while(DMAARM & (1<<DMA_CHANNEL_USB)){};
+}
+
+/* Bulk RX Functions **********************************************************/
+
+uint8 usbBulkRxAvailable()
+{
+    if (usbDeviceState != USB_STATE_CONFIGURED)
+    {
+        // We have not reached the Configured state yet, so we should not be touching the non-zero endpoints.
+        return 0;
+    }
+
+    USBINDEX = BULK_DATA_ENDPOINT;
+    while (USBCSOL & USBCSOL_OUTPKT_RDY)   // Check the OUTPKT_RDY flag because USBCNTL is only valid when it is 1.
+    {
+        // Assumption: We don't need to read USBCNTH because we can't receive packets
+        // larger than 255 bytes.
+        if (USBCNTL)
+        {
+            return USBCNTL;
+        }
+
+        // Discard the zero-length packet.  If the other OUT buffer holds a
+        // packet, OUTPKT_RDY will be set again right away.
+        USBCSOL &= ~USBCSOL_OUTPKT_RDY;
+    }
+    return 0;
+}
+
+uint8 usbBulkRxReceive(uint8 XDATA * buffer)
+{
+    uint8 count = usbBulkRxAvailable();
+
+    if (count)
+    {
+        usbBulkDmaCopy((uint16)&BULK_DATA_FIFO, (uint16)buffer, count, BULK_DMA_DC7_FROM_FIFO);
+
+        USBINDEX = BULK_DATA_ENDPOINT;
+        USBCSOL &= ~USBCSOL_OUTPKT_RDY;    // Tell the USB module we are done reading this packet, so it can receive more.
+        usbActivityFlag = 1;
+    }
+    return count;
+}
+
+/* Bulk TX Functions **********************************************************/
+
+// Assumption: We are using double buffering, so we can load either 0, 1, or 2
+// packets into the FIFO at this time.
+uint8 usbBulkTxAvailable()
+{
+    uint8 tmp;
+
+    if (usbDeviceState != USB_STATE_CONFIGURED)
+    {
+        // We have not reached the Configured state yet, so we should not be touching the non-zero endpoints.
+        return 0;
+    }
+
+    USBINDEX = BULK_DATA_ENDPOINT;
+    tmp = USBCSIL;
+    if (tmp & USBCSIL_PKT_PRESENT)
+    {
+        if (tmp & USBCSIL_INPKT_RDY)
+        {
+            return 0;                         // 2 packets are in the FIFO, so no room
+        }
+        return USB_BULK_PACKET_SIZE;          // 1 packet is in the FIFO, so there is room for 1 more
+    }
+    else
+    {
+        return USB_BULK_PACKET_SIZE << 1;     // 0 packets are in the FIFO, so there is room for 2 more
+    }
+}
+
+void usbBulkTxSend(const uint8 XDATA * buffer, uint8 size)
+{
+    uint8 packetSize;
+
+    do
+    {
+        packetSize = size > USB_BULK_PACKET_SIZE ? USB_BULK_PACKET_SIZE : size;
+
+        if (packetSize)
+        {
+            usbBulkDmaCopy((uint16)buffer, (uint16)&BULK_DATA_FIFO, packetSize, BULK_DMA_DC7_TO_FIFO);
+            buffer += packetSize;
+            size -= packetSize;
+        }
+
+        USBINDEX = BULK_DATA_ENDPOINT;
+        USBCSIL |= USBCSIL_INPKT_RDY;         // Send the packet.
+    } while(size);
+
+    // Notify the USB library that some activity has occurred.
+    usbActivityFlag = 1;
+}
+
+void usbBulkService()
+{
+    usbPoll();
+
+    if (startBootloaderRequested && !startBootloaderSoon)
+    {
+        startBootloaderSoon = 1;
+        startBootloaderRequestTime = (uint8)getMs();
+    }
+
+    // Start the bootloader if necessary.  We wait a while after the request so
+    // that the status phase of the control transfer can finish.
+    if (startBootloaderSoon && (uint8)(getMs() - startBootloaderRequestTime) > 70)
+    {
+        boardStartBootloader();
+    }
+}
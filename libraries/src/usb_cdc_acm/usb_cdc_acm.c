@@ -15,17 +15,29 @@
 // We picked endpoint 4 for the data because it has a 256-byte FIFO memory area,
 // which is exactly enough for us to have two 64-byte IN buffers and two 64-byte
 // OUT buffers.
+// The interface and endpoint numbers can be changed with preprocessor flags
+// when this file is compiled as part of a composite device (see usb_composite.h).
 
 #define CDC_OUT_PACKET_SIZE          64
 #define CDC_IN_PACKET_SIZE           64
+
+#ifndef CDC_CONTROL_INTERFACE_NUMBER
 #define CDC_CONTROL_INTERFACE_NUMBER 0
+#endif
+
+#ifndef CDC_DATA_INTERFACE_NUMBER
 #define CDC_DATA_INTERFACE_NUMBER    1
+#endif
 
+#ifndef CDC_NOTIFICATION_ENDPOINT
 #define CDC_NOTIFICATION_ENDPOINT    1
-#define CDC_NOTIFICATION_FIFO        USBF1   // This must match CDC_NOTIFICATION_ENDPOINT!
+#endif
+#define CDC_NOTIFICATION_FIFO        USB_FIFO(CDC_NOTIFICATION_ENDPOINT)
 
+#ifndef CDC_DATA_ENDPOINT
 #define CDC_DATA_ENDPOINT            4
-#define CDC_DATA_FIFO                USBF4   // This must match CDC_DATA_ENDPOINT!
+#endif
+#define CDC_DATA_FIFO                USB_FIFO(CDC_DATA_ENDPOINT)
 
 /* CDC and ACM Constants ******************************************************/
 
@@ -64,6 +76,7 @@
 
 /* Private Prototypes *********************************************************/
 static void doNothing();
+static void usbComTxRingToFifo();
 
 /* USB COM Variables **********************************************************/
 
@@ -86,6 +99,11 @@ ACM_LINE_CODING XDATA usbComLineCoding =
 
 HandlerFunction * usbComLineCodingChangeHandler = doNothing;
 
+// True if the host has set the line coding and usbComService() has not
+// called usbComLineCodingChangeHandler yet.  The handler is not called from
+// the control write handler because that might run in the USB interrupt.
+static BIT lineCodingChanged = 0;
+
 // This bit is true if we need to send an empty (zero-length) packet of data to
 // the computer soon.  Every data transfer needs to be ended with a packet that
 // is less than full length, so sometimes we need to send empty packets.
@@ -105,6 +123,11 @@ static BIT startBootloaderSoon = 0;
 static uint8 XDATA startBootloaderRequestTime;
 
 /* CDC ACM USB Descriptors ****************************************************/
+// When this file is compiled as part of a composite device (USB_COMPOSITE is
+// defined), the composite library provides the descriptors and the USB callbacks.
+
+#ifndef USB_COMPOSITE
+
 
 USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
 {
@@ -232,6 +255,30 @@ uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product,
 // event happens that requires higher-level code to make a decision.
 
 void usbCallbackInitEndpoints()
+{
+    usbComInitEndpoints();
+}
+
+void usbCallbackSetupHandler()
+{
+    usbComSetupHandler();
+}
+
+void usbCallbackClassDescriptorHandler(void)
+{
+    // Not used by CDC ACM
+}
+
+void usbCallbackControlWriteHandler()
+{
+    usbComControlWriteHandler();
+}
+
+#endif
+
+/* CDC ACM request handlers ***************************************************/
+
+void usbComInitEndpoints()
 {
     usbInitEndpointIn(CDC_NOTIFICATION_ENDPOINT, 10);
     usbInitEndpointOut(CDC_DATA_ENDPOINT, CDC_OUT_PACKET_SIZE);
@@ -243,7 +290,7 @@ void usbCallbackInitEndpoints()
 
 // Implements all the control transfers that are required by D1 of the
 // ACM descriptor bmCapabilities, (USBPSTN1.20 Table 4).
-void usbCallbackSetupHandler()
+void usbComSetupHandler()
 {
     if ((usbSetupPacket.bmRequestType & 0x7F) != 0x21)   // Require Type==Class and Recipient==Interface.
         return;
@@ -268,30 +315,172 @@ void usbCallbackSetupHandler()
     }
 }
 
-void usbCallbackClassDescriptorHandler(void)
+static void doNothing(void)
 {
-    // Not used by CDC ACM
+    // Do nothing.
 }
 
-static void doNothing(void)
+void usbComControlWriteHandler()
 {
-    // Do nothing.
+    lineCodingChanged = 1;
 }
 
-void usbCallbackControlWriteHandler()
+/* CDC ACM RX Ring Buffer ****************************************************/
+// If the user calls usbComRxBufferInit(), the USB ISR copies each packet from the
+// OUT FIFO into this ring buffer as soon as it arrives, so the host can keep
+// sending even when the main loop is busy.
+// The ISR adds bytes at usbComRxRingHead and the main loop removes them at
+// usbComRxRingTail.  usbComRxRingCount is shared, so the main loop disables the
+// USB interrupt while it updates it.
+
+static uint8 XDATA * XDATA usbComRxRing = 0;
+static uint16 XDATA usbComRxRingSize;
+static uint16 XDATA usbComRxRingHead;
+static uint16 XDATA usbComRxRingTail;
+static volatile uint16 XDATA usbComRxRingCount;
+static uint16 XDATA usbComRxLowWatermark;
+static uint16 XDATA usbComRxHighWatermark;
+
+// True if the ISR stopped accepting packets because the buffer reached the
+// high watermark.  Packets stay in the OUT FIFO (and the host gets NAKs)
+// until the main loop reads the buffer down to the low watermark.
+static volatile BIT usbComRxStopped = 0;
+
+// Copies packets from the OUT FIFO to the ring buffer while there is room.
+// This is called from the USB ISR, or from the main loop with the USB
+// interrupt disabled.
+static void usbComRxRingFill()
 {
-    usbComLineCodingChangeHandler();
+    uint8 count;
 
-    if (usbComLineCoding.dwDTERate == 333 && !startBootloaderSoon)
+    USBINDEX = CDC_DATA_ENDPOINT;
+    while (!usbComRxStopped && (USBCSOL & USBCSOL_OUTPKT_RDY))
     {
-        // The baud rate has been set to 333.  That is the special signal
-        // sent by the USB host telling us to enter bootloader mode.
+        count = USBCNTL;
+        if (usbComRxRingCount + count > usbComRxHighWatermark)
+        {
+            usbComRxStopped = 1;
+            return;
+        }
+
+        usbComRxRingCount += count;
+        while (count--)
+        {
+            usbComRxRing[usbComRxRingHead] = CDC_DATA_FIFO;
+            if (++usbComRxRingHead == usbComRxRingSize)
+            {
+                usbComRxRingHead = 0;
+            }
+        }
 
-        startBootloaderSoon = 1;
-        startBootloaderRequestTime = (uint8)getMs();
+        USBCSOL &= ~USBCSOL_OUTPKT_RDY;   // Tell the USB module we are done reading this packet, so it can receive more.
+        usbActivityFlag = 1;
     }
 }
 
+static void usbComRxInterrupt(uint8 endpointFlags)
+{
+    if (endpointFlags & (1<<CDC_DATA_ENDPOINT))
+    {
+        usbComRxRingFill();
+    }
+}
+
+void usbComRxBufferInit(uint8 XDATA * buffer, uint16 size)
+{
+    USB_INTERRUPT_DISABLE();
+    usbComRxRing = buffer;
+    usbComRxRingSize = size;
+    usbComRxRingHead = usbComRxRingTail = usbComRxRingCount = 0;
+    usbComRxStopped = 0;
+    usbComRxHighWatermark = size;
+    usbComRxLowWatermark = size - CDC_OUT_PACKET_SIZE;
+    usbEnableOutInterrupt(1<<CDC_DATA_ENDPOINT, usbComRxInterrupt);  // Restores the USB interrupt.
+}
+
+void usbComRxSetWatermarks(uint16 low, uint16 high)
+{
+    // A high watermark below one packet would never let a full packet in.
+    if (high < CDC_OUT_PACKET_SIZE){ high = CDC_OUT_PACKET_SIZE; }
+    if (high > usbComRxRingSize){ high = usbComRxRingSize; }
+    if (low > high){ low = high; }
+
+    USB_INTERRUPT_DISABLE();
+    usbComRxLowWatermark = low;
+    usbComRxHighWatermark = high;
+    USB_INTERRUPT_RESTORE();
+}
+
+BIT usbComRxThrottled()
+{
+    return usbComRxStopped;
+}
+
+uint16 usbComRxBufferCount()
+{
+    uint16 count;
+
+    if (usbComRxRing == 0)
+    {
+        return usbComRxAvailable();
+    }
+
+    USB_INTERRUPT_DISABLE();
+    count = usbComRxRingCount;
+    USB_INTERRUPT_RESTORE();
+    return count;
+}
+
+// Removes bytes from the ring buffer and copies them to the buffer (if it is not 0).
+static void usbComRxRingRemove(uint8 XDATA * buffer, uint16 size)
+{
+    uint16 tail = usbComRxRingTail;
+    uint16 remaining = size;
+
+    while (remaining--)
+    {
+        if (buffer)
+        {
+            *(buffer++) = usbComRxRing[tail];
+        }
+        if (++tail == usbComRxRingSize)
+        {
+            tail = 0;
+        }
+    }
+    usbComRxRingTail = tail;
+
+    USB_INTERRUPT_DISABLE();
+    usbComRxRingCount -= size;
+    if (usbComRxStopped && usbComRxRingCount <= usbComRxLowWatermark)
+    {
+        // We have made enough room, so start accepting packets again.  The
+        // ISR will not run for the packets already waiting, so copy them now.
+        usbComRxStopped = 0;
+        usbComRxRingFill();
+    }
+    USB_INTERRUPT_RESTORE();
+}
+
+uint16 usbComRxRead(uint8 XDATA * buffer, uint16 maxSize)
+{
+    uint16 count = usbComRxBufferCount();
+    if (count > maxSize)
+    {
+        count = maxSize;
+    }
+
+    if (usbComRxRing == 0)
+    {
+        usbComRxReceive(buffer, count);
+    }
+    else if (count)
+    {
+        usbComRxRingRemove(buffer, count);
+    }
+    return count;
+}
+
 /* CDC ACM RX Functions *******************************************************/
 // These functions can be called by the higher-level user of the CDC ACM library
 // to receive bytes from the computer.
@@ -304,6 +493,12 @@ uint8 usbComRxAvailable()
         return 0;
     }
 
+    if (usbComRxRing)
+    {
+        uint16 count = usbComRxBufferCount();
+        return count > 255 ? 255 : count;
+    }
+
     USBINDEX = CDC_DATA_ENDPOINT;      // Select the data endpoint.
     if (USBCSOL & USBCSOL_OUTPKT_RDY)  // Check the OUTPKT_RDY flag because USBCNTL is only valid when it is 1.
     {
@@ -326,6 +521,13 @@ uint8 usbComRxReceiveByte()
 {
     uint8 tmp;
 
+    if (usbComRxRing)
+    {
+        tmp = usbComRxRing[usbComRxRingTail];
+        usbComRxRingRemove(0, 1);
+        return tmp;
+    }
+
     USBINDEX = CDC_DATA_ENDPOINT;         // Select the CDC data endpoint.
     tmp = CDC_DATA_FIFO;                  // Read one byte from the FIFO.
 
@@ -342,12 +544,20 @@ uint8 usbComRxReceiveByte()
 // was greater than or equal to size.
 void usbComRxReceive(uint8 XDATA* buffer, uint8 size)
 {
+    if (usbComRxRing)
+    {
+        usbComRxRingRemove(buffer, size);
+        return;
+    }
+
     usbReadFifo(CDC_DATA_ENDPOINT, size, buffer);
 
     if (USBCNTL == 0)
     {
         USBCSOL &= ~USBCSOL_OUTPKT_RDY;   // Tell the USB module we are done reading this packet, so it can receive more.
     }
+
+    usbActivityFlag = 1;
 }
 
 
@@ -355,6 +565,20 @@ void usbComRxReceive(uint8 XDATA* buffer, uint8 size)
 // These functions can be called by the higher-level user of the CDC ACM library
 // to send bytes to the computer.
 
+// The latency timer: a partial packet (or an empty packet after a full one)
+// is only sent after it has been waiting for usbComTxLatency milliseconds.
+static uint8 XDATA usbComTxLatency = 0;
+
+// The lower 8 bits of getMs() when the data in the IN FIFO started waiting.
+static uint8 XDATA usbComTxWaitStart;
+
+// The optional staging ring buffer.  It is only accessed from the main loop.
+static uint8 XDATA * XDATA usbComTxRing = 0;
+static uint16 XDATA usbComTxRingSize;
+static uint16 XDATA usbComTxRingHead;
+static uint16 XDATA usbComTxRingTail;
+static uint16 XDATA usbComTxRingCount;
+
 static void sendPacketNow()
 {
     USBINDEX = CDC_DATA_ENDPOINT;
@@ -362,6 +586,7 @@ static void sendPacketNow()
 
     // If the last packet transmitted was a full packet, we should send an empty packet later.
     sendEmptyPacketSoon = (inFifoBytesLoaded == CDC_IN_PACKET_SIZE);
+    usbComTxWaitStart = (uint8)getMs();
 
     // There are 0 bytes in the IN FIFO now.
     inFifoBytesLoaded = 0;
@@ -374,6 +599,21 @@ void usbComService(void)
 {
     usbPoll();
 
+    if (lineCodingChanged)
+    {
+        lineCodingChanged = 0;
+        usbComLineCodingChangeHandler();
+
+        if (usbComLineCoding.dwDTERate == 333 && !startBootloaderSoon)
+        {
+            // The baud rate has been set to 333.  That is the special signal
+            // sent by the USB host telling us to enter bootloader mode.
+
+            startBootloaderSoon = 1;
+            startBootloaderRequestTime = (uint8)getMs();
+        }
+    }
+
     // Start bootloader if necessary.
     if (startBootloaderSoon && (uint8)(getMs() - startBootloaderRequestTime) > 70)
     {
@@ -399,8 +639,16 @@ void usbComService(void)
     // Typical USB systems wait for a short or empty packet before forwarding the data
     // up to the software that requested it, so this is necessary.  However, we only transmit
     // an empty packet if there are no packets currently loaded in the FIFO.
+    //
+    // If the latency timer is enabled, we wait until the data has been waiting for long
+    // enough, so that bytes written one at a time get combined into fewer packets.
+    if (usbComTxRing)
+    {
+        usbComTxRingToFifo();
+    }
     USBINDEX = CDC_DATA_ENDPOINT;
-    if (inFifoBytesLoaded || ( sendEmptyPacketSoon && !(USBCSIL & USBCSIL_PKT_PRESENT) ) )
+    if ((inFifoBytesLoaded || ( sendEmptyPacketSoon && !(USBCSIL & USBCSIL_PKT_PRESENT) ) ) &&
+        (uint8)((uint8)getMs() - usbComTxWaitStart) >= usbComTxLatency)
     {
         sendPacketNow();
     }
@@ -446,16 +694,10 @@ void usbComService(void)
 
 // Assumption: We are using double buffering, so we can load either 0, 1, or 2
 // packets into the FIFO at this time.
-uint8 usbComTxAvailable()
+static uint8 usbComTxFifoAvailable()
 {
     uint8 tmp;
 
-    if (usbDeviceState != USB_STATE_CONFIGURED)
-    {
-        // We have not reached the Configured state yet, so we should not be touching the non-zero endpoints.
-        return 0;
-    }
-
     USBINDEX = CDC_DATA_ENDPOINT;
     tmp = USBCSIL;
     if (tmp & USBCSIL_PKT_PRESENT)
@@ -472,11 +714,17 @@ uint8 usbComTxAvailable()
     }
 }
 
-// Assumption: The user called usbComTxAvailable() before calling this function,
-// and it returned a number greater than or equal to size.
-void usbComTxSend(const uint8 XDATA * buffer, uint8 size)
+// Assumption: usbComTxFifoAvailable() recently returned a number greater than or
+// equal to size.
+static void usbComTxFifoWrite(const uint8 XDATA * buffer, uint8 size)
 {
     uint8 packetSize;
+
+    if (inFifoBytesLoaded == 0)
+    {
+        usbComTxWaitStart = (uint8)getMs();
+    }
+
     while(size)
     {
         packetSize = CDC_IN_PACKET_SIZE - inFifoBytesLoaded;   // Decide how many bytes to send in this packet (packetSize).
@@ -495,10 +743,150 @@ void usbComTxSend(const uint8 XDATA * buffer, uint8 size)
     }
 }
 
+// Moves as much data as possible from the staging ring buffer to the IN FIFO.
+static void usbComTxRingToFifo()
+{
+    uint16 size;
+    uint8 room;
+
+    while (usbComTxRingCount && (room = usbComTxFifoAvailable()))
+    {
+        // Move the bytes that are contiguous in the ring buffer.
+        size = usbComTxRingSize - usbComTxRingTail;
+        if (size > usbComTxRingCount){ size = usbComTxRingCount; }
+        if (size > room){ size = room; }
+
+        usbComTxFifoWrite(usbComTxRing + usbComTxRingTail, size);
+
+        usbComTxRingCount -= size;
+        usbComTxRingTail += size;
+        if (usbComTxRingTail == usbComTxRingSize)
+        {
+            usbComTxRingTail = 0;
+        }
+    }
+}
+
+// Adds bytes to the staging ring buffer.
+// Assumption: There is room for them.
+static void usbComTxRingWrite(const uint8 XDATA * buffer, uint16 size)
+{
+    if (usbComTxRingCount == 0 && inFifoBytesLoaded == 0)
+    {
+        usbComTxWaitStart = (uint8)getMs();
+    }
+
+    usbComTxRingCount += size;
+    while(size--)
+    {
+        usbComTxRing[usbComTxRingHead] = *(buffer++);
+        if (++usbComTxRingHead == usbComTxRingSize)
+        {
+            usbComTxRingHead = 0;
+        }
+    }
+
+    if (usbComTxRingCount >= CDC_IN_PACKET_SIZE)
+    {
+        // There is at least one full packet, so don't wait for usbComService().
+        usbComTxRingToFifo();
+    }
+}
+
+void usbComTxSetLatency(uint8 milliseconds)
+{
+    usbComTxLatency = milliseconds;
+}
+
+void usbComTxBufferInit(uint8 XDATA * buffer, uint16 size)
+{
+    usbComTxRing = buffer;
+    usbComTxRingSize = size;
+    usbComTxRingHead = usbComTxRingTail = usbComTxRingCount = 0;
+}
+
+uint16 usbComTxBufferSpace()
+{
+    if (usbDeviceState != USB_STATE_CONFIGURED)
+    {
+        // We have not reached the Configured state yet, so we should not be touching the non-zero endpoints.
+        return 0;
+    }
+
+    if (usbComTxRing)
+    {
+        return usbComTxRingSize - usbComTxRingCount;
+    }
+
+    return usbComTxFifoAvailable();
+}
+
+uint8 usbComTxAvailable()
+{
+    uint16 space = usbComTxBufferSpace();
+    return space > 255 ? 255 : space;
+}
+
+// Assumption: The user called usbComTxAvailable() before calling this function,
+// and it returned a number greater than or equal to size.
+void usbComTxSend(const uint8 XDATA * buffer, uint8 size)
+{
+    if (usbComTxRing)
+    {
+        usbComTxRingWrite(buffer, size);
+    }
+    else
+    {
+        usbComTxFifoWrite(buffer, size);
+    }
+}
+
+uint16 usbComTxWrite(const uint8 XDATA * buffer, uint16 size)
+{
+    uint16 space = usbComTxBufferSpace();
+    if (size > space){ size = space; }
+
+    if (usbComTxRing)
+    {
+        usbComTxRingWrite(buffer, size);
+    }
+    else if (size)
+    {
+        // Without a ring buffer, the space can not be more than 128 bytes.
+        usbComTxFifoWrite(buffer, size);
+    }
+    return size;
+}
+
 void usbComTxSendByte(uint8 byte)
 {
     // Assumption: usbComTxAvailable() recently returned a non-zero number
 
+    if (usbComTxRing)
+    {
+        if (usbComTxRingCount == 0 && inFifoBytesLoaded == 0)
+        {
+            usbComTxWaitStart = (uint8)getMs();
+        }
+
+        usbComTxRing[usbComTxRingHead] = byte;
+        if (++usbComTxRingHead == usbComTxRingSize)
+        {
+            usbComTxRingHead = 0;
+        }
+
+        if (++usbComTxRingCount >= CDC_IN_PACKET_SIZE)
+        {
+            usbComTxRingToFifo();
+        }
+        return;
+    }
+
+    if (inFifoBytesLoaded == 0)
+    {
+        usbComTxWaitStart = (uint8)getMs();
+    }
+
     CDC_DATA_FIFO = byte;                          // Give the byte to the USB module's FIFO.
     inFifoBytesLoaded++;
 
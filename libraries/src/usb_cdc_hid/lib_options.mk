@@ -0,0 +1,27 @@
+# This library will be made by linking usb_cdc_hid.rel, which has the
+# descriptors of the composite device, with copies of the CDC ACM and HID
+# libraries.
+LIB_RELS := libraries/src/usb_cdc_hid/usb_cdc_hid.rel libraries/src/usb_cdc_hid/cdc_acm.rel libraries/src/usb_cdc_hid/hid.rel
+
+# All three rel (object) files are compiled with the same interface and
+# endpoint numbers.  USB_COMPOSITE removes the descriptors and callbacks from
+# the copies of the CDC ACM and HID libraries.
+USB_CDC_HID_FLAGS := -DUSB_COMPOSITE \
+  -DCDC_CONTROL_INTERFACE_NUMBER=0 -DCDC_DATA_INTERFACE_NUMBER=1 \
+  -DHID_KEYBOARD_INTERFACE_NUMBER=2 -DHID_MOUSE_INTERFACE_NUMBER=3 -DHID_JOYSTICK_INTERFACE_NUMBER=4 \
+  -DHID_KEYBOARD_ENDPOINT=1 -DHID_MOUSE_ENDPOINT=2 -DHID_JOYSTICK_ENDPOINT=3 \
+  -DCDC_DATA_ENDPOINT=4 -DCDC_NOTIFICATION_ENDPOINT=5
+
+libraries/src/usb_cdc_hid/usb_cdc_hid.rel : C_FLAGS += $(USB_CDC_HID_FLAGS)
+libraries/src/usb_cdc_hid/cdc_acm.rel : C_FLAGS += $(USB_CDC_HID_FLAGS)
+libraries/src/usb_cdc_hid/hid.rel : C_FLAGS += $(USB_CDC_HID_FLAGS)
+
+# The rel files will be compiled from cdc_acm.c and hid.c, which will be
+# copies of the usb_cdc_acm and usb_hid libraries.
+libraries/src/usb_cdc_hid/cdc_acm.c : libraries/src/usb_cdc_acm/usb_cdc_acm.c
+	$(CP) $< $@
+
+libraries/src/usb_cdc_hid/hid.c : libraries/src/usb_hid/usb_hid.c
+	$(CP) $< $@
+
+TARGETS += libraries/src/usb_cdc_hid/cdc_acm.c libraries/src/usb_cdc_hid/hid.c
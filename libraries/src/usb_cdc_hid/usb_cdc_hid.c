@@ -0,0 +1,297 @@
+/* usb_cdc_hid.c: The descriptors of a composite USB device with a CDC ACM
+ * virtual COM port and the keyboard, mouse, and joystick interfaces of
+ * usb_hid.  See usb_cdc_hid.h for the public interface.
+ *
+ * The interface and endpoint numbers are defined in lib_options.mk, because
+ * the copies of the CDC ACM and HID libraries need to use the same numbers.
+ * The CDC ACM notification endpoint is endpoint 5 because usb_hid uses
+ * endpoints 1-3.
+ */
+
+#include <usb.h>
+#include <usb_composite.h>
+#include <usb_cdc_hid.h>
+#include <board.h>           // just for serialNumberStringDescriptor
+
+#define CDC_PACKET_SIZE            64
+#define HID_IN_PACKET_SIZE         8
+
+#ifndef HID_IN_INTERVAL
+#define HID_IN_INTERVAL            10
+#endif
+
+// USB Class Codes from the Interface Association Descriptor ECN.
+#define MISC_CLASS                 0xEF
+#define MISC_SUBCLASS_COMMON       2
+#define MISC_PROTOCOL_IAD          1
+
+// CDC Codes from CDC 1.20 Sections 4.1-4.5 and 5.2.3.
+#define CDC_CLASS                  2
+#define CDC_DATA_INTERFACE_CLASS   0xA
+#define CDC_SUBCLASS_ACM           2
+#define CDC_PROTOCOL_V250          1
+#define CDC_DESCRIPTOR_TYPE_CS_INTERFACE 0x24
+#define CDC_DESCRIPTOR_SUBTYPE_HEADER                       0
+#define CDC_DESCRIPTOR_SUBTYPE_CALL_MANAGEMENT              1
+#define CDC_DESCRIPTOR_SUBTYPE_ABSTRACT_CONTROL_MANAGEMENT  2
+#define CDC_DESCRIPTOR_SUBTYPE_UNION                        6
+
+// HID Codes from HID 1.11 Sections 4 and 7.1.
+#define HID_CLASS                  3
+#define HID_SUBCLASS_BOOT          1
+#define HID_PROTOCOL_KEYBOARD      1
+#define HID_PROTOCOL_MOUSE         2
+#define HID_DESCRIPTOR_TYPE_HID    0x21
+#define HID_DESCRIPTOR_TYPE_REPORT 0x22
+#define HID_COUNTRY_NOT_LOCALIZED  0
+
+/* Composite USB Descriptors **************************************************/
+
+USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
+{
+    sizeof(USB_DESCRIPTOR_DEVICE),
+    USB_DESCRIPTOR_TYPE_DEVICE,
+    0x0200,                 // USB Spec Release Number in BCD format
+    MISC_CLASS,             // Class Code: Miscellaneous (required for Interface Association Descriptors)
+    MISC_SUBCLASS_COMMON,   // Subclass code: Common Class
+    MISC_PROTOCOL_IAD,      // Protocol code: Interface Association Descriptor
+    USB_EP0_PACKET_SIZE,    // Max packet size for Endpoint 0
+    USB_VENDOR_ID_POLOLU,   // Vendor ID
+    0x2203,                 // Product ID (Generic Wixel with a CDC ACM port and HID interfaces)
+    0x0000,                 // Device release number in BCD format
+    1,                      // Index of Manufacturer String Descriptor
+    2,                      // Index of Product String Descriptor
+    3,                      // Index of Serial Number String Descriptor
+    1                       // Number of possible configurations.
+};
+
+CODE struct CONFIG1 {
+    USB_DESCRIPTOR_CONFIGURATION configuration;
+
+    USB_DESCRIPTOR_INTERFACE_ASSOCIATION cdc_association;
+    USB_DESCRIPTOR_INTERFACE communication_interface;
+    unsigned char class_specific[19];  // CDC-Specific Descriptors
+    USB_DESCRIPTOR_ENDPOINT notification_element;
+    USB_DESCRIPTOR_INTERFACE data_interface;
+    USB_DESCRIPTOR_ENDPOINT data_out;
+    USB_DESCRIPTOR_ENDPOINT data_in;
+
+    USB_DESCRIPTOR_INTERFACE keyboard_interface;
+    uint8 keyboard_hid[9]; // HID Descriptor
+    USB_DESCRIPTOR_ENDPOINT keyboard_in;
+
+    USB_DESCRIPTOR_INTERFACE mouse_interface;
+    uint8 mouse_hid[9]; // HID Descriptor
+    USB_DESCRIPTOR_ENDPOINT mouse_in;
+
+    USB_DESCRIPTOR_INTERFACE joystick_interface;
+    uint8 joystick_hid[9]; // HID Descriptor
+    USB_DESCRIPTOR_ENDPOINT joystick_in;
+} usbConfigurationDescriptor
+=
+{
+    {                                                    // Configuration Descriptor
+        sizeof(USB_DESCRIPTOR_CONFIGURATION),
+        USB_DESCRIPTOR_TYPE_CONFIGURATION,
+        sizeof(struct CONFIG1),                          // wTotalLength
+        5,                                               // bNumInterfaces
+        1,                                               // bConfigurationValue
+        0,                                               // iConfiguration
+        0xC0,                                            // bmAttributes: self powered (but may use bus power)
+        50,                                              // bMaxPower
+    },
+    {                                                    // Interface Association: groups the two CDC interfaces.
+        sizeof(USB_DESCRIPTOR_INTERFACE_ASSOCIATION),
+        USB_DESCRIPTOR_TYPE_INTERFACE_ASSOCIATION,
+        CDC_CONTROL_INTERFACE_NUMBER,                    // bFirstInterface
+        2,                                               // bInterfaceCount
+        CDC_CLASS,                                       // bFunctionClass
+        CDC_SUBCLASS_ACM,                                // bFunctionSubClass
+        CDC_PROTOCOL_V250,                               // bFunctionProtocol
+        0                                                // iFunction
+    },
+    {                                                    // Communications Interface: Used for device management.
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        CDC_CONTROL_INTERFACE_NUMBER,                    // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        1,                                               // bNumEndpoints
+        CDC_CLASS,                                       // bInterfaceClass
+        CDC_SUBCLASS_ACM,                                // bInterfaceSubClass
+        CDC_PROTOCOL_V250,                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {                                                    // Functional Descriptors (same as in usb_cdc_acm.c).
+        5,                                               // Header Functional Descriptor
+        CDC_DESCRIPTOR_TYPE_CS_INTERFACE,
+        CDC_DESCRIPTOR_SUBTYPE_HEADER,
+        0x20,0x01,                                       // bcdCDC.  We conform to CDC 1.20.
+
+        4,                                               // Abstract Control Management Functional Descriptor.
+        CDC_DESCRIPTOR_TYPE_CS_INTERFACE,
+        CDC_DESCRIPTOR_SUBTYPE_ABSTRACT_CONTROL_MANAGEMENT,
+        2,                                               // bmCapabilities
+
+        5,                                               // Union Interface Functional Descriptor
+        CDC_DESCRIPTOR_TYPE_CS_INTERFACE,
+        CDC_DESCRIPTOR_SUBTYPE_UNION,
+        CDC_CONTROL_INTERFACE_NUMBER,                    // index of the control interface
+        CDC_DATA_INTERFACE_NUMBER,                       // index of the subordinate interface
+
+        5,                                               // Call Management Functional Descriptor
+        CDC_DESCRIPTOR_TYPE_CS_INTERFACE,
+        CDC_DESCRIPTOR_SUBTYPE_CALL_MANAGEMENT,
+        0x00,                                            // bmCapabilities.  Device does not handle call management.
+        CDC_DATA_INTERFACE_NUMBER                        // index of the data interface
+    },
+    {
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | CDC_NOTIFICATION_ENDPOINT,  // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        10,                                              // wMaxPacketSize
+        1,                                               // bInterval
+    },
+    {                                                    // Data Interface: used for RX and TX data.
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        CDC_DATA_INTERFACE_NUMBER,                       // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        2,                                               // bNumEndpoints
+        CDC_DATA_INTERFACE_CLASS,                        // bInterfaceClass
+        0,                                               // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {                                                    // OUT Endpoint: Sends data out to Wixel.
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_OUT | CDC_DATA_ENDPOINT,    // bEndpointAddress
+        USB_TRANSFER_TYPE_BULK,                          // bmAttributes
+        CDC_PACKET_SIZE,                                 // wMaxPacketSize
+        0,                                               // bInterval
+    },
+    {
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | CDC_DATA_ENDPOINT,     // bEndpointAddress
+        USB_TRANSFER_TYPE_BULK,                          // bmAttributes
+        CDC_PACKET_SIZE,                                 // wMaxPacketSize
+        0,                                               // bInterval
+    },
+    {                                                    // Keyboard Interface
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        HID_KEYBOARD_INTERFACE_NUMBER,                   // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        1,                                               // bNumEndpoints
+        HID_CLASS,                                       // bInterfaceClass
+        HID_SUBCLASS_BOOT,                               // bInterfaceSubClass
+        HID_PROTOCOL_KEYBOARD,                           // bInterfaceProtocol
+        4                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.keyboard_hid), // 9-byte HID Descriptor for keyboard (HID 1.11 Section 6.2.1)
+        HID_DESCRIPTOR_TYPE_HID,
+        0x11, 0x01,                                      // bcdHID.  We conform to HID 1.11.
+        HID_COUNTRY_NOT_LOCALIZED,                       // bCountryCode
+        1,                                               // bNumDescriptors
+        HID_DESCRIPTOR_TYPE_REPORT,                      // bDescriptorType
+        USB_HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE, 0       // wDescriptorLength
+    },
+    {                                                    // Keyboard IN Endpoint
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | HID_KEYBOARD_ENDPOINT, // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        HID_IN_PACKET_SIZE,                              // wMaxPacketSize
+        HID_IN_INTERVAL,                                 // bInterval
+    },
+    {                                                    // Mouse Interface
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        HID_MOUSE_INTERFACE_NUMBER,                      // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        1,                                               // bNumEndpoints
+        HID_CLASS,                                       // bInterfaceClass
+        HID_SUBCLASS_BOOT,                               // bInterfaceSubClass
+        HID_PROTOCOL_MOUSE,                              // bInterfaceProtocol
+        5                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.mouse_hid),    // 9-byte HID Descriptor for mouse (HID 1.11 Section 6.2.1)
+        HID_DESCRIPTOR_TYPE_HID,
+        0x11, 0x01,                                      // bcdHID.  We conform to HID 1.11.
+        HID_COUNTRY_NOT_LOCALIZED,                       // bCountryCode
+        1,                                               // bNumDescriptors
+        HID_DESCRIPTOR_TYPE_REPORT,                      // bDescriptorType
+        USB_HID_MOUSE_REPORT_DESCRIPTOR_SIZE, 0          // wDescriptorLength
+    },
+    {                                                    // Mouse IN Endpoint
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | HID_MOUSE_ENDPOINT,    // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        HID_IN_PACKET_SIZE,                              // wMaxPacketSize
+        HID_IN_INTERVAL,                                 // bInterval
+    },
+    {                                                    // Joystick Interface
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        HID_JOYSTICK_INTERFACE_NUMBER,                   // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        1,                                               // bNumEndpoints
+        HID_CLASS,                                       // bInterfaceClass
+        0,                                               // bInterfaceSubClass
+        0,                                               // bInterfaceProtocol
+        6                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.joystick_hid), // 9-byte HID Descriptor for joystick (HID 1.11 Section 6.2.1)
+        HID_DESCRIPTOR_TYPE_HID,
+        0x11, 0x01,                                      // bcdHID.  We conform to HID 1.11.
+        HID_COUNTRY_NOT_LOCALIZED,                       // bCountryCode
+        1,                                               // bNumDescriptors
+        HID_DESCRIPTOR_TYPE_REPORT,                      // bDescriptorType
+        USB_HID_JOYSTICK_REPORT_DESCRIPTOR_SIZE, 0       // wDescriptorLength
+    },
+    {                                                    // Joystick IN Endpoint
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | HID_JOYSTICK_ENDPOINT, // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        HID_IN_PACKET_SIZE,                              // wMaxPacketSize
+        HID_IN_INTERVAL,                                 // bInterval
+    },
+};
+
+uint8 CODE usbStringDescriptorCount = 7;
+DEFINE_STRING_DESCRIPTOR(languages, 1, USB_LANGUAGE_EN_US)
+DEFINE_STRING_DESCRIPTOR(manufacturer, 18, 'P','o','l','o','l','u',' ','C','o','r','p','o','r','a','t','i','o','n')
+DEFINE_STRING_DESCRIPTOR(product, 5, 'W','i','x','e','l')
+DEFINE_STRING_DESCRIPTOR(keyboardName, 14, 'W','i','x','e','l',' ','K','e','y','b','o','a','r','d')
+DEFINE_STRING_DESCRIPTOR(mouseName, 11, 'W','i','x','e','l',' ','M','o','u','s','e')
+DEFINE_STRING_DESCRIPTOR(joystickName, 14, 'W','i','x','e','l',' ','J','o','y','s','t','i','c','k')
+uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product, serialNumberStringDescriptor, keyboardName, mouseName, joystickName };
+
+/* Composite Functions ********************************************************/
+
+USB_COMPOSITE_FUNCTION CODE usbCompositeFunctions[] =
+{
+    {
+        CDC_CONTROL_INTERFACE_NUMBER, 2,                 // Interfaces 0 and 1
+        usbComInitEndpoints,
+        usbComSetupHandler,
+        0,
+        usbComControlWriteHandler,
+    },
+    {
+        HID_KEYBOARD_INTERFACE_NUMBER, 3,                // Interfaces 2, 3, and 4
+        usbHidInitEndpoints,
+        usbHidSetupHandler,
+        usbHidClassDescriptorHandler,
+        0,
+    },
+};
+
+uint8 CODE usbCompositeFunctionCount = sizeof(usbCompositeFunctions) / sizeof(usbCompositeFunctions[0]);
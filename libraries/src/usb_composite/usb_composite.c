@@ -0,0 +1,69 @@
+/* usb_composite.c: Passes the usb.c callbacks on to the functions of a
+ * composite device.  See usb_composite.h for the public interface.
+ */
+
+#include <usb.h>
+#include <usb_composite.h>
+
+// Returns 1 if the current request should be passed to the specified function:
+// either it is addressed to one of the function's interfaces, or it is not
+// addressed to an interface at all.
+static BIT usbCompositeWantsRequest(USB_COMPOSITE_FUNCTION CODE * function)
+{
+    if (usbSetupPacket.recipient != USB_RECIPIENT_INTERFACE)
+    {
+        return 1;
+    }
+
+    return (uint8)((uint8)usbSetupPacket.wIndex - function->firstInterface) < function->interfaceCount;
+}
+
+void usbCallbackInitEndpoints()
+{
+    uint8 i;
+    for (i = 0; i < usbCompositeFunctionCount; i++)
+    {
+        if (usbCompositeFunctions[i].initEndpoints)
+        {
+            usbCompositeFunctions[i].initEndpoints();
+        }
+    }
+}
+
+void usbCallbackSetupHandler()
+{
+    uint8 i;
+    for (i = 0; i < usbCompositeFunctionCount; i++)
+    {
+        if (usbCompositeFunctions[i].setupHandler && usbCompositeWantsRequest(&usbCompositeFunctions[i]))
+        {
+            usbCompositeFunctions[i].setupHandler();
+        }
+    }
+}
+
+void usbCallbackClassDescriptorHandler()
+{
+    uint8 i;
+    for (i = 0; i < usbCompositeFunctionCount; i++)
+    {
+        if (usbCompositeFunctions[i].classDescriptorHandler && usbCompositeWantsRequest(&usbCompositeFunctions[i]))
+        {
+            usbCompositeFunctions[i].classDescriptorHandler();
+        }
+    }
+}
+
+// usbSetupPacket still holds the request that started the Control Write
+// transfer, so the data goes to the same function as the request did.
+void usbCallbackControlWriteHandler()
+{
+    uint8 i;
+    for (i = 0; i < usbCompositeFunctionCount; i++)
+    {
+        if (usbCompositeFunctions[i].controlWriteHandler && usbCompositeWantsRequest(&usbCompositeFunctions[i]))
+        {
+            usbCompositeFunctions[i].controlWriteHandler();
+        }
+    }
+}
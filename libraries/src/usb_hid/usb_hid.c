@@ -1,27 +1,43 @@
-// TODO: Add a function for converting chars to keycodes.  The test_hid app
-//   contains the start of such a function.
-// TODO: Don't use double-buffered USB endpoints.  It just increases latency.
-
 #include <usb_hid.h>
 #include <usb.h>
 #include <board.h>
 #include <time.h>
 
 /* HID Library Configuration **************************************************/
+// The interface and endpoint numbers can be changed with preprocessor flags
+// when this file is compiled as part of a composite device (see usb_composite.h).
 
 #define HID_IN_PACKET_SIZE            8
+
+// The polling interval of the IN endpoints, in ms.  The usb_hid_1ms library
+// is compiled with HID_IN_INTERVAL=1.
+#ifndef HID_IN_INTERVAL
+#define HID_IN_INTERVAL               10
+#endif
+
+#ifndef HID_KEYBOARD_INTERFACE_NUMBER
 #define HID_KEYBOARD_INTERFACE_NUMBER 0
+#endif
+
+#ifndef HID_MOUSE_INTERFACE_NUMBER
 #define HID_MOUSE_INTERFACE_NUMBER    1
+#endif
+
+#ifndef HID_JOYSTICK_INTERFACE_NUMBER
 #define HID_JOYSTICK_INTERFACE_NUMBER 2
+#endif
 
+#ifndef HID_KEYBOARD_ENDPOINT
 #define HID_KEYBOARD_ENDPOINT         1
-#define HID_KEYBOARD_FIFO             USBF1   // This must match HID_KEYBOARD_ENDPOINT!
+#endif
 
+#ifndef HID_MOUSE_ENDPOINT
 #define HID_MOUSE_ENDPOINT            2
-#define HID_MOUSE_FIFO                USBF2   // This must match HID_MOUSE_ENDPOINT!
+#endif
 
+#ifndef HID_JOYSTICK_ENDPOINT
 #define HID_JOYSTICK_ENDPOINT         3
-#define HID_JOYSTICK_FIFO             USBF3   // This must match HID_JOYSTICK_ENDPOINT!
+#endif
 
 /* HID Constants **************************************************************/
 
@@ -103,6 +119,12 @@
 #define HID_PROTOCOL_REPORT 1
 
 /* HID USB Descriptors ****************************************************/
+// When this file is compiled as part of a composite device (USB_COMPOSITE is
+// defined), the composite library provides the device, configuration, and
+// string descriptors and the USB callbacks.  The report descriptors are always
+// defined here.
+
+#ifndef USB_COMPOSITE
 
 USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
 {
@@ -122,6 +144,8 @@ USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
     1                       // Number of possible configurations.
 };
 
+#endif
+
 // keyboard report descriptor
 // HID 1.11 Section 6.2.2: Report Descriptor
 // Uses format compatible with keyboard boot interface report descriptor - see HID 1.11 Appendix B.1
@@ -239,6 +263,14 @@ uint8 CODE joystickReportDescriptor[]
     HID_END_COLLECTION,
 };
 
+// The sizes in usb_hid.h must match the report descriptors above.
+// If they do not, these arrays will have negative sizes and the compiler will report an error.
+typedef uint8 keyboardReportDescriptorSizeCheck[sizeof(keyboardReportDescriptor) == USB_HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE ? 1 : -1];
+typedef uint8 mouseReportDescriptorSizeCheck[sizeof(mouseReportDescriptor) == USB_HID_MOUSE_REPORT_DESCRIPTOR_SIZE ? 1 : -1];
+typedef uint8 joystickReportDescriptorSizeCheck[sizeof(joystickReportDescriptor) == USB_HID_JOYSTICK_REPORT_DESCRIPTOR_SIZE ? 1 : -1];
+
+#ifndef USB_COMPOSITE
+
 CODE struct CONFIG1 {
     USB_DESCRIPTOR_CONFIGURATION configuration;
 
@@ -292,7 +324,7 @@ CODE struct CONFIG1 {
         USB_ENDPOINT_ADDRESS_IN | HID_KEYBOARD_ENDPOINT, // bEndpointAddress
         USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
         HID_IN_PACKET_SIZE,                              // wMaxPacketSize
-        10,                                              // bInterval
+        HID_IN_INTERVAL,                                 // bInterval
     },
     {                                                    // Mouse Interface
         sizeof(USB_DESCRIPTOR_INTERFACE),
@@ -320,7 +352,7 @@ CODE struct CONFIG1 {
         USB_ENDPOINT_ADDRESS_IN | HID_MOUSE_ENDPOINT,    // bEndpointAddress
         USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
         HID_IN_PACKET_SIZE,                              // wMaxPacketSize
-        10,                                              // bInterval
+        HID_IN_INTERVAL,                                 // bInterval
     },
     {                                                    // Joystick Interface
         sizeof(USB_DESCRIPTOR_INTERFACE),
@@ -348,7 +380,7 @@ CODE struct CONFIG1 {
         USB_ENDPOINT_ADDRESS_IN | HID_JOYSTICK_ENDPOINT, // bEndpointAddress
         USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
         HID_IN_PACKET_SIZE,                              // wMaxPacketSize
-        10,                                              // bInterval
+        HID_IN_INTERVAL,                                 // bInterval
     },
 };
 
@@ -361,6 +393,8 @@ DEFINE_STRING_DESCRIPTOR(mouseName, 11, 'W','i','x','e','l',' ','M','o','u','s',
 DEFINE_STRING_DESCRIPTOR(joystickName, 14, 'W','i','x','e','l',' ','J','o','y','s','t','i','c','k')
 uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product, serialNumberStringDescriptor, keyboardName, mouseName, joystickName };
 
+#endif
+
 /* HID structs and global variables *******************************************/
 
 HID_KEYBOARD_OUT_REPORT XDATA usbHidKeyboardOutput = {0};
@@ -377,19 +411,67 @@ uint16 XDATA hidKeyboardIdleDuration = 500; // 0 to 1020 ms
 BIT hidKeyboardProtocol = HID_PROTOCOL_REPORT;
 BIT hidMouseProtocol    = HID_PROTOCOL_REPORT;
 
+// Mouse movement that has been reported by the app but not sent yet.
+// It is sent in pieces of up to 127 counts per report.  Each accumulator is
+// limited to HID_MOUSE_MAX_PENDING counts so that it cannot overflow, and so
+// that the host does not get a long backlog of stale movement after it has
+// not been polling (for example while the computer was suspended).
+#define HID_MOUSE_MAX_PENDING  1024
+static int16 XDATA hidMouseX = 0;
+static int16 XDATA hidMouseY = 0;
+static int16 XDATA hidMouseWheel = 0;
+static BIT hidMousePending = 0;
+
+// The keyboard report queue.
+static HID_KEYBOARD_IN_REPORT XDATA hidKeyboardQueue[USB_HID_KEYBOARD_QUEUE_LENGTH];
+static uint8 XDATA hidKeyboardQueueHead = 0;    // The report that will be filled next.
+static uint8 XDATA hidKeyboardQueueTail = 0;    // The report that will be sent next.
+static uint8 XDATA hidKeyboardQueueCount = 0;
+
 /* HID USB callbacks **********************************************************/
 // These functions are called by the low-level USB module (usb.c) when a USB
 // event happens that requires higher-level code to make a decision.
 
+#ifndef USB_COMPOSITE
+
 void usbCallbackInitEndpoints(void)
 {
+    usbHidInitEndpoints();
+}
+
+void usbCallbackSetupHandler(void)
+{
+    usbHidSetupHandler();
+}
+
+void usbCallbackClassDescriptorHandler(void)
+{
+    usbHidClassDescriptorHandler();
+}
+
+void usbCallbackControlWriteHandler(void)
+{
+    // not used by usb_hid
+}
+
+#endif
+
+/* HID request handlers *******************************************************/
+
+void usbHidInitEndpoints(void)
+{
+    // Double buffering is disabled because it would let a second, older
+    // report wait in the FIFO, which only adds latency.
     usbInitEndpointIn(HID_KEYBOARD_ENDPOINT, HID_IN_PACKET_SIZE);
+    USBCSIH = 0;
     usbInitEndpointIn(HID_MOUSE_ENDPOINT, HID_IN_PACKET_SIZE);
+    USBCSIH = 0;
     usbInitEndpointIn(HID_JOYSTICK_ENDPOINT, HID_IN_PACKET_SIZE);
+    USBCSIH = 0;
 }
 
 // Implements all the control transfers that are required by Appendix G of HID 1.11.
-void usbCallbackSetupHandler(void)
+void usbHidSetupHandler(void)
 {
     static XDATA uint8 response;
 
@@ -489,8 +571,10 @@ void usbCallbackSetupHandler(void)
     }
 }
 
-void usbCallbackClassDescriptorHandler(void)
+void usbHidClassDescriptorHandler(void)
 {
+    uint8 CODE * descriptor;
+
     // Require Direction==Device-to-Host, Type==Standard, and Recipient==Interface. (HID 1.11 Section 7.1.1)
     if (usbSetupPacket.bmRequestType != 0x81)
     {
@@ -501,19 +585,11 @@ void usbCallbackClassDescriptorHandler(void)
     {
     case HID_DESCRIPTOR_TYPE_HID:
         // The host has requested the HID descriptor of a particular interface.
-        switch (usbSetupPacket.wIndex)
+        // It is part of the configuration descriptor, after the interface descriptor.
+        descriptor = usbFindClassDescriptor(usbSetupPacket.wIndex, HID_DESCRIPTOR_TYPE_HID);
+        if (descriptor)
         {
-        case HID_KEYBOARD_INTERFACE_NUMBER:
-            usbControlRead(sizeof(usbConfigurationDescriptor.keyboard_hid), (uint8 XDATA *)&usbConfigurationDescriptor.keyboard_hid);
-            return;
-
-        case HID_MOUSE_INTERFACE_NUMBER:
-            usbControlRead(sizeof(usbConfigurationDescriptor.mouse_hid), (uint8 XDATA *)&usbConfigurationDescriptor.mouse_hid);
-            return;
-
-        case HID_JOYSTICK_INTERFACE_NUMBER:
-            usbControlRead(sizeof(usbConfigurationDescriptor.joystick_hid), (uint8 XDATA *)&usbConfigurationDescriptor.joystick_hid);
-            return;
+            usbControlRead(descriptor[0], (uint8 XDATA *)descriptor);
         }
         return;
 
@@ -537,16 +613,43 @@ void usbCallbackClassDescriptorHandler(void)
     }
 }
 
-void usbCallbackControlWriteHandler(void)
+/* Other HID Functions ********************************************************/
+
+// Adds movement to an accumulator, saturating at +/-HID_MOUSE_MAX_PENDING.
+static void hidMouseAccumulate(int16 XDATA * accumulator, int8 delta)
 {
-    // not used by usb_hid
+    int16 sum = *accumulator + delta;
+    if (sum > HID_MOUSE_MAX_PENDING)
+    {
+        sum = HID_MOUSE_MAX_PENDING;
+    }
+    else if (sum < -HID_MOUSE_MAX_PENDING)
+    {
+        sum = -HID_MOUSE_MAX_PENDING;
+    }
+    *accumulator = sum;
 }
 
-/* Other HID Functions ********************************************************/
+// Removes up to 127 counts of movement from an accumulator and returns them.
+static int8 hidMouseTakeDelta(int16 XDATA * accumulator)
+{
+    int16 delta = *accumulator;
+    if (delta > 127)
+    {
+        delta = 127;
+    }
+    else if (delta < -127)
+    {
+        delta = -127;
+    }
+    *accumulator -= delta;
+    return (int8)delta;
+}
 
 void usbHidService(void)
 {
     static uint16 XDATA hidKeyboardLastReportTime = 0;
+    uint16 idleDuration;
 
     usbPoll();
 
@@ -557,21 +660,68 @@ void usbHidService(void)
     }
 
     USBINDEX = HID_KEYBOARD_ENDPOINT;
-    // Check if keyboard input has been updated OR if the idle period is nonzero and has expired.
-    if ((usbHidKeyboardInputUpdated || (hidKeyboardIdleDuration && ((uint16)(getMs() - hidKeyboardLastReportTime) > hidKeyboardIdleDuration))) && !(USBCSIL & USBCSIL_INPKT_RDY))
+    if (!(USBCSIL & USBCSIL_INPKT_RDY))
     {
-        usbWriteFifo(HID_KEYBOARD_ENDPOINT, sizeof(usbHidKeyboardInput), (uint8 XDATA *)&usbHidKeyboardInput);
-        USBCSIL |= USBCSIL_INPKT_RDY;
-        usbHidKeyboardInputUpdated = 0; // reset updated flag
-        hidKeyboardLastReportTime = getMs();
+        if (hidKeyboardQueueCount)
+        {
+            // Queued reports are sent first, one per report.
+            uint8 XDATA * src = (uint8 XDATA *)&hidKeyboardQueue[hidKeyboardQueueTail];
+            uint8 XDATA * dest = (uint8 XDATA *)&usbHidKeyboardInput;
+            uint8 i;
+            for (i = 0; i < sizeof(usbHidKeyboardInput); i++)
+            {
+                dest[i] = src[i];
+            }
+
+            if (++hidKeyboardQueueTail >= USB_HID_KEYBOARD_QUEUE_LENGTH)
+            {
+                hidKeyboardQueueTail = 0;
+            }
+            hidKeyboardQueueCount--;
+            usbHidKeyboardInputUpdated = 1;
+        }
+
+        // SET_IDLE might change the idle duration in the USB interrupt, so
+        // read both of its bytes with the interrupt disabled.
+        USB_INTERRUPT_DISABLE();
+        idleDuration = hidKeyboardIdleDuration;
+        USB_INTERRUPT_RESTORE();
+
+        // Check if keyboard input has been updated OR if the idle period is nonzero and has expired.
+        if (usbHidKeyboardInputUpdated || (idleDuration && ((uint16)(getMs() - hidKeyboardLastReportTime) > idleDuration)))
+        {
+            usbWriteFifo(HID_KEYBOARD_ENDPOINT, sizeof(usbHidKeyboardInput), (uint8 XDATA *)&usbHidKeyboardInput);
+            USBCSIL |= USBCSIL_INPKT_RDY;
+            usbHidKeyboardInputUpdated = 0; // reset updated flag
+            hidKeyboardLastReportTime = getMs();
+        }
+    }
+
+    // Add new mouse movement to the movement that has not been sent yet,
+    // so that no movement is lost if the app reports it faster than the
+    // computer polls for it.
+    if (usbHidMouseInputUpdated)
+    {
+        hidMouseAccumulate(&hidMouseX, usbHidMouseInput.x);
+        hidMouseAccumulate(&hidMouseY, usbHidMouseInput.y);
+        hidMouseAccumulate(&hidMouseWheel, usbHidMouseInput.wheel);
+        usbHidMouseInput.x = usbHidMouseInput.y = usbHidMouseInput.wheel = 0;
+        usbHidMouseInputUpdated = 0;
+        hidMousePending = 1;
     }
 
     USBINDEX = HID_MOUSE_ENDPOINT;
-    // Check if mouse input has been updated.
-    if (usbHidMouseInputUpdated && !(USBCSIL & USBCSIL_INPKT_RDY)) {
+    if (hidMousePending && !(USBCSIL & USBCSIL_INPKT_RDY))
+    {
+        usbHidMouseInput.x = hidMouseTakeDelta(&hidMouseX);
+        usbHidMouseInput.y = hidMouseTakeDelta(&hidMouseY);
+        usbHidMouseInput.wheel = hidMouseTakeDelta(&hidMouseWheel);
         usbWriteFifo(HID_MOUSE_ENDPOINT, sizeof(usbHidMouseInput), (uint8 XDATA *)&usbHidMouseInput);
         USBCSIL |= USBCSIL_INPKT_RDY;
-        usbHidMouseInputUpdated = 0; // reset updated flag
+        usbHidMouseInput.x = usbHidMouseInput.y = usbHidMouseInput.wheel = 0;
+
+        // Keep sending reports until all the movement has been sent.
+        hidMousePending = (hidMouseX || hidMouseY || hidMouseWheel);
     }
 
     USBINDEX = HID_JOYSTICK_ENDPOINT;
@@ -583,6 +733,84 @@ void usbHidService(void)
     }
 }
 
+HID_KEYBOARD_IN_REPORT XDATA * usbHidKeyboardQueueCurrentReport()
+{
+    if (hidKeyboardQueueCount >= USB_HID_KEYBOARD_QUEUE_LENGTH)
+    {
+        return 0;
+    }
+    return &hidKeyboardQueue[hidKeyboardQueueHead];
+}
+
+void usbHidKeyboardQueueSendReport()
+{
+    if (++hidKeyboardQueueHead >= USB_HID_KEYBOARD_QUEUE_LENGTH)
+    {
+        hidKeyboardQueueHead = 0;
+    }
+    hidKeyboardQueueCount++;
+}
+
+uint8 usbHidKeyboardQueueFree()
+{
+    return USB_HID_KEYBOARD_QUEUE_LENGTH - hidKeyboardQueueCount;
+}
+
+// Puts a report with one key (or no key) and the specified modifiers in the queue.
+// Assumption: There is room in the queue.
+static void hidKeyboardQueueKey(uint8 modifiers, uint8 keyCode)
+{
+    HID_KEYBOARD_IN_REPORT XDATA * report = &hidKeyboardQueue[hidKeyboardQueueHead];
+    uint8 i;
+
+    report->modifiers = modifiers;
+    report->_reserved = 0;
+    report->keyCodes[0] = keyCode;
+    for (i = 1; i < sizeof(report->keyCodes); i++)
+    {
+        report->keyCodes[i] = 0;
+    }
+    usbHidKeyboardQueueSendReport();
+}
+
+// The ASCII characters (other than capital letters) that are typed with Shift
+// on a US keyboard.
+static char CODE hidShiftedChars[] = "~!@#$%^&*()_+{}|:\"<>?";
+
+BIT usbHidKeyboardQueueChar(char asciiChar)
+{
+    uint8 keyCode = usbHidKeyCodeFromAsciiChar(asciiChar);
+    uint8 modifiers = 0;
+    uint8 i;
+
+    if (keyCode == 0 || usbHidKeyboardQueueFree() < 2)
+    {
+        return 0;
+    }
+
+    if (asciiChar >= 'A' && asciiChar <= 'Z')
+    {
+        modifiers = 1<<MODIFIER_SHIFT_LEFT;
+    }
+    else
+    {
+        for (i = 0; i < sizeof(hidShiftedChars) - 1; i++)
+        {
+            if (hidShiftedChars[i] == asciiChar)
+            {
+                modifiers = 1<<MODIFIER_SHIFT_LEFT;
+                break;
+            }
+        }
+    }
+
+    // Press the key and then release it, so that the same character can be
+    // typed twice in a row.
+    hidKeyboardQueueKey(modifiers, keyCode);
+    hidKeyboardQueueKey(0, 0);
+    return 1;
+}
+
 // Look-up table stored in code memory that we use to convert from ASCII
 // characters to HID key codes.
 uint8 CODE hidKeyCode[128] =
@@ -0,0 +1,10 @@
+# This library will be made by linking hid_1ms.rel, which is compiled from
+# a copy of the usb_hid library with a 1 ms polling interval.
+LIB_RELS := libraries/src/usb_hid_1ms/hid_1ms.rel
+
+libraries/src/usb_hid_1ms/hid_1ms.rel : C_FLAGS += -DHID_IN_INTERVAL=1
+
+libraries/src/usb_hid_1ms/hid_1ms.c : libraries/src/usb_hid/usb_hid.c
+	$(CP) $< $@
+
+TARGETS += libraries/src/usb_hid_1ms/hid_1ms.c
@@ -0,0 +1,416 @@
+/* usb_hid_raw.c: A HID interface with vendor-defined 64-byte input and
+ * output reports.  See usb_hid_raw.h for the public interface.
+ */
+
+#include <usb_hid_raw.h>
+#include <usb.h>
+#include <board.h>           // just for serialNumberStringDescriptor
+
+/* Raw HID Library Configuration **********************************************/
+// We picked endpoint 3 because its 128-byte FIFO memory area is exactly
+// enough for one 64-byte IN buffer and one 64-byte OUT buffer.  The endpoints
+// are single-buffered: the host polls them every millisecond anyway, and a
+// second buffer would only add latency.
+// The interface and endpoint numbers can be changed with preprocessor flags
+// when this file is compiled as part of a composite device (see usb_composite.h).
+
+#ifndef HID_RAW_INTERFACE_NUMBER
+#define HID_RAW_INTERFACE_NUMBER      0
+#endif
+
+#ifndef HID_RAW_ENDPOINT
+#define HID_RAW_ENDPOINT              3
+#endif
+
+/* HID Constants **************************************************************/
+
+// USB Class Code from HID 1.11 Section 4.1: The HID Class
+#define HID_CLASS    3
+
+// USB Descriptor types from HID 1.11 Section 7.1
+#define HID_DESCRIPTOR_TYPE_HID    0x21
+#define HID_DESCRIPTOR_TYPE_REPORT 0x22
+
+// Country Codes from HID 1.11 Section 6.2.1
+#define HID_COUNTRY_NOT_LOCALIZED 0
+
+// HID Report Items from HID 1.11 Section 6.2.2
+#define HID_USAGE_PAGE_2    0x06 // 2-byte data
+#define HID_USAGE           0x09
+#define HID_COLLECTION      0xA1
+#define HID_END_COLLECTION  0xC0
+#define HID_REPORT_COUNT    0x95
+#define HID_REPORT_SIZE     0x75
+#define HID_LOGICAL_MIN     0x15
+#define HID_LOGICAL_MAX_2   0x26 // 2-byte data
+#define HID_INPUT           0x81
+#define HID_OUTPUT          0x91
+
+// HID Report Collection Types from HID 1.12 6.2.2.6
+#define HID_COLLECTION_APPLICATION 1
+
+// HID Input/Output/Feature Item Data (attributes) from HID 1.11 6.2.2.5
+#define HID_ITEM_VARIABLE 0x2
+
+// Request Codes from HID 1.11 Section 7.2
+#define HID_REQUEST_GET_REPORT   0x1
+#define HID_REQUEST_GET_IDLE     0x2
+#define HID_REQUEST_SET_REPORT   0x9
+#define HID_REQUEST_SET_IDLE     0xA
+
+// Report Types from HID 1.11 Section 7.2.1
+#define HID_REPORT_TYPE_INPUT   1
+#define HID_REPORT_TYPE_OUTPUT  2
+
+/* Raw HID USB Descriptors ****************************************************/
+
+// HID 1.11 Section 6.2.2: Report Descriptor
+// One 64-byte input report and one 64-byte output report, in the first
+// vendor-defined usage page (HID Usage Tables 1.12 Section 3).
+uint8 CODE hidRawReportDescriptor[]
+=
+{
+    HID_USAGE_PAGE_2, 0x00, 0xFF,                       // Vendor-defined usage page 0xFF00
+    HID_USAGE, 1,
+    HID_COLLECTION, HID_COLLECTION_APPLICATION,
+
+        HID_USAGE, 2,                                   // Input report
+        HID_LOGICAL_MIN, 0,
+        HID_LOGICAL_MAX_2, 0xFF, 0x00,
+        HID_REPORT_SIZE, 8,
+        HID_REPORT_COUNT, USB_HID_RAW_REPORT_SIZE,
+        HID_INPUT, HID_ITEM_VARIABLE,
+
+        HID_USAGE, 3,                                   // Output report
+        HID_OUTPUT, HID_ITEM_VARIABLE,
+
+    HID_END_COLLECTION,
+};
+
+// The size in usb_hid_raw.h must match the report descriptor above.
+// If it does not, this array will have a negative size and the compiler will report an error.
+typedef uint8 hidRawReportDescriptorSizeCheck[sizeof(hidRawReportDescriptor) == USB_HID_RAW_REPORT_DESCRIPTOR_SIZE ? 1 : -1];
+
+// When this file is compiled as part of a composite device (USB_COMPOSITE is
+// defined), the composite library provides the device, configuration, and
+// string descriptors and the USB callbacks.
+
+#ifndef USB_COMPOSITE
+
+USB_DESCRIPTOR_DEVICE CODE usbDeviceDescriptor =
+{
+    sizeof(USB_DESCRIPTOR_DEVICE),
+    USB_DESCRIPTOR_TYPE_DEVICE,
+    0x0200,                 // USB Spec Release Number in BCD format
+    0,                      // Class Code: undefined (use class code info from Interface Descriptors)
+    0,                      // Subclass code
+    0,                      // Protocol
+    USB_EP0_PACKET_SIZE,    // Max packet size for Endpoint 0
+    USB_VENDOR_ID_POLOLU,   // Vendor ID
+    0x2204,                 // Product ID (Generic Wixel with one raw HID interface)
+    0x0000,                 // Device release number in BCD format
+    1,                      // Index of Manufacturer String Descriptor
+    2,                      // Index of Product String Descriptor
+    3,                      // Index of Serial Number String Descriptor
+    1                       // Number of possible configurations.
+};
+
+CODE struct CONFIG1 {
+    USB_DESCRIPTOR_CONFIGURATION configuration;
+    USB_DESCRIPTOR_INTERFACE raw_interface;
+    uint8 raw_hid[9]; // HID Descriptor
+    USB_DESCRIPTOR_ENDPOINT raw_in;
+    USB_DESCRIPTOR_ENDPOINT raw_out;
+} usbConfigurationDescriptor
+=
+{
+    {                                                    // Configuration Descriptor
+        sizeof(USB_DESCRIPTOR_CONFIGURATION),
+        USB_DESCRIPTOR_TYPE_CONFIGURATION,
+        sizeof(struct CONFIG1),                          // wTotalLength
+        1,                                               // bNumInterfaces
+        1,                                               // bConfigurationValue
+        0,                                               // iConfiguration
+        0xC0,                                            // bmAttributes: self powered (but may use bus power)
+        50,                                              // bMaxPower
+    },
+    {                                                    // Raw HID Interface
+        sizeof(USB_DESCRIPTOR_INTERFACE),
+        USB_DESCRIPTOR_TYPE_INTERFACE,
+        HID_RAW_INTERFACE_NUMBER,                        // bInterfaceNumber
+        0,                                               // bAlternateSetting
+        2,                                               // bNumEndpoints
+        HID_CLASS,                                       // bInterfaceClass
+        0,                                               // bInterfaceSubClass: not a boot device
+        0,                                               // bInterfaceProtocol
+        0                                                // iInterface
+    },
+    {
+        sizeof(usbConfigurationDescriptor.raw_hid),      // 9-byte HID Descriptor (HID 1.11 Section 6.2.1)
+        HID_DESCRIPTOR_TYPE_HID,
+        0x11, 0x01,                                      // bcdHID.  We conform to HID 1.11.
+        HID_COUNTRY_NOT_LOCALIZED,                       // bCountryCode
+        1,                                               // bNumDescriptors
+        HID_DESCRIPTOR_TYPE_REPORT,                      // bDescriptorType
+        sizeof(hidRawReportDescriptor), 0                // wDescriptorLength
+    },
+    {                                                    // IN Endpoint: input reports
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_IN | HID_RAW_ENDPOINT,      // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        USB_HID_RAW_REPORT_SIZE,                         // wMaxPacketSize
+        1,                                               // bInterval: 1 ms
+    },
+    {                                                    // OUT Endpoint: output reports
+        sizeof(USB_DESCRIPTOR_ENDPOINT),
+        USB_DESCRIPTOR_TYPE_ENDPOINT,
+        USB_ENDPOINT_ADDRESS_OUT | HID_RAW_ENDPOINT,     // bEndpointAddress
+        USB_TRANSFER_TYPE_INTERRUPT,                     // bmAttributes
+        USB_HID_RAW_REPORT_SIZE,                         // wMaxPacketSize
+        1,                                               // bInterval: 1 ms
+    },
+};
+
+uint8 CODE usbStringDescriptorCount = 4;
+DEFINE_STRING_DESCRIPTOR(languages, 1, USB_LANGUAGE_EN_US)
+DEFINE_STRING_DESCRIPTOR(manufacturer, 18, 'P','o','l','o','l','u',' ','C','o','r','p','o','r','a','t','i','o','n')
+DEFINE_STRING_DESCRIPTOR(product, 5, 'W','i','x','e','l')
+uint16 CODE * CODE usbStringDescriptors[] = { languages, manufacturer, product, serialNumberStringDescriptor };
+
+/* Raw HID USB callbacks ******************************************************/
+// These functions are called by the low-level USB module (usb.c) when a USB
+// event happens that requires higher-level code to make a decision.
+
+void usbCallbackInitEndpoints(void)
+{
+    usbHidRawInitEndpoints();
+}
+
+void usbCallbackSetupHandler(void)
+{
+    usbHidRawSetupHandler();
+}
+
+void usbCallbackClassDescriptorHandler(void)
+{
+    usbHidRawClassDescriptorHandler();
+}
+
+void usbCallbackControlWriteHandler(void)
+{
+    usbHidRawControlWriteHandler();
+}
+
+#endif
+
+/* Raw HID Variables **********************************************************/
+
+UsbHidRawReportHandler * usbHidRawRxReportHandler = 0;
+
+// The input report queue.  It is only accessed from the main loop.
+static uint8 XDATA usbHidRawTxQueue[USB_HID_RAW_TX_QUEUE_LENGTH][USB_HID_RAW_REPORT_SIZE];
+static uint8 XDATA usbHidRawTxHead = 0;    // The report that will be filled next.
+static uint8 XDATA usbHidRawTxTail = 0;    // The report that will be sent next.
+static uint8 XDATA usbHidRawTxCount = 0;
+
+// A copy of the report that was loaded into the IN endpoint most recently.
+// It is returned by GET_REPORT requests.  It is a copy because the queue
+// entry is reused for the next report as soon as it has been sent.
+static uint8 XDATA usbHidRawTxLastReport[USB_HID_RAW_REPORT_SIZE];
+
+// The most recent output report from the OUT endpoint.
+static uint8 XDATA usbHidRawRxReport[USB_HID_RAW_REPORT_SIZE];
+
+// The most recent output report from a SET_REPORT request.  The control
+// write handler might run in the USB interrupt, so it only sets
+// usbHidRawControlReportReceived and usbHidRawService() passes the report on.
+static uint8 XDATA usbHidRawControlReport[USB_HID_RAW_REPORT_SIZE];
+static volatile BIT usbHidRawControlReportReceived = 0;
+
+static uint16 XDATA hidRawIdleDuration = 0;
+
+/* Raw HID request handlers ***************************************************/
+
+void usbHidRawInitEndpoints(void)
+{
+    usbInitEndpointIn(HID_RAW_ENDPOINT, USB_HID_RAW_REPORT_SIZE);
+    USBCSIH = 0;                    // Disable double buffering.
+    usbInitEndpointOut(HID_RAW_ENDPOINT, USB_HID_RAW_REPORT_SIZE);
+    USBCSOH = 0;                    // Disable double buffering.
+}
+
+// Implements the control transfers that are required by Appendix G of HID 1.11.
+void usbHidRawSetupHandler(void)
+{
+    static XDATA uint8 response;
+
+    if ((usbSetupPacket.bmRequestType & 0x7F) != 0x21)   // Require Type==Class and Recipient==Interface.
+        return;
+
+    if (usbSetupPacket.wIndex != HID_RAW_INTERFACE_NUMBER)
+        return;
+
+    switch(usbSetupPacket.bRequest)
+    {
+    case HID_REQUEST_GET_REPORT:
+        if ((usbSetupPacket.wValue >> 8) == HID_REPORT_TYPE_INPUT)
+        {
+            usbControlRead(USB_HID_RAW_REPORT_SIZE, usbHidRawTxLastReport);
+        }
+        return;
+
+    case HID_REQUEST_SET_REPORT:
+        // If the last report from a SET_REPORT request has not been
+        // handled yet, stall so the host can try again later.
+        if ((usbSetupPacket.wValue >> 8) == HID_REPORT_TYPE_OUTPUT && !usbHidRawControlReportReceived)
+        {
+            usbControlWrite(USB_HID_RAW_REPORT_SIZE, usbHidRawControlReport);
+        }
+        return;
+
+    // The idle rate does not affect this library because it only sends
+    // reports that are queued, but hosts may set it anyway.
+    case HID_REQUEST_GET_IDLE:
+        response = hidRawIdleDuration / 4; // value in request is in units of 4 ms
+        usbControlRead(1, (uint8 XDATA *)&response);
+        return;
+
+    case HID_REQUEST_SET_IDLE:
+        hidRawIdleDuration = (usbSetupPacket.wValue >> 8) * 4; // value in request is in units of 4 ms
+        usbControlAcknowledge();
+        return;
+
+    default:
+        // unrecognized request - stall
+        return;
+    }
+}
+
+void usbHidRawClassDescriptorHandler(void)
+{
+    uint8 CODE * descriptor;
+
+    // Require Direction==Device-to-Host, Type==Standard, and Recipient==Interface. (HID 1.11 Section 7.1.1)
+    if (usbSetupPacket.bmRequestType != 0x81 || usbSetupPacket.wIndex != HID_RAW_INTERFACE_NUMBER)
+    {
+        return;
+    }
+
+    switch (usbSetupPacket.wValue >> 8)
+    {
+    case HID_DESCRIPTOR_TYPE_HID:
+        descriptor = usbFindClassDescriptor(HID_RAW_INTERFACE_NUMBER, HID_DESCRIPTOR_TYPE_HID);
+        if (descriptor)
+        {
+            usbControlRead(descriptor[0], (uint8 XDATA *)descriptor);
+        }
+        return;
+
+    case HID_DESCRIPTOR_TYPE_REPORT:
+        usbControlRead(sizeof(hidRawReportDescriptor), (uint8 XDATA *)&hidRawReportDescriptor);
+        return;
+    }
+}
+
+void usbHidRawControlWriteHandler(void)
+{
+    if (usbSetupPacket.bRequest == HID_REQUEST_SET_REPORT &&
+        usbSetupPacket.wIndex == HID_RAW_INTERFACE_NUMBER)
+    {
+        usbHidRawControlReportReceived = 1;
+    }
+}
+
+/* Raw HID Functions **********************************************************/
+
+uint8 XDATA * usbHidRawTxCurrentReport()
+{
+    if (usbHidRawTxCount >= USB_HID_RAW_TX_QUEUE_LENGTH)
+    {
+        return 0;
+    }
+    return usbHidRawTxQueue[usbHidRawTxHead];
+}
+
+void usbHidRawTxSendReport()
+{
+    if (++usbHidRawTxHead >= USB_HID_RAW_TX_QUEUE_LENGTH)
+    {
+        usbHidRawTxHead = 0;
+    }
+    usbHidRawTxCount++;
+}
+
+uint8 usbHidRawTxQueued()
+{
+    return usbHidRawTxCount;
+}
+
+void usbHidRawService(void)
+{
+    uint8 count, i;
+
+    usbPoll();
+
+    if (usbHidRawControlReportReceived)
+    {
+        if (usbHidRawRxReportHandler)
+        {
+            usbHidRawRxReportHandler(usbHidRawControlReport);
+        }
+        usbHidRawControlReportReceived = 0;
+    }
+
+    if (usbDeviceState != USB_STATE_CONFIGURED)
+    {
+        // We have not reached the Configured state yet, so we should not be touching the non-zero endpoints.
+        return;
+    }
+
+    USBINDEX = HID_RAW_ENDPOINT;
+    if (usbHidRawTxCount && !(USBCSIL & USBCSIL_INPKT_RDY))
+    {
+        usbWriteFifo(HID_RAW_ENDPOINT, USB_HID_RAW_REPORT_SIZE, usbHidRawTxQueue[usbHidRawTxTail]);
+        USBCSIL |= USBCSIL_INPKT_RDY;
+        usbActivityFlag = 1;
+
+        // The setup handler might run in the USB interrupt, so do not let
+        // it see a partly copied report.
+        USB_INTERRUPT_DISABLE();
+        for (i = 0; i < USB_HID_RAW_REPORT_SIZE; i++)
+        {
+            usbHidRawTxLastReport[i] = usbHidRawTxQueue[usbHidRawTxTail][i];
+        }
+        USB_INTERRUPT_RESTORE();
+
+        if (++usbHidRawTxTail >= USB_HID_RAW_TX_QUEUE_LENGTH)
+        {
+            usbHidRawTxTail = 0;
+        }
+        usbHidRawTxCount--;
+    }
+
+    USBINDEX = HID_RAW_ENDPOINT;
+    if (USBCSOL & USBCSOL_OUTPKT_RDY)
+    {
+        count = USBCNTL;
+        if (count > USB_HID_RAW_REPORT_SIZE)
+        {
+            count = USB_HID_RAW_REPORT_SIZE;
+        }
+        usbReadFifo(HID_RAW_ENDPOINT, count, usbHidRawRxReport);
+        USBCSOL &= ~USBCSOL_OUTPKT_RDY;   // Tell the USB module we are done reading this packet, so it can receive more.
+
+        // Reports should always be full size, but clear the rest just in case.
+        while (count < USB_HID_RAW_REPORT_SIZE)
+        {
+            usbHidRawRxReport[count++] = 0;
+        }
+
+        if (usbHidRawRxReportHandler)
+        {
+            usbHidRawRxReportHandler(usbHidRawRxReport);
+        }
+    }
+}
@@ -9,21 +9,62 @@
 #include <time.h>
 
 PDATA volatile uint32 timeMs;
+PDATA volatile uint32 timeUsBase;
 
 ISR(T4, 0)
 {
     timeMs++;
-    // T4CC0 ^= 1; // If we do this, then on average the interrupts will occur precisely 1.000 ms apart.
+    timeUsBase += 1000;
+
+    // Alternate the period between 188 and 187 timer ticks so that on average the
+    // interrupts occur precisely 1.000 ms (187.5 ticks) apart.
+    T4CC0 ^= 1;
 }
 
 uint32 getMs()
 {
-    uint8 oldT4IE = T4IE;   // store state of timer 4 interrupt (active/inactive?)
     uint32 time;
-    T4IE = 0;               // disable timer 4 interrupt
-    time = timeMs;          // copy millisecond timer count into a safe variable
-    T4IE = oldT4IE;         // restore timer 4 interrupt to its original state
-    return time;            // return timer count copy
+
+    // If the T4 ISR runs while we are copying timeMs, the copy might be
+    // corrupt, so keep copying until we get the same value twice.
+    do
+    {
+        time = timeMs;
+    } while(time != timeMs);
+
+    return time;
+}
+
+uint32 getUs()
+{
+    uint32 us;
+    uint8 ticks;
+
+    do
+    {
+        us = timeUsBase;
+        ticks = T4CNT;
+    } while(us != timeUsBase);
+
+    if (T4IF)
+    {
+        // Timer 4 has overflowed but the T4 ISR has not run yet (probably because
+        // we are in an interrupt or interrupts are disabled), so timeUsBase is
+        // 1000 us behind and the tick count we read might be from before the overflow.
+        us += 1000;
+        ticks = T4CNT;
+    }
+
+    return us + TIME_TICKS_TO_US(ticks);
+}
+
+void timeAdvance(uint16 milliseconds)
+{
+    BIT savedT4IE = T4IE;
+    T4IE = 0;
+    timeMs += milliseconds;
+    timeUsBase += (uint32)milliseconds * 1000;
+    T4IE = savedT4IE;
 }
 
 void timeInit()
@@ -40,17 +81,74 @@ void timeInit()
     EA = 1; // Globally enable interrupts (IEN0.EA=1).
 }
 
+// Returns 1 if Timer 4 is running and its interrupt can run, so getUs() can
+// be used to measure delays.  Otherwise, the delay functions fall back to
+// delayMicroseconds(), which is what they need to do in places like
+// boardStartBootloader() where interrupts are disabled.
+static BIT timeDelayUseTimer()
+{
+    return EA && T4IE && (T4CTL & 0x10);
+}
+
+// Waits until the getUs() deadline has passed or Timer 4 has counted the
+// specified number of ticks, whichever comes first.  In an interrupt the T4
+// ISR can not run, so getUs() goes backwards when T4CNT wraps a second time
+// and the deadline might never pass; counting the ticks here ends the delay
+// anyway.  A wrap is only missed if this loop is held off for a whole Timer 4
+// period, which can only make the delay longer.
+static void timeDelayWait(uint32 deadline, uint32 ticks)
+{
+    uint32 elapsed = 0;
+    uint8 last = T4CNT;
+    uint8 now;
+
+    while(!timeUsPassed(deadline) && elapsed < ticks)
+    {
+        now = T4CNT;
+        if (now >= last)
+        {
+            elapsed += (uint8)(now - last);
+        }
+        else
+        {
+            // T4CNT counted up to T4CC0 and wrapped to 0.
+            elapsed += (uint16)T4CC0 + 1 - last + now;
+        }
+        last = now;
+    }
+}
+
+void delayUs(uint16 microseconds)
+{
+    if (microseconds < DELAY_US_TIMER_THRESHOLD || !timeDelayUseTimer())
+    {
+        while(microseconds > 255)
+        {
+            delayMicroseconds(250);
+            microseconds -= 250;
+        }
+        delayMicroseconds(microseconds);
+        return;
+    }
+
+    // There are 3/16 Timer 4 ticks per microsecond; round up.
+    timeDelayWait(getUs() + microseconds, ((uint32)microseconds * 3 + 15) >> 4);
+}
+
 void delayMs(uint16 milliseconds)
 {
-    // TODO: make this more accurate.
-    // A great way would be to use the compare feature of Timer 4 and then
-    // wait for the right number of compare events to happen, but then we
-    // can't use that channel for PWM in the future.
-    while(milliseconds--)
+    if (!timeDelayUseTimer())
     {
-        delayMicroseconds(250);
-        delayMicroseconds(250);
-        delayMicroseconds(250);
-        delayMicroseconds(249); // there's some overhead, so only delay by 249 here
+        while(milliseconds--)
+        {
+            delayMicroseconds(250);
+            delayMicroseconds(250);
+            delayMicroseconds(250);
+            delayMicroseconds(249); // there's some overhead, so only delay by 249 here
+        }
+        return;
     }
+
+    // There are 187.5 Timer 4 ticks per millisecond; round up.
+    timeDelayWait(getUs() + (uint32)milliseconds * 1000, ((uint32)milliseconds * 375 + 1) >> 1);
 }